@@ -0,0 +1,192 @@
+#include "celltreecache.h"
+
+#include <vistle/core/indexed.h>
+#include <vistle/core/unstr.h>
+#include <vistle/core/structuredgrid.h>
+#include <vistle/core/layergrid.h>
+
+#include <cstring>
+
+namespace vistle {
+
+namespace {
+
+// four independent lanes of multiply-xorshift, so that hashing is memory bound
+class Hasher {
+public:
+    void add(const void *data, size_t size)
+    {
+        const char *p = static_cast<const char *>(data);
+        const size_t numBlocks = size / sizeof(m_lane);
+        for (size_t b = 0; b < numBlocks; ++b) {
+            uint64_t w[NumLanes];
+            memcpy(w, p + b * sizeof(m_lane), sizeof(m_lane));
+            for (int l = 0; l < NumLanes; ++l)
+                m_lane[l] = mix(m_lane[l] ^ w[l]);
+        }
+        uint64_t tail[NumLanes] = {};
+        if (size > numBlocks * sizeof(m_lane))
+            memcpy(tail, p + numBlocks * sizeof(m_lane), size - numBlocks * sizeof(m_lane));
+        for (int l = 0; l < NumLanes; ++l)
+            m_lane[l] = mix(m_lane[l] ^ tail[l]);
+        m_lane[0] = mix(m_lane[0] ^ size);
+    }
+
+    template<typename T>
+    void add(const T *data, size_t count)
+    {
+        add(static_cast<const void *>(data), count * sizeof(T));
+    }
+
+    uint64_t result() const
+    {
+        uint64_t h = 0;
+        for (int l = 0; l < NumLanes; ++l)
+            h = mix(h ^ m_lane[l]);
+        return h;
+    }
+
+private:
+    static const int NumLanes = 4;
+    static uint64_t mix(uint64_t h)
+    {
+        h *= 0x9e3779b97f4a7c15ull;
+        return h ^ (h >> 29);
+    }
+
+    uint64_t m_lane[NumLanes] = {0x243f6a8885a308d3ull, 0x13198a2e03707344ull, 0xa4093822299f31d0ull,
+                                 0x082efa98ec4e6c89ull};
+};
+
+} // namespace
+
+uint64_t geometryHash(Object::const_ptr grid)
+{
+    Hasher h;
+    if (auto idx = Indexed::as(grid)) {
+        const Index nelem = idx->getNumElements();
+        if (nelem > 0)
+            h.add(idx->el(), nelem + 1);
+        h.add(idx->cl(), idx->getNumCorners());
+        const Index nvert = idx->getNumCoords();
+        h.add(idx->x(), nvert);
+        h.add(idx->y(), nvert);
+        h.add(idx->z(), nvert);
+    } else if (auto str = StructuredGrid::as(grid)) {
+        Index dims[3];
+        for (int c = 0; c < 3; ++c)
+            dims[c] = str->getNumDivisions(c);
+        h.add(dims, 3);
+        const Index nvert = str->getNumCoords();
+        h.add(str->x(), nvert);
+        h.add(str->y(), nvert);
+        h.add(str->z(), nvert);
+    } else if (auto lg = LayerGrid::as(grid)) {
+        Index dims[3];
+        for (int c = 0; c < 3; ++c)
+            dims[c] = lg->getNumDivisions(c);
+        h.add(dims, 3);
+        h.add(lg->min(), 3);
+        h.add(lg->max(), 3);
+        h.add(lg->z(), lg->getNumVertices());
+    }
+    return h.result();
+}
+
+uint64_t topologyHash(Object::const_ptr grid)
+{
+    Hasher h;
+    if (auto idx = Indexed::as(grid)) {
+        const Index nelem = idx->getNumElements();
+        if (nelem > 0)
+            h.add(idx->el(), nelem + 1);
+        h.add(idx->cl(), idx->getNumCorners());
+        if (auto unstr = UnstructuredGrid::as(grid))
+            h.add(unstr->tl(), nelem);
+        const Index nvert = idx->getNumCoords();
+        h.add(&nvert, 1);
+    } else if (auto geo = grid->getInterface<GeometryInterface>()) {
+        const Index nvert = geo->getNumVertices();
+        h.add(&nvert, 1);
+    }
+    return h.result();
+}
+
+Celltree3::const_ptr CelltreeCache::getCelltree(Object::const_ptr grid)
+{
+    auto cti = grid ? grid->getInterface<CelltreeInterface<3>>() : nullptr;
+    if (!cti)
+        return Celltree3::const_ptr();
+
+    std::unique_lock<std::mutex> guard(m_mutex);
+    auto kit = m_keys.find(grid->getName());
+    bool haveKey = kit != m_keys.end();
+    Key key = haveKey ? kit->second : Key();
+    guard.unlock();
+    if (!haveKey) {
+        auto elem = grid->getInterface<ElementInterface>();
+        auto geo = grid->getInterface<GeometryInterface>();
+        key = Key(grid->getType(), elem ? elem->getNumElements() : 0, geo ? geo->getNumVertices() : 0,
+                  geometryHash(grid));
+    }
+
+    guard.lock();
+    m_keys[grid->getName()] = key;
+    auto it = m_cache.find(key);
+    if (it != m_cache.end()) {
+        it->second.used = true;
+        auto cached = it->second.celltree;
+        guard.unlock();
+        {
+            // same lock as getCelltree(), so that a concurrent build does not race with attaching
+            Object::Data::attachment_mutex_lock_type lock(grid->d()->attachment_mutex);
+            if (!cti->hasCelltree())
+                grid->addAttachment("celltree", cached);
+        }
+        return cti->getCelltree();
+    }
+    guard.unlock();
+
+    auto ct = cti->getCelltree();
+
+    guard.lock();
+    auto &ent = m_cache[key];
+    ent.celltree = ct;
+    ent.used = true;
+    return ct;
+}
+
+void CelltreeCache::prune()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        if (it->second.used) {
+            it->second.used = false;
+            ++it;
+        } else {
+            it = m_cache.erase(it);
+        }
+    }
+    for (auto it = m_keys.begin(); it != m_keys.end();) {
+        if (m_cache.find(it->second) == m_cache.end()) {
+            it = m_keys.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CelltreeCache::clear()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_cache.clear();
+    m_keys.clear();
+}
+
+size_t CelltreeCache::size() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_cache.size();
+}
+
+} // namespace vistle
@@ -0,0 +1,45 @@
+#ifndef VISTLE_ALG_CELLTREECACHE_H
+#define VISTLE_ALG_CELLTREECACHE_H
+
+#include "export.h"
+#include <vistle/core/object.h>
+#include <vistle/core/celltree.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+namespace vistle {
+
+//! hash of all data determining the bounds of a grid's cells: coordinates and connectivity
+V_ALGEXPORT uint64_t geometryHash(Object::const_ptr grid);
+//! hash of a grid's connectivity only: cell types, element and corner lists
+V_ALGEXPORT uint64_t topologyHash(Object::const_ptr grid);
+
+//! keep celltrees alive across executions and attach them to grids with identical geometry
+class V_ALGEXPORT CelltreeCache {
+public:
+    //! return celltree for grid, reusing a celltree built for identical geometry if available
+    Celltree3::const_ptr getCelltree(Object::const_ptr grid);
+    //! forget celltrees that have not been requested since the previous call
+    void prune();
+    void clear();
+    size_t size() const;
+
+private:
+    typedef std::tuple<int, Index, Index, uint64_t> Key; //< object type, number of elements and vertices, hash
+    struct Entry {
+        Celltree3::const_ptr celltree;
+        bool used = true;
+    };
+
+    mutable std::mutex m_mutex;
+    std::map<Key, Entry> m_cache;
+    std::map<std::string, Key> m_keys; //< avoid hashing the same object again
+
+};
+
+} // namespace vistle
+#endif
@@ -0,0 +1,503 @@
+#include "halo.h"
+#include "celltreecache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+
+namespace vistle {
+
+namespace {
+
+//! boundary vertex, sent to the rank responsible for its position
+struct VertexRecord {
+    uint64_t key;
+    Scalar p[3];
+    int rank;
+    Index block, vertex;
+};
+
+//! vertex of a local block, found at the same position in another block
+struct ShareRecord {
+    Index block, vertex;
+    int peerRank;
+    Index peerBlock;
+};
+
+uint64_t positionKey(const Scalar *p)
+{
+    uint64_t h = 0x243f6a8885a308d3ull;
+    for (int c = 0; c < 3; ++c) {
+        Scalar s = p[c];
+        if (s == 0)
+            s = 0; // treat -0 and +0 alike
+        std::conditional<sizeof(Scalar) == 8, uint64_t, uint32_t>::type bits;
+        memcpy(&bits, &s, sizeof(bits));
+        h = (h ^ bits) * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+//! send a variable number of trivially copyable records to every rank
+template<typename T>
+std::vector<T> allToAll(MPI_Comm comm, const std::vector<std::vector<T>> &send)
+{
+    int size = 0;
+    MPI_Comm_size(comm, &size);
+    assert(send.size() == size_t(size));
+
+    std::vector<int> scount(size), sdispl(size), rcount(size), rdispl(size);
+    std::vector<T> sbuf;
+    for (int r = 0; r < size; ++r) {
+        sdispl[r] = sbuf.size() * sizeof(T);
+        scount[r] = send[r].size() * sizeof(T);
+        std::copy(send[r].begin(), send[r].end(), std::back_inserter(sbuf));
+    }
+    MPI_Alltoall(scount.data(), 1, MPI_INT, rcount.data(), 1, MPI_INT, comm);
+    size_t total = 0;
+    for (int r = 0; r < size; ++r) {
+        rdispl[r] = total;
+        total += rcount[r];
+    }
+    std::vector<T> result(total / sizeof(T));
+    MPI_Alltoallv(sbuf.data(), scount.data(), sdispl.data(), MPI_BYTE, result.data(), rcount.data(), rdispl.data(),
+                  MPI_BYTE, comm);
+    return result;
+}
+
+//! exchange byte buffers with all neighbors of a distributed graph communicator
+std::vector<std::vector<char>> neighborAllToAll(MPI_Comm comm, const std::vector<std::vector<char>> &send)
+{
+    const int n = send.size();
+    std::vector<int> scount(n), sdispl(n), rcount(n), rdispl(n);
+    std::vector<char> sbuf;
+    for (int i = 0; i < n; ++i) {
+        sdispl[i] = sbuf.size();
+        scount[i] = send[i].size();
+        sbuf.insert(sbuf.end(), send[i].begin(), send[i].end());
+    }
+    MPI_Neighbor_alltoall(scount.data(), 1, MPI_INT, rcount.data(), 1, MPI_INT, comm);
+    size_t total = 0;
+    for (int i = 0; i < n; ++i) {
+        rdispl[i] = total;
+        total += rcount[i];
+    }
+    std::vector<char> rbuf(total);
+    MPI_Neighbor_alltoallv(sbuf.data(), scount.data(), sdispl.data(), MPI_BYTE, rbuf.data(), rcount.data(),
+                           rdispl.data(), MPI_BYTE, comm);
+
+    std::vector<std::vector<char>> result(n);
+    for (int i = 0; i < n; ++i)
+        result[i].assign(rbuf.begin() + rdispl[i], rbuf.begin() + rdispl[i] + rcount[i]);
+    return result;
+}
+
+template<typename T>
+void pack(std::vector<char> &buf, const T &value)
+{
+    const char *p = reinterpret_cast<const char *>(&value);
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+template<typename T>
+T unpack(const char *&p)
+{
+    T value;
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+//! call func(elem, numVerts, verts) for all faces of 3D cells not shared with another cell of the grid
+template<class Func>
+void forEachBoundaryFace(UnstructuredGrid::const_ptr grid, Func func)
+{
+    const Index numElem = grid->getNumElements();
+    const Index *el = grid->el();
+    const Index *cl = grid->cl();
+    const Byte *tl = grid->tl();
+    const auto &nf = grid->getNeighborFinder();
+
+    Index verts[UnstructuredGrid::MaxNumVertices];
+    for (Index e = 0; e < numElem; ++e) {
+        const Byte t = tl[e] & UnstructuredGrid::TYPE_MASK;
+        if (t == UnstructuredGrid::POLYHEDRON) {
+            Index facestart = InvalidIndex;
+            Index term = 0;
+            for (Index j = el[e]; j < el[e + 1]; ++j) {
+                if (facestart == InvalidIndex) {
+                    facestart = j;
+                    term = cl[j];
+                } else if (cl[j] == term) {
+                    const Index numVert = j - facestart;
+                    const Index *face = &cl[facestart];
+                    if (numVert >= 3 && nf.getNeighborElement(e, face[0], face[1], face[2]) == InvalidIndex)
+                        func(e, numVert, face);
+                    facestart = InvalidIndex;
+                }
+            }
+        } else if (UnstructuredGrid::Dimensionality[t] == 3) {
+            const Index *cell = &cl[el[e]];
+            for (int f = 0; f < UnstructuredGrid::NumFaces[t]; ++f) {
+                const auto &face = UnstructuredGrid::FaceVertices[t][f];
+                const Index numVert = UnstructuredGrid::FaceSizes[t][f];
+                for (Index i = 0; i < numVert; ++i)
+                    verts[i] = cell[face[i]];
+                if (nf.getNeighborElement(e, verts[0], verts[1], verts[2]) == InvalidIndex)
+                    func(e, numVert, verts);
+            }
+        }
+    }
+}
+
+std::vector<Index> boundaryVertices(UnstructuredGrid::const_ptr grid)
+{
+    std::vector<char> boundary(grid->getNumCoords(), 0);
+    forEachBoundaryFace(grid, [&boundary](Index, Index numVert, const Index *verts) {
+        for (Index i = 0; i < numVert; ++i)
+            boundary[verts[i]] = 1;
+    });
+
+    std::vector<Index> result;
+    for (Index v = 0; v < boundary.size(); ++v) {
+        if (boundary[v])
+            result.push_back(v);
+    }
+    return result;
+}
+
+} // namespace
+
+HaloPlan::HaloPlan(const boost::mpi::communicator &comm, const std::vector<UnstructuredGrid::const_ptr> &blocks)
+{
+    MPI_Comm mpiComm = comm;
+    const int rank = comm.rank(), size = comm.size();
+
+    m_blocks.resize(blocks.size());
+    std::vector<std::vector<Index>> boundary(blocks.size());
+    std::vector<std::vector<VertexRecord>> toOwner(size);
+    for (Index b = 0; b < blocks.size(); ++b) {
+        const auto &grid = blocks[b];
+        auto &block = m_blocks[b];
+        block.number = grid->getBlock();
+        block.topology = topologyHash(grid);
+        block.numCells = grid->getNumElements();
+        block.numCorners = grid->getNumCorners();
+        block.numVertices = grid->getNumCoords();
+
+        boundary[b] = boundaryVertices(grid);
+        const Scalar *x = grid->x(), *y = grid->y(), *z = grid->z();
+        for (auto v: boundary[b]) {
+            VertexRecord rec;
+            rec.p[0] = x[v];
+            rec.p[1] = y[v];
+            rec.p[2] = z[v];
+            rec.key = positionKey(rec.p);
+            rec.rank = rank;
+            rec.block = b;
+            rec.vertex = v;
+            toOwner[rec.key % size].push_back(rec);
+        }
+    }
+
+    // match boundary vertices on the rank responsible for their position
+    auto owned = allToAll(mpiComm, toOwner);
+    toOwner.clear();
+    auto position = [](const VertexRecord &r) { return std::make_tuple(r.key, r.p[0], r.p[1], r.p[2]); };
+    std::sort(owned.begin(), owned.end(), [position](const VertexRecord &a, const VertexRecord &b) {
+        return std::make_tuple(position(a), a.rank, a.block, a.vertex) <
+               std::make_tuple(position(b), b.rank, b.block, b.vertex);
+    });
+    std::vector<std::vector<ShareRecord>> toBlock(size);
+    for (size_t begin = 0; begin < owned.size();) {
+        size_t end = begin + 1;
+        while (end < owned.size() && position(owned[end]) == position(owned[begin]))
+            ++end;
+        for (size_t m = begin; m < end; ++m) {
+            const auto &mine = owned[m];
+            for (size_t o = begin; o < end; ++o) {
+                const auto &other = owned[o];
+                if (other.rank == mine.rank && other.block == mine.block)
+                    continue;
+                toBlock[mine.rank].push_back(ShareRecord{mine.block, mine.vertex, other.rank, other.block});
+            }
+        }
+        begin = end;
+    }
+    owned.clear();
+    auto shared = allToAll(mpiComm, toBlock);
+    toBlock.clear();
+
+    // send all non-ghost cells containing a shared vertex
+    std::map<std::tuple<int, Index, Index>, std::vector<Index>> sendCells; // peer rank, peer block, block -> cells
+    for (const auto &rec: shared) {
+        const auto &grid = blocks[rec.block];
+        auto vol = grid->getVertexOwnerList();
+        const Index *vl = vol->vertexList(), *cells = vol->cellList();
+        const Byte *tl = grid->tl();
+        auto &sc = sendCells[std::make_tuple(rec.peerRank, rec.peerBlock, rec.block)];
+        for (Index i = vl[rec.vertex]; i < vl[rec.vertex + 1]; ++i) {
+            if (!(tl[cells[i]] & UnstructuredGrid::GHOST_BIT))
+                sc.push_back(cells[i]);
+        }
+    }
+    shared.clear();
+
+    // relation is symmetric: ranks receive from all ranks they send to
+    for (const auto &sc: sendCells)
+        m_neighbors.push_back(std::get<0>(sc.first));
+    m_neighbors.erase(std::unique(m_neighbors.begin(), m_neighbors.end()), m_neighbors.end());
+    const int numNeighbors = m_neighbors.size();
+    MPI_Dist_graph_create_adjacent(mpiComm, numNeighbors, m_neighbors.data(), MPI_UNWEIGHTED, numNeighbors,
+                                   m_neighbors.data(), MPI_UNWEIGHTED, MPI_INFO_NULL, 0, &m_neighborComm);
+
+    m_send.resize(numNeighbors);
+    m_recv.resize(numNeighbors);
+    std::vector<std::vector<char>> sendBuf(numNeighbors);
+    for (auto &sc: sendCells) {
+        const int n = std::lower_bound(m_neighbors.begin(), m_neighbors.end(), std::get<0>(sc.first)) -
+                      m_neighbors.begin();
+        auto &cells = sc.second;
+        std::sort(cells.begin(), cells.end());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+        m_send[n].emplace_back();
+        auto &link = m_send[n].back();
+        link.block = std::get<2>(sc.first);
+        link.peerBlock = std::get<1>(sc.first);
+        link.numCells = cells.size();
+        link.cells = std::move(cells);
+
+        const auto &grid = blocks[link.block];
+        const Index *el = grid->el(), *cl = grid->cl();
+        const Byte *tl = grid->tl();
+        for (auto c: link.cells)
+            link.vertices.insert(link.vertices.end(), &cl[el[c]], &cl[el[c + 1]]);
+        std::sort(link.vertices.begin(), link.vertices.end());
+        link.vertices.erase(std::unique(link.vertices.begin(), link.vertices.end()), link.vertices.end());
+
+        auto &buf = sendBuf[n];
+        pack(buf, link.peerBlock);
+        pack(buf, link.block);
+        pack(buf, link.numCells);
+        pack(buf, Index(link.vertices.size()));
+        for (auto c: link.cells) {
+            pack(buf, tl[c]);
+            pack(buf, el[c + 1] - el[c]);
+            for (Index i = el[c]; i < el[c + 1]; ++i) {
+                Index lv = std::lower_bound(link.vertices.begin(), link.vertices.end(), cl[i]) - link.vertices.begin();
+                pack(buf, lv);
+            }
+        }
+        const Scalar *x = grid->x(), *y = grid->y(), *z = grid->z();
+        for (auto v: link.vertices) {
+            pack(buf, x[v]);
+            pack(buf, y[v]);
+            pack(buf, z[v]);
+        }
+    }
+    sendCells.clear();
+
+    auto recvBuf = neighborAllToAll(m_neighborComm, sendBuf);
+    sendBuf.clear();
+
+    // append received cells, vertices at positions already present in a block are not duplicated
+    std::vector<std::unordered_multimap<uint64_t, Index>> present(blocks.size());
+    std::vector<std::vector<Scalar>> ghostCoords(blocks.size());
+    for (Index b = 0; b < blocks.size(); ++b) {
+        const Scalar *x = blocks[b]->x(), *y = blocks[b]->y(), *z = blocks[b]->z();
+        for (auto v: boundary[b]) {
+            Scalar p[3] = {x[v], y[v], z[v]};
+            present[b].emplace(positionKey(p), v);
+        }
+    }
+    for (int n = 0; n < numNeighbors; ++n) {
+        const char *p = recvBuf[n].data(), *end = p + recvBuf[n].size();
+        while (p < end) {
+            m_recv[n].emplace_back();
+            auto &link = m_recv[n].back();
+            link.block = unpack<Index>(p);
+            link.peerBlock = unpack<Index>(p);
+            link.numCells = unpack<Index>(p);
+            const Index numVert = unpack<Index>(p);
+            assert(link.block < m_blocks.size());
+            auto &block = m_blocks[link.block];
+            const auto &grid = blocks[link.block];
+            const Scalar *x = grid->x(), *y = grid->y(), *z = grid->z();
+            auto &gc = ghostCoords[link.block];
+
+            const char *cells = p;
+            for (Index c = 0; c < link.numCells; ++c) {
+                unpack<Byte>(p);
+                p += unpack<Index>(p) * sizeof(Index);
+            }
+
+            std::vector<Index> vertex(numVert);
+            link.vertexTarget.resize(numVert, InvalidIndex);
+            for (Index v = 0; v < numVert; ++v) {
+                Scalar pos[3];
+                for (int c = 0; c < 3; ++c)
+                    pos[c] = unpack<Scalar>(p);
+                const uint64_t key = positionKey(pos);
+                vertex[v] = InvalidIndex;
+                auto range = present[link.block].equal_range(key);
+                for (auto it = range.first; it != range.second; ++it) {
+                    const Index u = it->second;
+                    const bool same = u < block.numVertices
+                                          ? x[u] == pos[0] && y[u] == pos[1] && z[u] == pos[2]
+                                          : std::equal(pos, pos + 3, &gc[3 * (u - block.numVertices)]);
+                    if (same) {
+                        vertex[v] = u;
+                        break;
+                    }
+                }
+                if (vertex[v] == InvalidIndex) {
+                    vertex[v] = block.numVertices + block.numGhostVertices;
+                    ++block.numGhostVertices;
+                    gc.insert(gc.end(), pos, pos + 3);
+                    present[link.block].emplace(key, vertex[v]);
+                    link.vertexTarget[v] = vertex[v];
+                }
+            }
+
+            link.cellOffset = block.numCells + block.ghostTl.size();
+            for (Index c = 0; c < link.numCells; ++c) {
+                block.ghostTl.push_back(unpack<Byte>(cells) | UnstructuredGrid::GHOST_BIT);
+                const Index numCorners = unpack<Index>(cells);
+                for (Index i = 0; i < numCorners; ++i)
+                    block.ghostCl.push_back(vertex[unpack<Index>(cells)]);
+                block.ghostEl.push_back(block.ghostCl.size());
+            }
+        }
+    }
+}
+
+HaloPlan::~HaloPlan()
+{
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (!finalized && m_neighborComm != MPI_COMM_NULL)
+        MPI_Comm_free(&m_neighborComm);
+}
+
+bool HaloPlan::matches(const std::vector<UnstructuredGrid::const_ptr> &blocks) const
+{
+    if (blocks.size() != m_blocks.size())
+        return false;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (blocks[b]->getBlock() != m_blocks[b].number)
+            return false;
+        if (blocks[b]->getNumElements() != m_blocks[b].numCells)
+            return false;
+        if (blocks[b]->getNumCorners() != m_blocks[b].numCorners)
+            return false;
+        if (blocks[b]->getNumCoords() != m_blocks[b].numVertices)
+            return false;
+        if (topologyHash(blocks[b]) != m_blocks[b].topology)
+            return false;
+    }
+    return true;
+}
+
+size_t HaloPlan::numBlocks() const
+{
+    return m_blocks.size();
+}
+
+Index HaloPlan::numGhostCells(size_t block) const
+{
+    return m_blocks[block].ghostTl.size();
+}
+
+Index HaloPlan::numGhostVertices(size_t block) const
+{
+    return m_blocks[block].numGhostVertices;
+}
+
+std::vector<UnstructuredGrid::ptr> HaloPlan::createGrids(const std::vector<UnstructuredGrid::const_ptr> &blocks) const
+{
+    assert(blocks.size() == m_blocks.size());
+    std::vector<UnstructuredGrid::ptr> result;
+    std::vector<const Scalar *> in;
+    std::vector<Scalar *> out;
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const auto &grid = blocks[b];
+        const auto &block = m_blocks[b];
+        UnstructuredGrid::ptr ghosted(new UnstructuredGrid(block.numCells + block.ghostTl.size(),
+                                                           block.numCorners + block.ghostCl.size(),
+                                                           block.numVertices + block.numGhostVertices));
+
+        Index *el = ghosted->el().data();
+        std::copy(grid->el(), grid->el() + block.numCells + 1, el);
+        std::transform(block.ghostEl.begin(), block.ghostEl.end(), el + block.numCells + 1,
+                       [&block](Index end) { return end + block.numCorners; });
+        Index *cl = ghosted->cl().data();
+        std::copy(grid->cl(), grid->cl() + block.numCorners, cl);
+        std::copy(block.ghostCl.begin(), block.ghostCl.end(), cl + block.numCorners);
+        Byte *tl = ghosted->tl().data();
+        std::copy(grid->tl(), grid->tl() + block.numCells, tl);
+        std::copy(block.ghostTl.begin(), block.ghostTl.end(), tl + block.numCells);
+
+        for (int c = 0; c < 3; ++c) {
+            std::copy(&grid->x(c)[0], &grid->x(c)[0] + block.numVertices, ghosted->x(c).data());
+            in.push_back(&grid->x(c)[0]);
+            out.push_back(ghosted->x(c).data());
+        }
+        result.push_back(ghosted);
+    }
+    exchange(in, out, false);
+
+    return result;
+}
+
+void HaloPlan::exchangeBytes(const std::vector<const char *> &in, const std::vector<char *> &out, size_t size,
+                             bool perElement) const
+{
+    const size_t numComponents = m_blocks.empty() ? 0 : in.size() / m_blocks.size();
+    assert(in.size() == numComponents * m_blocks.size());
+    assert(out.size() == in.size());
+
+    const int numNeighbors = m_neighbors.size();
+    std::vector<std::vector<char>> sendBuf(numNeighbors);
+    for (int n = 0; n < numNeighbors; ++n) {
+        auto &buf = sendBuf[n];
+        for (const auto &link: m_send[n]) {
+            const auto &items = perElement ? link.cells : link.vertices;
+            for (size_t c = 0; c < numComponents; ++c) {
+                const char *src = in[link.block * numComponents + c];
+                for (auto i: items)
+                    buf.insert(buf.end(), src + i * size, src + (i + 1) * size);
+            }
+        }
+    }
+
+    auto recvBuf = neighborAllToAll(m_neighborComm, sendBuf);
+    sendBuf.clear();
+
+    for (int n = 0; n < numNeighbors; ++n) {
+        const char *p = recvBuf[n].data();
+        for (const auto &link: m_recv[n]) {
+            for (size_t c = 0; c < numComponents; ++c) {
+                char *dst = out[link.block * numComponents + c];
+                if (perElement) {
+                    memcpy(dst + link.cellOffset * size, p, link.numCells * size);
+                    p += link.numCells * size;
+                } else {
+                    for (auto target: link.vertexTarget) {
+                        if (target != InvalidIndex)
+                            memcpy(dst + target * size, p, size);
+                        p += size;
+                    }
+                }
+            }
+        }
+        assert(p == recvBuf[n].data() + recvBuf[n].size());
+    }
+}
+
+} // namespace vistle
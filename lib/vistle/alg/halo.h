@@ -0,0 +1,90 @@
+#ifndef VISTLE_ALG_HALO_H
+#define VISTLE_ALG_HALO_H
+
+#include "export.h"
+#include <vistle/core/unstr.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <mpi.h>
+#include <boost/mpi/communicator.hpp>
+
+namespace vistle {
+
+//! plan for exchanging a layer of ghost cells between unstructured grid blocks distributed across ranks
+/*! Blocks are neighbors if they share vertices at identical positions, and a block receives all cells of its
+ *  neighbors containing one of the shared vertices.
+ *  Shared vertices are found by hashing the positions of block boundary vertices to ranks,
+ *  cells are transferred with MPI neighborhood collectives.
+ *  A plan only depends on the connectivity of the blocks, so it can be reused for later timesteps:
+ *  those only have to exchange coordinates and data fields. */
+class V_ALGEXPORT HaloPlan {
+public:
+    //! collective: determine the cells to be exchanged among the blocks of all ranks
+    HaloPlan(const boost::mpi::communicator &comm, const std::vector<UnstructuredGrid::const_ptr> &blocks);
+    ~HaloPlan();
+    HaloPlan(const HaloPlan &) = delete;
+    HaloPlan &operator=(const HaloPlan &) = delete;
+
+    //! whether blocks have the same block numbers and connectivity as the blocks the plan was created for
+    bool matches(const std::vector<UnstructuredGrid::const_ptr> &blocks) const;
+
+    size_t numBlocks() const;
+    Index numGhostCells(size_t block) const;
+    Index numGhostVertices(size_t block) const;
+
+    //! collective: create copies of blocks extended by ghost cells, which are marked with GHOST_BIT
+    std::vector<UnstructuredGrid::ptr> createGrids(const std::vector<UnstructuredGrid::const_ptr> &blocks) const;
+
+    //! collective: fill in values for ghost vertices (or ghost cells, if perElement)
+    /*! in and out hold the same number of component arrays for each block, one block after the other;
+     *  out has to provide space for original and ghost entities, values of original entities are not touched */
+    template<typename T>
+    void exchange(const std::vector<const T *> &in, const std::vector<T *> &out, bool perElement) const;
+
+private:
+    void exchangeBytes(const std::vector<const char *> &in, const std::vector<char *> &out, size_t size,
+                       bool perElement) const;
+
+    //! cells of a block sent to or received from a block of a neighbor rank
+    struct Link {
+        Index block = InvalidIndex; //< local block
+        Index peerBlock = InvalidIndex; //< block on neighbor rank
+        Index numCells = 0;
+        std::vector<Index> cells; //< sender: cells to transmit
+        std::vector<Index> vertices; //< sender: vertices of these cells
+        Index cellOffset = 0; //< receiver: where to store cells
+        std::vector<Index> vertexTarget; //< receiver: where to store each vertex, InvalidIndex if already present
+    };
+
+    struct Block {
+        int number = -1; //< block number from object meta data
+        uint64_t topology = 0;
+        Index numCells = 0, numCorners = 0, numVertices = 0;
+        Index numGhostVertices = 0;
+        std::vector<Index> ghostEl; //< end of each ghost cell in ghostCl
+        std::vector<Index> ghostCl;
+        std::vector<Byte> ghostTl;
+    };
+
+    MPI_Comm m_neighborComm = MPI_COMM_NULL;
+    std::vector<int> m_neighbors; //< ranks exchanging cells with this rank, including this rank itself
+    std::vector<std::vector<Link>> m_send, m_recv; //< per neighbor
+    std::vector<Block> m_blocks;
+};
+
+template<typename T>
+void HaloPlan::exchange(const std::vector<const T *> &in, const std::vector<T *> &out, bool perElement) const
+{
+    std::vector<const char *> bin;
+    std::vector<char *> bout;
+    for (auto p: in)
+        bin.push_back(reinterpret_cast<const char *>(p));
+    for (auto p: out)
+        bout.push_back(reinterpret_cast<char *>(p));
+    exchangeBytes(bin, bout, sizeof(T), perElement);
+}
+
+} // namespace vistle
+#endif
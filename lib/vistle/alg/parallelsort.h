@@ -0,0 +1,42 @@
+#ifndef VISTLE_ALG_PARALLELSORT_H
+#define VISTLE_ALG_PARALLELSORT_H
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <vistle/util/ssize_t.h>
+
+namespace vistle {
+
+//! sort v with several threads: chunks of at least minChunkSize items are sorted independently and then merged pairwise
+template<class T, class Compare>
+void parallelSort(std::vector<T> &v, Compare comp, size_t minChunkSize = 65536)
+{
+    size_t numChunks = 1;
+    while (numChunks < 256 && numChunks * 2 * minChunkSize <= v.size())
+        numChunks *= 2;
+    std::vector<size_t> bounds(numChunks + 1);
+    for (size_t c = 0; c <= numChunks; ++c)
+        bounds[c] = v.size() * c / numChunks;
+
+#pragma omp parallel for schedule(dynamic)
+    for (ssize_t c = 0; c < ssize_t(numChunks); ++c)
+        std::sort(v.begin() + bounds[c], v.begin() + bounds[c + 1], comp);
+
+    for (size_t width = 1; width < numChunks; width *= 2) {
+#pragma omp parallel for schedule(dynamic)
+        for (ssize_t c = 0; c < ssize_t(numChunks); c += 2 * width)
+            std::inplace_merge(v.begin() + bounds[c], v.begin() + bounds[c + width], v.begin() + bounds[c + 2 * width],
+                               comp);
+    }
+}
+
+template<class T>
+void parallelSort(std::vector<T> &v)
+{
+    parallelSort(v, std::less<T>());
+}
+
+} // namespace vistle
+#endif
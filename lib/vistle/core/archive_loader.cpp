@@ -210,4 +210,78 @@ std::shared_ptr<ArrayLoader::ArrayOwner> ArrayLoader::owner() const
     return m_unreffer;
 }
 
+namespace {
+
+struct RawArrayCreator {
+    //! only checks for existence if create is null
+    RawArrayCreator(const RawArrayDirectoryEntry &ent, RawArrayDirectoryEntry *create): m_ent(ent), m_create(create)
+    {}
+
+    template<typename T>
+    void operator()(T)
+    {
+        if (shm_array<T, typename shm<T>::array_allocator>::typeId() != m_ent.type)
+            return;
+
+        m_ok = true;
+        if (Shm::the().getArrayFromName<T>(m_ent.name))
+            return;
+        m_missing = true;
+        if (!m_create)
+            return;
+
+        if (m_ent.size != m_ent.elements * sizeof(T)) {
+            std::cerr << "RawArrayCreator: size mismatch for data array " << m_ent.name << std::endl;
+            m_ok = false;
+            return;
+        }
+        ShmVector<T> arr((shm_name_t)m_ent.name);
+        if (!arr.valid())
+            arr.construct();
+        arr->resize(m_ent.elements);
+        m_create->data = reinterpret_cast<char *>(arr->data());
+        m_create->owner = std::make_shared<ShmVector<T>>(arr);
+    }
+
+    bool m_ok = false;
+    bool m_missing = false;
+    const RawArrayDirectoryEntry &m_ent;
+    RawArrayDirectoryEntry *m_create = nullptr;
+};
+
+} // namespace
+
+std::vector<char> missingRawArrays(const RawArrayDirectory &dir)
+{
+    std::vector<char> missing(dir.size(), 0);
+    for (size_t i = 0; i < dir.size(); ++i) {
+        RawArrayCreator checker(dir[i], nullptr);
+        boost::mpl::for_each<VectorTypes>(boost::reference_wrapper<RawArrayCreator>(checker));
+        missing[i] = checker.m_missing;
+    }
+    return missing;
+}
+
+bool createRawArray(RawArrayDirectoryEntry &ent)
+{
+    ent.data = nullptr;
+    RawArrayCreator creator(ent, &ent);
+    boost::mpl::for_each<VectorTypes>(boost::reference_wrapper<RawArrayCreator>(creator));
+    if (!creator.m_ok || !creator.m_missing) {
+        std::cerr << "createRawArray: failed to create array " << ent.name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<char> prepareRawArrays(RawArrayDirectory &dir)
+{
+    auto missing = missingRawArrays(dir);
+    for (size_t i = 0; i < dir.size(); ++i) {
+        if (missing[i] && !createRawArray(dir[i]))
+            missing[i] = false;
+    }
+    return missing;
+}
+
 } // namespace vistle
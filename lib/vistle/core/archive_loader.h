@@ -12,6 +12,7 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace vistle {
 
@@ -35,7 +36,7 @@ struct V_COREEXPORT ArrayLoader {
     template<typename T>
     void operator()(T)
     {
-        if (shm_array<T, typename shm<T>::allocator>::typeId() == m_type) {
+        if (shm_array<T, typename shm<T>::array_allocator>::typeId() == m_type) {
             if (m_ok) {
                 m_ok = false;
                 std::cerr << "ArrayLoader: multiple type matches for data array " << m_name << std::endl;
@@ -113,6 +114,14 @@ private:
     std::set<std::shared_ptr<ArrayLoader::ArrayOwner>> m_ownedArrays;
 };
 
+//! return for each entry of dir whether it does not exist locally
+V_COREEXPORT std::vector<char> missingRawArrays(const RawArrayDirectory &dir);
+//! create shm array for ent, afterwards data points to its storage, which is kept alive by owner
+V_COREEXPORT bool createRawArray(RawArrayDirectoryEntry &ent);
+//! create shm arrays for all entries of dir that do not exist locally
+/*! returns for each entry whether its contents have to be received */
+V_COREEXPORT std::vector<char> prepareRawArrays(RawArrayDirectory &dir);
+
 
 } // namespace vistle
 #endif
@@ -110,4 +110,65 @@ void DeepArchiveSaver::setCompressionSettings(const CompressionSettings &setting
     m_compressionSettings = settings;
 }
 
+namespace {
+
+struct RawArrayRecorder {
+    RawArrayRecorder(RawArrayDirectoryEntry &ent, const void *array): m_ent(ent), m_array(array) {}
+
+    template<typename T>
+    void operator()(T)
+    {
+        if (shm_array<T, typename shm<T>::array_allocator>::typeId() != m_ent.type)
+            return;
+
+        ShmVector<T> arr;
+        if (m_array) {
+            arr = *reinterpret_cast<const ShmVector<T> *>(m_array);
+        } else {
+            arr = Shm::the().getArrayFromName<T>(m_ent.name);
+        }
+        if (!arr) {
+            std::cerr << "RawArrayRecorder: did not find data array " << m_ent.name << std::endl;
+            return;
+        }
+        m_ent.elements = arr->size();
+        m_ent.size = arr->size() * sizeof(T);
+        m_ent.data = reinterpret_cast<char *>(arr->data());
+        m_ent.owner = std::make_shared<ShmVector<T>>(arr);
+        m_ok = true;
+    }
+
+    bool m_ok = false;
+    RawArrayDirectoryEntry &m_ent;
+    const void *m_array = nullptr;
+};
+
+} // namespace
+
+void ShallowArraySaver::saveArray(const std::string &name, int type, const void *array)
+{
+    if (m_rawArrays.find(name) != m_rawArrays.end())
+        return;
+
+    RawArrayDirectoryEntry ent;
+    ent.name = name;
+    ent.type = type;
+    RawArrayRecorder rec(ent, array);
+    boost::mpl::for_each<VectorTypes>(boost::reference_wrapper<RawArrayRecorder>(rec));
+    if (!rec.m_ok) {
+        std::cerr << "ShallowArraySaver: failed to record array " << name << std::endl;
+        return;
+    }
+    m_rawArrays.emplace(name, std::move(ent));
+}
+
+RawArrayDirectory ShallowArraySaver::getArrayDirectory() const
+{
+    RawArrayDirectory dir;
+    for (auto &arr: m_rawArrays) {
+        dir.emplace_back(arr.second);
+    }
+    return dir;
+}
+
 } // namespace vistle
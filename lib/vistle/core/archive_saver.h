@@ -25,8 +25,8 @@ struct V_COREEXPORT ArraySaver {
     template<typename T>
     void operator()(T)
     {
-        if (shm_array<T, typename shm<T>::allocator>::typeId() != m_type) {
-            //std::cerr << "ArraySaver: type mismatch - looking for " << m_type << ", is " << shm_array<T, typename shm<T>::allocator>::typeId() << std::endl;
+        if (shm_array<T, typename shm<T>::array_allocator>::typeId() != m_type) {
+            //std::cerr << "ArraySaver: type mismatch - looking for " << m_type << ", is " << shm_array<T, typename shm<T>::array_allocator>::typeId() << std::endl;
             return;
         }
 
@@ -91,6 +91,17 @@ private:
     std::set<std::string> m_archivedArrays;
 };
 
+//! serializes objects like DeepArchiveSaver, but only records shm arrays
+/*! array contents can be transferred from their location in shared memory afterwards */
+class V_COREEXPORT ShallowArraySaver: public DeepArchiveSaver {
+public:
+    void saveArray(const std::string &name, int type, const void *array) override;
+    RawArrayDirectory getArrayDirectory() const;
+
+private:
+    std::map<std::string, RawArrayDirectoryEntry> m_rawArrays;
+};
+
 
 } // namespace vistle
 #endif
@@ -109,6 +109,27 @@ struct SubArchiveDirectoryEntry {
 };
 typedef std::vector<SubArchiveDirectoryEntry> SubArchiveDirectory;
 
+//! shm array to be transferred as raw memory, without serializing its contents
+struct RawArrayDirectoryEntry {
+    std::string name;
+    int type = -1;
+    size_t elements = 0; //!< number of array elements
+    size_t size = 0; //!< size in bytes
+    char *data = nullptr;
+    std::shared_ptr<void> owner; //!< keeps array alive while data is in use
+
+    ARCHIVE_ACCESS
+    template<class Archive>
+    void serialize(Archive &ar)
+    {
+        ar &name;
+        ar &type;
+        ar &elements;
+        ar &size;
+    }
+};
+typedef std::vector<RawArrayDirectoryEntry> RawArrayDirectory;
+
 class V_COREEXPORT Saver {
 public:
     virtual ~Saver();
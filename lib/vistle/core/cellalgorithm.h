@@ -173,6 +173,118 @@ public:
     Index cell;
 };
 
+//! locate many points in a celltree, descending the tree for packets of points together
+template<class Grid>
+void findCellsInCelltree(const Grid *grid, const Celltree<Scalar, Index> &celltree, Index numPoints,
+                         const Vector3 *points, Index *cells, const Index *hints, bool acceptGhost)
+{
+    typedef vistle::Celltree<Scalar, Index> Celltree;
+    typedef typename Celltree::Node Node;
+    typedef uint32_t Mask;
+    const unsigned PacketSize = 32;
+
+    const Node *nodes = celltree.nodes().data();
+    const Index *ctcells = celltree.cells().data();
+    const Scalar *min = celltree.min(), *max = celltree.max();
+
+    struct Entry {
+        Index node;
+        Mask mask;
+    };
+    std::vector<Entry> stack;
+
+    for (Index start = 0; start < numPoints; start += PacketSize) {
+        const unsigned num = std::min<Index>(PacketSize, numPoints - start);
+
+        // structure-of-arrays copy of packet coordinates, so that split plane tests can be vectorized
+        Scalar coord[3][PacketSize];
+        Mask pending = 0;
+        for (unsigned i = 0; i < num; ++i) {
+            const Index p = start + i;
+            const Vector3 &point = points[p];
+            cells[p] = InvalidIndex;
+            bool inBounds = true;
+            for (int c = 0; c < 3; ++c) {
+                coord[c][i] = point[c];
+                if (point[c] < min[c] || point[c] > max[c])
+                    inBounds = false;
+            }
+            // calls are qualified with Grid:: in order to avoid virtual dispatch
+            if (hints && hints[p] != InvalidIndex && grid->Grid::inside(hints[p], point)) {
+                cells[p] = hints[p];
+                continue;
+            }
+            if (inBounds)
+                pending |= Mask(1) << i;
+        }
+        for (unsigned i = num; i < PacketSize; ++i) {
+            for (int c = 0; c < 3; ++c)
+                coord[c][i] = Scalar(0);
+        }
+
+        stack.clear();
+        if (pending)
+            stack.push_back(Entry{0, pending});
+        while (!stack.empty() && pending) {
+            const Entry e = stack.back();
+            stack.pop_back();
+            Mask mask = e.mask & pending;
+            if (!mask)
+                continue;
+
+            const Node &node = nodes[e.node];
+            if (node.isLeaf()) {
+                for (Index i = node.start; mask && i < node.start + node.size; ++i) {
+                    const Index elem = ctcells[i];
+                    if (!acceptGhost && grid->Grid::isGhostCell(elem))
+                        continue;
+                    for (unsigned bit = 0; bit < num; ++bit) {
+                        if (!(mask & (Mask(1) << bit)))
+                            continue;
+                        const Index p = start + bit;
+                        if (grid->Grid::inside(elem, points[p])) {
+                            cells[p] = elem;
+                            mask &= ~(Mask(1) << bit);
+                        }
+                    }
+                }
+                pending &= ~e.mask | mask;
+                continue;
+            }
+
+            const Scalar *c = coord[node.dim];
+            const Scalar Lmax = node.Lmax, Rmin = node.Rmin;
+            Mask left = 0, right = 0;
+            for (unsigned i = 0; i < PacketSize; ++i) {
+                left |= Mask(c[i] <= Lmax) << i;
+                right |= Mask(c[i] >= Rmin) << i;
+            }
+            left &= mask;
+            right &= mask;
+            if (right)
+                stack.push_back(Entry{node.right(), right});
+            if (left)
+                stack.push_back(Entry{node.left(), left});
+        }
+    }
+}
+
+//! implementation of GridInterface::findCells for grids with a celltree, falls back to locating points one by one
+template<class Grid>
+void findCellsOfGrid(const Grid *grid, Index numPoints, const Vector3 *points, Index *cells, const Index *hints,
+                     int flags)
+{
+    const bool acceptGhost = flags & GridInterface::AcceptGhost;
+    const bool useCelltree = (flags & GridInterface::ForceCelltree) ||
+                             (grid->hasCelltree() && !(flags & GridInterface::NoCelltree));
+    if (!useCelltree) {
+        grid->GridInterface::findCells(numPoints, points, cells, hints, flags);
+        return;
+    }
+
+    findCellsInCelltree(grid, *grid->getCelltree(), numPoints, points, cells, hints, acceptGhost);
+}
+
 template<class Grid, typename Scalar, typename Index>
 class LineIntersectionFunctor: public Celltree<Scalar, Index>::LeafFunctor {
 public:
@@ -80,8 +80,12 @@ public:
 
     Celltree(const size_t numCells, const Meta &meta = Meta());
 
-    void init(const CTVector *min, const CTVector *max, const CTVector &gmin, const CTVector &gmax);
+    //! build tree from cell bounds, large trees are refined concurrently
+    void init(const CTVector *min, const CTVector *max, const CTVector &gmin, const CTVector &gmax,
+              bool packBreadthFirst = true);
     void refine(const CTVector *min, const CTVector *max, Index nodeIdx, const CTVector &gmin, const CTVector &gmax);
+    //! store nodes in breadth-first order, so that upper levels of the tree share few cache lines
+    void packBreadthFirst();
     template<class BoundsFunctor>
     bool validateTree(BoundsFunctor &func) const;
 
@@ -103,6 +107,14 @@ public:
     }
 
 private:
+    struct Subtree;
+    template<class NodeArray>
+    static void refineNode(NodeArray &nodes, Index *cells, const CTVector *min, const CTVector *max, Index curNode,
+                           const CTVector &gmin, const CTVector &gmax, std::vector<Subtree> *deferred = nullptr,
+                           int levels = 0);
+    void refineParallel(const CTVector *min, const CTVector *max, const CTVector &gmin, const CTVector &gmax,
+                        unsigned nthreads);
+
     template<class BoundsFunctor>
     bool validateNode(BoundsFunctor &func, Index nodenum, const CTVector &min, const CTVector &max) const;
     template<class InnerNodeFunctor, class ElementFunctor>
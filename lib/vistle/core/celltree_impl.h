@@ -1,6 +1,10 @@
 #ifndef CELLTREE_IMPL_H
 #define CELLTREE_IMPL_H
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "shm_array_impl.h"
 #include "vector.h"
 
@@ -12,6 +16,14 @@ namespace vistle {
 //const Scalar Epsilon = std::numeric_limits<Scalar>::epsilon();
 
 const unsigned MaxLeafSize = 8;
+const size_t MinParallelCells = 100000; //< build celltrees with fewer cells on a single thread
+
+//! subtree whose refinement has been deferred
+template<typename Scalar, typename Index, int NumDimensions>
+struct Celltree<Scalar, Index, NumDimensions>::Subtree {
+    Index node;
+    CTVector gmin, gmax;
+};
 
 template<typename Scalar, typename Index, int NumDimensions>
 Object::Type Celltree<Scalar, Index, NumDimensions>::type()
@@ -25,7 +37,7 @@ V_COREEXPORT void Celltree<Scalar, Index, NumDimensions>::refreshImpl() const
 
 template<typename Scalar, typename Index, int NumDimensions>
 void Celltree<Scalar, Index, NumDimensions>::init(const CTVector *min, const CTVector *max, const CTVector &gmin,
-                                                  const CTVector &gmax)
+                                                  const CTVector &gmax, bool packBreadthFirst)
 {
     assert(nodes().size() == 1);
     for (int i = 0; i < NumDimensions; ++i)
@@ -50,7 +62,14 @@ void Celltree<Scalar, Index, NumDimensions>::init(const CTVector *min, const CTV
     MinMaxBoundsFunctor boundFunc(min, max);
     this->validateTree(boundFunc);
 #endif
-    refine(min, max, 0, gmin, gmax);
+    unsigned nthreads = std::thread::hardware_concurrency();
+    if (nthreads > 1 && cells().size() >= MinParallelCells) {
+        refineParallel(min, max, gmin, gmax, nthreads);
+    } else {
+        refine(min, max, 0, gmin, gmax);
+    }
+    if (packBreadthFirst)
+        this->packBreadthFirst();
 #ifdef CT_DEBUG
     std::cerr << "created celltree: " << nodes().size() << " nodes, " << cells().size() << " cells" << std::endl;
     validateTree(boundFunc);
@@ -60,19 +79,31 @@ void Celltree<Scalar, Index, NumDimensions>::init(const CTVector *min, const CTV
 template<typename Scalar, typename Index, int NumDimensions>
 void Celltree<Scalar, Index, NumDimensions>::refine(const CTVector *min, const CTVector *max, Index curNode,
                                                     const CTVector &gmin, const CTVector &gmax)
+{
+    refineNode(nodes(), d()->m_cells->data(), min, max, curNode, gmin, gmax);
+}
+
+template<typename Scalar, typename Index, int NumDimensions>
+template<class NodeArray>
+void Celltree<Scalar, Index, NumDimensions>::refineNode(NodeArray &nodes, Index *cells, const CTVector *min,
+                                                        const CTVector *max, Index curNode, const CTVector &gmin,
+                                                        const CTVector &gmax, std::vector<Subtree> *deferred,
+                                                        int levels)
 {
     const Scalar smax = std::numeric_limits<Scalar>::max();
 
     const int NumBuckets = 5;
 
-    Node *node = &(nodes()[curNode]);
+    Node *node = &(nodes[curNode]);
 
     // only split node if necessary
     if (node->size <= MaxLeafSize)
         return;
 
-    // cell index array, contains runs of cells belonging to nodes
-    Index *cells = d()->m_cells->data();
+    if (deferred && levels <= 0) {
+        deferred->push_back(Subtree{curNode, gmin, gmax});
+        return;
+    }
 
     // sort cells into buckets for each possible split dimension
 
@@ -173,7 +204,7 @@ void Celltree<Scalar, Index, NumDimensions>::refine(const CTVector *min, const C
     // record children into node being split
     const Scalar Lmax = bmax[best_bucket][best_dim];
     const Scalar Rmin = bmin[best_bucket + 1][best_dim];
-    *node = Node(best_dim, Lmax, Rmin, nodes().size());
+    *node = Node(best_dim, Lmax, Rmin, nodes.size());
     const Index D = best_dim;
 
     auto centerD = [min, max, D](Index c) -> Scalar {
@@ -242,15 +273,15 @@ void Celltree<Scalar, Index, NumDimensions>::refine(const CTVector *min, const C
     }
 #endif
 
-    Index l = nodes().size();
-    nodes().push_back(Node(start, nleft));
+    Index l = nodes.size();
+    nodes.push_back(Node(start, nleft));
 
-    Index r = nodes().size();
-    nodes().push_back(Node(start + nleft, size - nleft));
+    Index r = nodes.size();
+    nodes.push_back(Node(start + nleft, size - nleft));
 
-    assert(nodes()[l].size < size);
-    assert(nodes()[r].size < size);
-    assert(nodes()[l].size + nodes()[r].size == size);
+    assert(nodes[l].size < size);
+    assert(nodes[r].size < size);
+    assert(nodes[l].size + nodes[r].size == size);
 
     CTVector nmin = gmin;
     CTVector nmax = gmax;
@@ -258,12 +289,82 @@ void Celltree<Scalar, Index, NumDimensions>::refine(const CTVector *min, const C
     // further refinement for left...
     nmin[best_dim] = bmin[0][best_dim];
     nmax[best_dim] = bmax[best_bucket][best_dim];
-    refine(min, max, l, nmin, nmax);
+    refineNode(nodes, cells, min, max, l, nmin, nmax, deferred, levels - 1);
 
     // ...and right subnodes
     nmin[best_dim] = bmin[best_bucket + 1][best_dim];
     nmax[best_dim] = bmax[NumBuckets - 1][best_dim];
-    refine(min, max, r, nmin, nmax);
+    refineNode(nodes, cells, min, max, r, nmin, nmax, deferred, levels - 1);
+}
+
+template<typename Scalar, typename Index, int NumDimensions>
+void Celltree<Scalar, Index, NumDimensions>::refineParallel(const CTVector *min, const CTVector *max,
+                                                            const CTVector &gmin, const CTVector &gmax,
+                                                            unsigned nthreads)
+{
+    Index *cells = d()->m_cells->data();
+
+    // split upper levels serially until there are enough independent subtrees to keep all threads busy
+    int levels = 2;
+    while ((1u << levels) < 4 * nthreads)
+        ++levels;
+    std::vector<Subtree> deferred;
+    refineNode(nodes(), cells, min, max, 0, gmin, gmax, &deferred, levels);
+
+    // subtrees cover disjoint ranges of the cell array, so they can be refined independently into local node arrays
+    std::vector<std::vector<Node>> subtrees(deferred.size());
+    std::atomic<size_t> next(0);
+    auto work = [this, &deferred, &subtrees, &next, cells, min, max]() {
+        for (size_t i = next++; i < deferred.size(); i = next++) {
+            auto &local = subtrees[i];
+            local.push_back(nodes()[deferred[i].node]);
+            refineNode(local, cells, min, max, 0, deferred[i].gmin, deferred[i].gmax);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < std::min<size_t>(nthreads, deferred.size()); ++t)
+        threads.emplace_back(work);
+    work();
+    for (auto &t: threads)
+        t.join();
+
+    // append subtrees to shared node array, root of subtree replaces deferred node
+    size_t total = nodes().size();
+    for (const auto &local: subtrees)
+        total += local.size() - 1;
+    nodes().reserve(total);
+    for (size_t i = 0; i < deferred.size(); ++i) {
+        auto &local = subtrees[i];
+        const Index offset = nodes().size() - 1;
+        for (auto &n: local) {
+            if (!n.isLeaf())
+                n.child = n.child + offset;
+        }
+        nodes()[deferred[i].node] = local[0];
+        for (size_t j = 1; j < local.size(); ++j)
+            nodes().push_back(local[j]);
+        std::vector<Node>().swap(local);
+    }
+}
+
+template<typename Scalar, typename Index, int NumDimensions>
+void Celltree<Scalar, Index, NumDimensions>::packBreadthFirst()
+{
+    const Index numNodes = nodes().size();
+    std::vector<Node> packed;
+    packed.reserve(numNodes);
+    packed.push_back(nodes()[0]);
+    for (Index i = 0; i < packed.size(); ++i) {
+        if (packed[i].isLeaf())
+            continue;
+        // siblings stay adjacent, as traversal expects right child to follow left child
+        const Index child = packed[i].child;
+        packed[i].child = packed.size();
+        packed.push_back(nodes()[child]);
+        packed.push_back(nodes()[child + 1]);
+    }
+    assert(packed.size() == numNodes);
+    std::copy(packed.begin(), packed.end(), nodes().data());
 }
 
 template<typename Scalar, typename Index, int NumDimensions>
@@ -156,6 +156,15 @@ bool DataBase::copyEntry(Index to, DataBase::const_ptr src, Index from)
     return false;
 }
 
+bool DataBase::copyEntries(Index count, const Index *to, DataBase::const_ptr src, const Index *from)
+{
+    for (Index i = 0; i < count; ++i) {
+        if (!copyEntry(to ? to[i] : i, src, from ? from[i] : i))
+            return false;
+    }
+    return true;
+}
+
 void DataBase::setValue(Index idx, unsigned component, const double &value)
 {
     assert("should never be called" == NULL);
@@ -34,6 +34,8 @@ public:
 
     virtual unsigned dimension() const;
     virtual bool copyEntry(Index to, DataBase::const_ptr src, Index from);
+    virtual bool copyEntries(Index count, const Index *to, DataBase::const_ptr src,
+                             const Index *from); //< copy src[from[i]] to this[to[i]], nullptr for consecutive indices
     virtual void setValue(Index idx, unsigned component, const double &value);
     virtual double value(Index idx, unsigned component = 0) const;
 
@@ -5,11 +5,37 @@
 
 namespace vistle {
 
+void GridInterface::findCells(Index numPoints, const Vector3 *points, Index *cells, const Index *hints,
+                              int flags) const
+{
+    for (Index i = 0; i < numPoints; ++i) {
+        cells[i] = findCell(points[i], hints ? hints[i] : InvalidIndex, flags);
+    }
+}
+
+void GridInterface::interpolate(Index numPoints, const Index *cells, const Scalar *const x[3], int numComponents,
+                                const Scalar *const field[], Scalar *const out[], DataBase::Mapping mapping,
+                                InterpolationMode mode) const
+{
+    for (Index i = 0; i < numPoints; ++i) {
+        if (cells[i] == InvalidIndex) {
+            for (int c = 0; c < numComponents; ++c)
+                out[c][i] = Scalar(0);
+            continue;
+        }
+        const auto interp = getInterpolator(cells[i], Vector3(x[0][i], x[1][i], x[2][i]), mapping, mode);
+        for (int c = 0; c < numComponents; ++c)
+            out[c][i] = interp(field[c]);
+    }
+}
+
 bool GridInterface::Interpolator::check() const
 {
 #ifndef NDEBUG
     bool ok = true;
-    for (const auto w: weights) {
+    const Scalar *weights = this->weights();
+    for (Index i = 0; i < m_size; ++i) {
+        const Scalar w = weights[i];
         if (!std::isfinite(w)) {
             std::cerr << "invalid interpolation weight" << std::endl;
             ok = false;
@@ -17,7 +43,8 @@ bool GridInterface::Interpolator::check() const
     }
 
     Scalar total = 0;
-    for (const auto w: weights) {
+    for (Index i = 0; i < m_size; ++i) {
+        const Scalar w = weights[i];
         if (w < -1e-3)
             ok = false;
         total += w;
@@ -33,8 +60,8 @@ bool GridInterface::Interpolator::check() const
             std::cerr << "GridInterface::Interpolator: PROBLEM: ";
         }
         std::cerr << "weights:";
-        for (const auto w: weights) {
-            std::cerr << " " << w;
+        for (Index i = 0; i < m_size; ++i) {
+            std::cerr << " " << weights[i];
         }
         std::cerr << ", total: " << total << std::endl;
     }
@@ -7,6 +7,10 @@
 #include "geometry.h"
 #include "export.h"
 
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
 //#define INTERPOL_DEBUG
 
 namespace vistle {
@@ -22,6 +26,9 @@ public:
 
     virtual bool isGhostCell(Index elem) const = 0;
     virtual Index findCell(const Vector3 &point, Index hint = InvalidIndex, int flags = NoFlags) const = 0;
+    //! locate numPoints points at once, cells[i] is set to InvalidIndex for points outside of the grid
+    virtual void findCells(Index numPoints, const Vector3 *points, Index *cells, const Index *hints = nullptr,
+                           int flags = NoFlags) const;
     virtual bool inside(Index elem, const Vector3 &point) const = 0;
     virtual std::pair<Vector3, Vector3> cellBounds(Index elem) const = 0;
     virtual Vector3 cellCenter(Index elem) const = 0; //< a point inside the convex hull of the cell
@@ -30,40 +37,75 @@ public:
     virtual std::vector<Index> getNeighborElements(Index elem)
         const = 0; //! return at least those elements sharing faces with elem, but might also contain those just sharing vertices
 
+    //! weights and vertex indices for interpolating within a cell,
+    //! up to MaxInlineSize entries are stored within the object without allocating
     class Interpolator {
-        std::vector<Scalar> weights;
-        std::vector<Index> indices;
-
     public:
+        static const Index MaxInlineSize = 8; //!< sufficient for all cell types but polyhedra
+
         Interpolator() {}
-        Interpolator(std::vector<Scalar> &weights, std::vector<Index> &indices)
-        : weights(std::move(weights)), indices(std::move(indices))
+        //! prepare size zero weights, to be filled via weights() and indices()
+        explicit Interpolator(Index size): m_size(size)
+        {
+            if (m_size > MaxInlineSize) {
+                m_weightVec.resize(m_size);
+                m_indexVec.resize(m_size);
+            } else {
+                std::fill(m_weights, m_weights + m_size, Scalar(0));
+                std::fill(m_indices, m_indices + m_size, Index(0));
+            }
+        }
+        Interpolator(std::vector<Scalar> &weights, std::vector<Index> &indices): m_size(Index(weights.size()))
         {
+            assert(weights.size() == indices.size());
+            if (m_size > MaxInlineSize) {
+                m_weightVec = std::move(weights);
+                m_indexVec = std::move(indices);
+            } else {
+                std::copy(weights.begin(), weights.end(), m_weights);
+                std::copy(indices.begin(), indices.end(), m_indices);
+            }
 #ifndef NDEBUG
             check();
 #endif
         }
 
+        Index size() const { return m_size; }
+        Scalar *weights() { return m_size > MaxInlineSize ? m_weightVec.data() : m_weights; }
+        const Scalar *weights() const { return m_size > MaxInlineSize ? m_weightVec.data() : m_weights; }
+        Index *indices() { return m_size > MaxInlineSize ? m_indexVec.data() : m_indices; }
+        const Index *indices() const { return m_size > MaxInlineSize ? m_indexVec.data() : m_indices; }
+
         Scalar operator()(const Scalar *field) const
         {
+            const Scalar *w = weights();
+            const Index *idx = indices();
             Scalar ret(0);
-            for (size_t i = 0; i < weights.size(); ++i)
-                ret += field[indices[i]] * weights[i];
+            for (Index i = 0; i < m_size; ++i)
+                ret += field[idx[i]] * w[i];
             return ret;
         }
 
         Vector3 operator()(const Scalar *f0, const Scalar *f1, const Scalar *f2) const
         {
+            const Scalar *w = weights();
+            const Index *idx = indices();
             Vector3 ret(0, 0, 0);
-            for (size_t i = 0; i < weights.size(); ++i) {
-                const Index ind(indices[i]);
-                const Scalar w(weights[i]);
-                ret += Vector3(f0[ind], f1[ind], f2[ind]) * w;
+            for (Index i = 0; i < m_size; ++i) {
+                const Index ind(idx[i]);
+                ret += Vector3(f0[ind], f1[ind], f2[ind]) * w[i];
             }
             return ret;
         }
 
         bool check() const;
+
+    private:
+        Index m_size = 0;
+        Scalar m_weights[MaxInlineSize];
+        Index m_indices[MaxInlineSize];
+        std::vector<Scalar> m_weightVec;
+        std::vector<Index> m_indexVec;
     };
 
     DEFINE_ENUM_WITH_STRING_CONVERSIONS(InterpolationMode, (First) // value of first vertex
@@ -83,6 +125,12 @@ public:
         }
         return getInterpolator(elem, point, mapping, mode);
     }
+
+    //! interpolate numComponents fields at numPoints points with coordinates in x[0..2] located in cells,
+    //! out[c][i] receives the value of field[c] at point i, points with cells[i]==InvalidIndex yield 0
+    virtual void interpolate(Index numPoints, const Index *cells, const Scalar *const x[3], int numComponents,
+                             const Scalar *const field[], Scalar *const out[],
+                             DataBase::Mapping mapping = DataBase::Vertex, InterpolationMode mode = Linear) const;
 };
 
 } // namespace vistle
@@ -316,6 +316,11 @@ Index LayerGrid::findCell(const Vector3 &point, Index hint, int flags) const
     return InvalidIndex;
 }
 
+void LayerGrid::findCells(Index numPoints, const Vector3 *points, Index *cells, const Index *hints, int flags) const
+{
+    findCellsOfGrid(this, numPoints, points, cells, hints, flags);
+}
+
 // INSIDE CHECK
 //-------------------------------------------------------------------------
 bool LayerGrid::inside(Index elem, const Vector3 &point) const
@@ -428,18 +433,19 @@ GridInterface::Interpolator LayerGrid::getInterpolator(Index elem, const Vector3
 #endif
 
     if (mapping == Element) {
-        std::vector<Scalar> weights(1, 1.);
-        std::vector<Index> indices(1, elem);
-
-        return Interpolator(weights, indices);
+        Interpolator interp(1);
+        interp.weights()[0] = 1;
+        interp.indices()[0] = elem;
+        return interp;
     }
 
     auto cl = cellVertices(elem, m_numDivisions);
     Index nvert = cl.size();
     auto corners = cellCorners(elem);
 
-    std::vector<Index> indices((mode == Linear || mode == Mean) ? nvert : 1);
-    std::vector<Scalar> weights((mode == Linear || mode == Mean) ? nvert : 1);
+    Interpolator interp((mode == Linear || mode == Mean) ? nvert : 1);
+    Scalar *weights = interp.weights();
+    Index *indices = interp.indices();
 
     if (mode == Mean) {
         const Scalar w = Scalar(1) / nvert;
@@ -453,14 +459,7 @@ GridInterface::Interpolator LayerGrid::getInterpolator(Index elem, const Vector3
             indices[i] = cl[i];
         }
         const Vector3 ss = trilinearInverse(point, corners.data());
-        weights[0] = (1 - ss[0]) * (1 - ss[1]) * (1 - ss[2]);
-        weights[1] = ss[0] * (1 - ss[1]) * (1 - ss[2]);
-        weights[2] = ss[0] * ss[1] * (1 - ss[2]);
-        weights[3] = (1 - ss[0]) * ss[1] * (1 - ss[2]);
-        weights[4] = (1 - ss[0]) * (1 - ss[1]) * ss[2];
-        weights[5] = ss[0] * (1 - ss[1]) * ss[2];
-        weights[6] = ss[0] * ss[1] * ss[2];
-        weights[7] = (1 - ss[0]) * ss[1] * ss[2];
+        trilinearWeights(ss, weights);
     } else {
         weights[0] = 1;
 
@@ -481,7 +480,7 @@ GridInterface::Interpolator LayerGrid::getInterpolator(Index elem, const Vector3
         }
     }
 
-    return Interpolator(weights, indices);
+    return interp;
 }
 
 void LayerGrid::Data::initData()
@@ -55,6 +55,8 @@ public:
     std::pair<Vector3, Vector3> cellBounds(Index elem) const override;
     std::vector<Vector3> cellCorners(Index elem) const;
     Index findCell(const Vector3 &point, Index hint = InvalidIndex, int flags = NoFlags) const override;
+    void findCells(Index numPoints, const Vector3 *points, Index *cells, const Index *hints = nullptr,
+                   int flags = NoFlags) const override;
     bool inside(Index elem, const Vector3 &point) const override;
     Interpolator getInterpolator(Index elem, const Vector3 &point, DataBase::Mapping mapping = DataBase::Vertex,
                                  InterpolationMode mode = Linear) const override;
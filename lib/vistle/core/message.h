@@ -79,6 +79,7 @@ DEFINE_ENUM_WITH_STRING_CONVERSIONS(
     (FILEQUERYRESULT)
     (COVER)
     (INSITU)
+    (ADDOBJECTS)
     (NumMessageTypes) // keep last
 )
 V_ENUM_OUTPUT_OP(Type, ::vistle::message)
@@ -160,7 +161,7 @@ class V_COREEXPORT Message {
     // this is POD
 
 public:
-    static const size_t MESSAGE_SIZE = 1024; // fixed message size is imposed by boost::interprocess::message_queue
+    static const size_t MESSAGE_SIZE = 1024; // fixed message size is imposed by slots of MessageQueue
 
     Message(const Type type, const unsigned int size);
     // Message (or its subclasses) may not require destructors
@@ -1,9 +1,18 @@
 #include <sstream>
 #include <fstream>
 #include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <thread>
 
-#include <boost/date_time/posix_time/posix_time.hpp>
-#include <boost/thread/thread_time.hpp>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
 
 #include <vistle/util/tools.h>
 #include "message.h"
@@ -21,6 +30,67 @@ namespace interprocess = boost::interprocess;
 namespace vistle {
 namespace message {
 
+namespace {
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word has to be 32 bit");
+
+// block while word still has value expected, for at most timeout seconds (-1: indefinitely)
+void waitWhileEqual(std::atomic<uint32_t> &word, uint32_t expected, int timeout)
+{
+#ifdef __linux__
+    struct timespec ts = {timeout, 0};
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, timeout >= 0 ? &ts : nullptr,
+            nullptr, 0);
+#else
+    (void)timeout;
+    for (int i = 0; i < 1000 && word.load() == expected; ++i)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+#endif
+}
+
+void wakeAll(std::atomic<uint32_t> &word)
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+size_t roundUpPowerOfTwo(size_t n)
+{
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+} // namespace
+
+// bounded multi-producer/multi-consumer queue, slots carry a sequence number telling whether they are free or full
+struct MessageQueue::Ring {
+    static const uint32_t Magic = 0x76717565;
+
+    uint32_t magic = Magic;
+    uint32_t capacity = 0;
+    uint32_t slotSize = 0;
+
+    alignas(64) std::atomic<uint64_t> enqueuePos{0};
+    alignas(64) std::atomic<uint64_t> dequeuePos{0};
+    // futex words, incremented after every enqueue or dequeue
+    alignas(64) std::atomic<uint32_t> enqueued{0};
+    std::atomic<uint32_t> dequeued{0};
+    std::atomic<uint32_t> waitingReceivers{0};
+    std::atomic<uint32_t> waitingSenders{0};
+};
+
+struct MessageQueue::Slot {
+    std::atomic<uint64_t> seq;
+    uint32_t size; // 0 for signals
+    uint32_t priority;
+    char data[Message::MESSAGE_SIZE];
+};
+
 std::string MessageQueue::createName(const char *prefix, const int moduleID, const int rank)
 {
     std::stringstream mqID;
@@ -29,7 +99,7 @@ std::string MessageQueue::createName(const char *prefix, const int moduleID, con
     return mqID.str();
 }
 
-MessageQueue *MessageQueue::create(const std::string &n)
+MessageQueue *MessageQueue::create(const std::string &n, size_t capacity)
 {
     {
         std::ofstream f;
@@ -37,31 +107,57 @@ MessageQueue *MessageQueue::create(const std::string &n)
         f << n << std::endl;
     }
 
-    message_queue::remove(n.c_str());
-    return new MessageQueue(n, interprocess::create_only);
+    remove(n);
+    return new MessageQueue(n, interprocess::create_only, capacity);
 }
 
 MessageQueue *MessageQueue::open(const std::string &n)
 {
     auto ret = new MessageQueue(n, interprocess::open_only);
-    message_queue::remove(n.c_str());
+    remove(n);
     //std::cerr << "MessageQueue: opened and removed " << n << std::endl;
     return ret;
 }
 
-MessageQueue::MessageQueue(const std::string &n, interprocess::create_only_t)
-: m_blocking(true)
-, m_name(n)
-, m_mq(interprocess::create_only, m_name.c_str(), 10 /* num msg */, message::Message::MESSAGE_SIZE)
-{}
+bool MessageQueue::remove(const std::string &n)
+{
+    return interprocess::shared_memory_object::remove(n.c_str());
+}
+
+MessageQueue::MessageQueue(const std::string &n, interprocess::create_only_t, size_t capacity)
+: m_blocking(true), m_name(n), m_shm(interprocess::create_only, m_name.c_str(), interprocess::read_write)
+{
+    capacity = roundUpPowerOfTwo(std::max(capacity, size_t(2)));
+    const size_t slotSize = (sizeof(Slot) + 63) / 64 * 64;
+    const size_t ringSize = (sizeof(Ring) + 63) / 64 * 64;
+    m_shm.truncate(ringSize + capacity * slotSize);
+    m_region = interprocess::mapped_region(m_shm, interprocess::read_write);
+
+    m_ring = new (m_region.get_address()) Ring;
+    m_ring->capacity = capacity;
+    m_ring->slotSize = slotSize;
+    m_slots = static_cast<char *>(m_region.get_address()) + ringSize;
+    for (uint64_t i = 0; i < capacity; ++i) {
+        auto s = new (m_slots + i * slotSize) Slot;
+        s->seq.store(i, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+}
 
 MessageQueue::MessageQueue(const std::string &n, interprocess::open_only_t)
-: m_blocking(true), m_name(n), m_mq(interprocess::open_only, m_name.c_str())
-{}
+: m_blocking(true), m_name(n), m_shm(interprocess::open_only, m_name.c_str(), interprocess::read_write)
+{
+    m_region = interprocess::mapped_region(m_shm, interprocess::read_write);
+    m_ring = static_cast<Ring *>(m_region.get_address());
+    if (m_ring->magic != Ring::Magic)
+        throw interprocess::interprocess_exception(interprocess::error_info(interprocess::other_error),
+                                                   "MessageQueue: shared memory does not contain a message queue");
+    m_slots = static_cast<char *>(m_region.get_address()) + (sizeof(Ring) + 63) / 64 * 64;
+}
 
 MessageQueue::~MessageQueue()
 {
-    message_queue::remove(m_name.c_str());
+    remove(m_name);
 }
 
 void MessageQueue::makeNonBlocking()
@@ -74,51 +170,129 @@ const std::string &MessageQueue::getName() const
     return m_name;
 }
 
+size_t MessageQueue::capacity() const
+{
+    return m_ring->capacity;
+}
+
+MessageQueue::Slot *MessageQueue::slot(uint64_t pos) const
+{
+    return reinterpret_cast<Slot *>(m_slots + (pos & (m_ring->capacity - 1)) * m_ring->slotSize);
+}
+
+bool MessageQueue::tryEnqueue(const void *data, size_t size, unsigned int priority)
+{
+    assert(size <= Message::MESSAGE_SIZE);
+    uint64_t pos = m_ring->enqueuePos.load(std::memory_order_relaxed);
+    Slot *s = nullptr;
+    for (;;) {
+        s = slot(pos);
+        const uint64_t seq = s->seq.load(std::memory_order_acquire);
+        const int64_t diff = int64_t(seq) - int64_t(pos);
+        if (diff == 0) {
+            if (m_ring->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return false; // full
+        } else {
+            pos = m_ring->enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    s->size = size;
+    s->priority = priority;
+    if (size > 0)
+        memcpy(s->data, data, size);
+    s->seq.store(pos + 1, std::memory_order_release);
+
+    m_ring->enqueued.fetch_add(1);
+    if (m_ring->waitingReceivers.load() > 0)
+        wakeAll(m_ring->enqueued);
+    return true;
+}
+
+bool MessageQueue::enqueue(const void *data, size_t size, unsigned int priority)
+{
+    for (;;) {
+        if (tryEnqueue(data, size, priority))
+            return true;
+        const uint32_t dequeued = m_ring->dequeued.load();
+        m_ring->waitingSenders.fetch_add(1);
+        if (tryEnqueue(data, size, priority)) {
+            m_ring->waitingSenders.fetch_sub(1);
+            return true;
+        }
+        waitWhileEqual(m_ring->dequeued, dequeued, 1);
+        m_ring->waitingSenders.fetch_sub(1);
+    }
+}
+
+int MessageQueue::tryDequeue(Message &msg, unsigned int minPrio, unsigned int *priority, bool takeSignal)
+{
+    uint64_t pos = m_ring->dequeuePos.load(std::memory_order_relaxed);
+    Slot *s = nullptr;
+    for (;;) {
+        s = slot(pos);
+        const uint64_t seq = s->seq.load(std::memory_order_acquire);
+        const int64_t diff = int64_t(seq) - int64_t(pos + 1);
+        if (diff == 0) {
+            if (s->priority < minPrio || (s->size == 0 && !takeSignal))
+                return 0;
+            if (m_ring->dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return 0; // empty
+        } else {
+            pos = m_ring->dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    const size_t size = s->size;
+    if (size > 0)
+        memcpy(static_cast<void *>(&msg), s->data, size);
+    if (priority)
+        *priority = s->priority;
+    s->seq.store(pos + m_ring->capacity, std::memory_order_release);
+
+    m_ring->dequeued.fetch_add(1);
+    if (m_ring->waitingSenders.load() > 0)
+        wakeAll(m_ring->dequeued);
+    return size > 0 ? 1 : -1;
+}
+
 bool MessageQueue::progress()
 {
-    std::unique_lock<std::mutex> guard(m_mutex);
-    guard.unlock();
+    std::lock_guard<std::mutex> guard(m_mutex);
 
-    auto process_queue = [this, &guard](std::deque<message::Buffer> &queue) -> bool {
+    auto process_queue = [this](std::deque<message::Buffer> &queue, unsigned int priority) -> bool {
         while (!queue.empty()) {
-            guard.unlock();
             if (m_blocking) {
-                guard.lock();
-                if (!queue.empty()) {
-                    m_mq.send(queue.front().data(), message::Message::MESSAGE_SIZE, 0);
-                    queue.pop_front();
-                }
-            } else {
-                guard.lock();
-                if (!queue.empty()) {
-                    if (!m_mq.try_send(queue.front().data(), message::Message::MESSAGE_SIZE, 0)) {
-                        break;
-                    }
-                    queue.pop_front();
-                }
+                enqueue(queue.front().data(), message::Message::MESSAGE_SIZE, priority);
+            } else if (!tryEnqueue(queue.front().data(), message::Message::MESSAGE_SIZE, priority)) {
+                break;
             }
+            queue.pop_front();
         }
         return queue.empty();
     };
 
-    guard.lock();
     for (auto it = m_prioQueues.begin(), next = it; it != m_prioQueues.end(); it = next) {
         ++next;
         auto &q = it->second;
-        bool empty = process_queue(q);
+        bool empty = process_queue(q, it->first);
         if (empty) {
             next = m_prioQueues.erase(it);
         } else if (!m_blocking) {
             return false;
         }
     }
-    return process_queue(m_queue);
+    return process_queue(m_queue, 0);
 }
 
 void MessageQueue::signal()
 {
     std::unique_lock<std::mutex> guard(m_mutex);
-    m_mq.send(nullptr, 0, 0);
+    enqueue(nullptr, 0, 0);
 }
 
 bool MessageQueue::send(const Message &msg, unsigned int priority)
@@ -135,20 +309,28 @@ bool MessageQueue::send(const Message &msg, unsigned int priority)
 
 bool MessageQueue::receive(Message &msg, unsigned int *ppriority)
 {
-    size_t recvSize = 0;
-    unsigned priority = 0;
+    for (;;) {
+        int result = tryDequeue(msg, 0, ppriority);
+        if (result != 0)
+            return result > 0;
+
+        const uint32_t enqueued = m_ring->enqueued.load();
+        m_ring->waitingReceivers.fetch_add(1);
+        result = tryDequeue(msg, 0, ppriority);
+        if (result != 0) {
+            m_ring->waitingReceivers.fetch_sub(1);
+            return result > 0;
+        }
 #ifdef NO_CHECK_FOR_DEAD_PARENT
-    m_mq.receive(&msg, message::Message::MESSAGE_SIZE, recvSize, priority);
+        waitWhileEqual(m_ring->enqueued, enqueued, -1);
+        m_ring->waitingReceivers.fetch_sub(1);
 #else
-    while (!m_mq.timed_receive(&msg, message::Message::MESSAGE_SIZE, recvSize, priority,
-                               boost::get_system_time() + boost::posix_time::seconds(5))) {
+        waitWhileEqual(m_ring->enqueued, enqueued, 5);
+        m_ring->waitingReceivers.fetch_sub(1);
         if (parentProcessDied())
             throw except::parent_died();
-    }
 #endif
-    if (ppriority)
-        *ppriority = priority;
-    return recvSize == message::Message::MESSAGE_SIZE;
+    }
 }
 
 bool MessageQueue::tryReceive(Message &msg, unsigned int minPrio, unsigned int *ppriority)
@@ -158,20 +340,33 @@ bool MessageQueue::tryReceive(Message &msg, unsigned int minPrio, unsigned int *
         throw except::parent_died();
 #endif
 
-    size_t recvSize = 0;
-    unsigned priority = 0;
-    bool result = m_mq.try_receive(&msg, message::Message::MESSAGE_SIZE, recvSize, priority);
-    if (result) {
-        assert(recvSize == message::Message::MESSAGE_SIZE);
+    return tryDequeue(msg, minPrio, ppriority) > 0;
+}
+
+size_t MessageQueue::tryReceive(std::vector<message::Buffer> &msgs, size_t maxCount)
+{
+#ifndef NO_CHECK_FOR_DEAD_PARENT
+    if (parentProcessDied())
+        throw except::parent_died();
+#endif
+
+    size_t count = 0;
+    message::Buffer buf;
+    while (count < maxCount) {
+        // leave signals for a blocking receive
+        if (tryDequeue(buf, 0, nullptr, false) == 0)
+            break;
+        msgs.push_back(buf);
+        ++count;
     }
-    if (ppriority)
-        *ppriority = priority;
-    return result;
+    return count;
 }
 
 size_t MessageQueue::getNumMessages()
 {
-    return m_mq.get_num_msg();
+    const uint64_t dequeued = m_ring->dequeuePos.load();
+    const uint64_t enqueued = m_ring->enqueuePos.load();
+    return enqueued > dequeued ? enqueued - dequeued : 0;
 }
 
 } // namespace message
@@ -2,10 +2,13 @@
 #define MESSAGEQUEUE_H
 
 #include <deque>
+#include <map>
 #include <mutex>
+#include <string>
+#include <vector>
 #include <vistle/util/boost_interprocess_config.h>
-#define BOOST_INTERPROCESS_MSG_QUEUE_CIRCULAR_INDEX
-#include <boost/interprocess/ipc/message_queue.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 #include "message.h"
 #include "export.h"
@@ -15,12 +18,15 @@ namespace message {
 
 class Message;
 
+//! bounded lock-free queue of fixed size messages in shared memory
+/*! several threads or processes may send, messages are received in the order they have been enqueued */
 class V_COREEXPORT MessageQueue {
 public:
-    typedef boost::interprocess::message_queue message_queue;
+    static const size_t DefaultCapacity = 256; //!< number of messages that can be queued
 
-    static MessageQueue *create(const std::string &m_name);
+    static MessageQueue *create(const std::string &m_name, size_t capacity = DefaultCapacity);
     static MessageQueue *open(const std::string &m_name);
+    static bool remove(const std::string &m_name);
 
     static std::string createName(const char *prefix, const int moduleID, const int rank);
 
@@ -36,15 +42,31 @@ public:
 
     bool receive(Message &msg, unsigned int *priority = nullptr);
     bool tryReceive(Message &msg, unsigned int minPrio = 0, unsigned int *priority = nullptr);
+    //! append up to maxCount queued messages to msgs without blocking, returns number of messages received
+    /*! stops at a signal */
+    size_t tryReceive(std::vector<message::Buffer> &msgs, size_t maxCount);
     size_t getNumMessages();
+    size_t capacity() const;
 
 private:
+    struct Ring;
+    struct Slot;
+
     bool m_blocking = true;
-    MessageQueue(const std::string &m_name, boost::interprocess::create_only_t);
+    MessageQueue(const std::string &m_name, boost::interprocess::create_only_t, size_t capacity);
     MessageQueue(const std::string &m_name, boost::interprocess::open_only_t);
 
+    bool tryEnqueue(const void *data, size_t size, unsigned int priority);
+    bool enqueue(const void *data, size_t size, unsigned int priority);
+    //! returns 0 if empty, 1 for a message and -1 for a signal
+    int tryDequeue(Message &msg, unsigned int minPrio, unsigned int *priority, bool takeSignal = true);
+    Slot *slot(uint64_t pos) const;
+
     const std::string m_name;
-    message_queue m_mq;
+    boost::interprocess::shared_memory_object m_shm;
+    boost::interprocess::mapped_region m_region;
+    Ring *m_ring = nullptr;
+    char *m_slots = nullptr;
     std::deque<message::Buffer> m_queue; // for messages with prioritiy 0
     std::map<unsigned int, std::deque<message::Buffer>> m_prioQueues; // for messages with higher priority
     std::mutex m_mutex;
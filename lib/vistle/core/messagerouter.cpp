@@ -58,6 +58,7 @@ void Router::initRoutingTable()
 
     rt[ADDOBJECT] = DestManager | HandleOnNode;
     rt[ADDOBJECTCOMPLETED] = DestManager | HandleOnNode;
+    rt[ADDOBJECTS] = DestManager | HandleOnNode;
 
     rt[BARRIER] = HandleOnDest;
     rt[BARRIERREACHED] = HandleOnDest;
@@ -42,11 +42,13 @@ template V_COREEXPORT buffer addPayload<std::string>(Message &message, const std
 template V_COREEXPORT buffer addPayload<SendText::Payload>(Message &message, const SendText::Payload &payload);
 template V_COREEXPORT buffer addPayload<SetParameterChoices::Payload>(Message &message,
                                                                       const SetParameterChoices::Payload &payload);
+template V_COREEXPORT buffer addPayload<AddObjects::Payload>(Message &message, const AddObjects::Payload &payload);
 
 
 template V_COREEXPORT std::string getPayload(const buffer &data);
 template V_COREEXPORT SendText::Payload getPayload(const buffer &data);
 template V_COREEXPORT SetParameterChoices::Payload getPayload(const buffer &data);
+template V_COREEXPORT AddObjects::Payload getPayload(const buffer &data);
 
 Identify::Identify(const std::string &name)
 : m_identity(Identity::REQUEST)
@@ -897,6 +899,79 @@ const char *AddObjectCompleted::originalDestPort() const
     return m_orgDestPort.data();
 }
 
+AddObjects::Payload::Payload() = default;
+
+AddObjects::Payload::Payload(const std::vector<Object::const_ptr> &objects)
+{
+    names.reserve(objects.size());
+    for (const auto &obj: objects) {
+        names.emplace_back(obj->getName());
+    }
+    AddObjects::ref(objects);
+}
+
+AddObjects::AddObjects(const std::string &sender, const Payload &payload, const std::string &dest)
+: m_numObjects(payload.names.size())
+{
+    COPY_STRING(senderPort, sender);
+    COPY_STRING(destPort, dest);
+    COPY_STRING(m_shmname, Shm::the().name());
+}
+
+void AddObjects::setSenderPort(const std::string &send)
+{
+    COPY_STRING(senderPort, send);
+}
+
+const char *AddObjects::getSenderPort() const
+{
+    return senderPort.data();
+}
+
+void AddObjects::setDestPort(const std::string &dest)
+{
+    COPY_STRING(destPort, dest);
+}
+
+const char *AddObjects::getDestPort() const
+{
+    return destPort.data();
+}
+
+size_t AddObjects::numObjects() const
+{
+    return m_numObjects;
+}
+
+std::vector<Object::const_ptr> AddObjects::takeObjects(const Payload &payload) const
+{
+    assert(payload.names.size() == m_numObjects);
+    const bool sameShm = Shm::isAttached() && Shm::the().name() == std::string(m_shmname.data());
+
+    std::vector<Object::const_ptr> objects;
+    objects.reserve(payload.names.size());
+    for (const auto &name: payload.names) {
+        auto obj = Shm::the().getObjectFromName(name);
+        if (!obj) {
+            std::cerr << "AddObjects::takeObjects: did not find " << name << " by name" << std::endl;
+            continue;
+        }
+        if (sameShm) {
+            // ref count has been increased when payload was created or forwarded
+            obj->unref();
+        }
+        objects.emplace_back(obj);
+    }
+    return objects;
+}
+
+void AddObjects::ref(const std::vector<Object::const_ptr> &objects)
+{
+    for (const auto &obj: objects) {
+        obj->ref();
+    }
+}
+
 template<Type MessageType>
 ConnectBase<MessageType>::ConnectBase(const int moduleIDA, const std::string &portA, const int moduleIDB,
                                       const std::string &portB)
@@ -1974,6 +2049,11 @@ std::ostream &operator<<(std::ostream &s, const Message &m)
           << " (handle: " << (mm.handleValid() ? "valid" : "invalid") << ")";
         break;
     }
+    case ADDOBJECTS: {
+        auto &mm = static_cast<const AddObjects &>(m);
+        s << ", " << mm.numObjects() << " objects, " << mm.getSenderPort() << " -> " << mm.getDestPort();
+        break;
+    }
     case ADDOBJECTCOMPLETED: {
         auto &mm = static_cast<const AddObjectCompleted &>(m);
         s << ", obj: " << mm.objectName() << ", original destination: " << mm.originalDestination() << std::endl;
@@ -458,6 +458,44 @@ private:
     port_name_t m_orgDestPort;
 };
 
+//! add a batch of objects created on the same rank to the input queues of an input port
+/*! names of the objects are transmitted in the message payload, each object is referenced until it is taken */
+class V_COREEXPORT AddObjects: public MessageBase<AddObjects, ADDOBJECTS> {
+public:
+    struct V_COREEXPORT Payload {
+        Payload();
+        //! keeps a reference to each object
+        explicit Payload(const std::vector<vistle::Object::const_ptr> &objects);
+
+        std::vector<std::string> names;
+
+        ARCHIVE_ACCESS
+        template<class Archive>
+        void serialize(Archive &ar)
+        {
+            ar &names;
+        }
+    };
+
+    AddObjects(const std::string &senderPort, const Payload &payload, const std::string &destPort = "");
+
+    void setSenderPort(const std::string &sendPort);
+    const char *getSenderPort() const;
+    void setDestPort(const std::string &destPort);
+    const char *getDestPort() const;
+    size_t numObjects() const;
+    //! release references held by payload, may only be called once per recipient
+    std::vector<vistle::Object::const_ptr> takeObjects(const Payload &payload) const;
+    //! add another reference to each object, e.g. for forwarding to another recipient
+    static void ref(const std::vector<vistle::Object::const_ptr> &objects);
+
+private:
+    port_name_t senderPort;
+    port_name_t destPort;
+    shmsegname_t m_shmname;
+    uint64_t m_numObjects = 0;
+};
+
 //! Base class for connect and disconnect
 template<Type MessageType>
 class V_COREEXPORT ConnectBase: public MessageBase<ConnectBase<MessageType>, MessageType> {
@@ -996,10 +1034,12 @@ extern template V_COREEXPORT buffer addPayload<std::string>(Message &message, co
 extern template V_COREEXPORT buffer addPayload<SendText::Payload>(Message &message, const SendText::Payload &payload);
 extern template V_COREEXPORT buffer
 addPayload<SetParameterChoices::Payload>(Message &message, const SetParameterChoices::Payload &payload);
+extern template V_COREEXPORT buffer addPayload<AddObjects::Payload>(Message &message, const AddObjects::Payload &payload);
 
 extern template V_COREEXPORT std::string getPayload(const buffer &data);
 extern template V_COREEXPORT SendText::Payload getPayload(const buffer &data);
 extern template V_COREEXPORT SetParameterChoices::Payload getPayload(const buffer &data);
+extern template V_COREEXPORT AddObjects::Payload getPayload(const buffer &data);
 
 V_COREEXPORT std::ostream &operator<<(std::ostream &s, const Message &msg);
 
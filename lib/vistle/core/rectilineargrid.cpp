@@ -258,10 +258,10 @@ GridInterface::Interpolator RectilinearGrid::getInterpolator(Index elem, const V
 #endif
 
     if (mapping == DataBase::Element) {
-        std::vector<Scalar> weights(1, 1.);
-        std::vector<Index> indices(1, elem);
-
-        return Interpolator(weights, indices);
+        Interpolator interp(1);
+        interp.weights()[0] = 1;
+        interp.indices()[0] = elem;
+        return interp;
     }
 
     std::array<Index, 3> n = cellCoordinates(elem, m_numDivisions);
@@ -273,8 +273,9 @@ GridInterface::Interpolator RectilinearGrid::getInterpolator(Index elem, const V
     const Vector3 size = corner1 - corner0;
 
     const Index nvert = 8;
-    std::vector<Index> indices((mode == Linear || mode == Mean) ? nvert : 1);
-    std::vector<Scalar> weights((mode == Linear || mode == Mean) ? nvert : 1);
+    Interpolator interp((mode == Linear || mode == Mean) ? nvert : 1);
+    Scalar *weights = interp.weights();
+    Index *indices = interp.indices();
 
     if (mode == Mean) {
         const Scalar w = Scalar(1) / nvert;
@@ -291,14 +292,7 @@ GridInterface::Interpolator RectilinearGrid::getInterpolator(Index elem, const V
         for (int c = 0; c < 3; ++c) {
             ss[c] /= size[c];
         }
-        weights[0] = (1 - ss[0]) * (1 - ss[1]) * (1 - ss[2]);
-        weights[1] = ss[0] * (1 - ss[1]) * (1 - ss[2]);
-        weights[2] = ss[0] * ss[1] * (1 - ss[2]);
-        weights[3] = (1 - ss[0]) * ss[1] * (1 - ss[2]);
-        weights[4] = (1 - ss[0]) * (1 - ss[1]) * ss[2];
-        weights[5] = ss[0] * (1 - ss[1]) * ss[2];
-        weights[6] = ss[0] * ss[1] * ss[2];
-        weights[7] = (1 - ss[0]) * ss[1] * ss[2];
+        trilinearWeights(ss, weights);
     } else {
         weights[0] = 1;
 
@@ -317,7 +311,44 @@ GridInterface::Interpolator RectilinearGrid::getInterpolator(Index elem, const V
         }
     }
 
-    return Interpolator(weights, indices);
+    return interp;
+}
+
+void RectilinearGrid::interpolate(Index numPoints, const Index *cells, const Scalar *const x[3], int numComponents,
+                                  const Scalar *const field[], Scalar *const out[], DataBase::Mapping mapping,
+                                  InterpolationMode mode) const
+{
+    if (mapping == DataBase::Element || mode != Linear) {
+        GridInterface::interpolate(numPoints, cells, x, numComponents, field, out, mapping, mode);
+        return;
+    }
+
+    // closed-form weights from coordinates along axes
+    Scalar w[8];
+    for (Index i = 0; i < numPoints; ++i) {
+        const Index elem = cells[i];
+        if (elem == InvalidIndex) {
+            for (int c = 0; c < numComponents; ++c)
+                out[c][i] = Scalar(0);
+            continue;
+        }
+
+        const auto n = cellCoordinates(elem, m_numDivisions);
+        const auto cl = cellVertices(elem, m_numDivisions);
+        Vector3 ss;
+        for (int c = 0; c < 3; ++c) {
+            const Scalar *coord = m_coords[c];
+            ss[c] = (x[c][i] - coord[n[c]]) / (coord[n[c] + 1] - coord[n[c]]);
+        }
+        trilinearWeights(ss, w);
+        for (int c = 0; c < numComponents; ++c) {
+            const Scalar *f = field[c];
+            Scalar v(0);
+            for (int k = 0; k < 8; ++k)
+                v += f[cl[k]] * w[k];
+            out[c][i] = v;
+        }
+    }
 }
 
 void RectilinearGrid::Data::initData()
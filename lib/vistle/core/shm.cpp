@@ -87,6 +87,7 @@ Shm::Shm(const std::string &instanceName, const int m, const int r, size_t size)
 , m_objectDictionaryMutex(nullptr)
 #ifndef NO_SHMEM
 , m_shm(nullptr)
+, m_arena(nullptr)
 #endif
 {
 #ifdef SHMDEBUG
@@ -109,6 +110,14 @@ Shm::Shm(const std::string &instanceName, const int m, const int r, size_t size)
     }
 
     m_allocator = new void_allocator(shm().get_segment_manager());
+    m_arena = ShmArena::of(shm().get_segment_manager());
+    ShmArena::setPlacement(memory_placement_from_environment());
+
+    // huge pages are allocated according to the advice for the mapping that touches them first
+    if (const char *huge = getenv("VISTLE_SHM_HUGEPAGES")) {
+        if (atoi(huge) > 0)
+            advise_huge_pages(m_shm->get_address(), m_shm->get_size());
+    }
 
     m_shmDeletionMutex = m_shm->find_or_construct<interprocess::interprocess_recursive_mutex>("shmdelete_mutex")();
     m_objectDictionaryMutex =
@@ -127,6 +136,7 @@ Shm::Shm(const std::string &instanceName, const int m, const int r, size_t size)
 Shm::~Shm()
 {
 #ifndef NO_SHMEM
+    ShmArena::detach();
     if (m_remove) {
         interprocess::shared_memory_object::remove(name().c_str());
         std::cerr << "removed shm " << name() << std::endl;
@@ -276,7 +286,7 @@ bool Shm::cleanAll(int rank)
 
             if (shmid.find("_send_") != std::string::npos || shmid.find("_recv_") != std::string::npos) {
                 //std::cerr << "removing message queue: id " << shmid << std::flush;
-                ok = message::MessageQueue::message_queue::remove(shmid.c_str());
+                ok = message::MessageQueue::remove(shmid);
                 log = false;
             } else {
                 std::cerr << "removing shared memory: id " << shmid << std::flush;
@@ -444,6 +454,11 @@ const managed_shm &Shm::shm() const
 {
     return *m_shm;
 }
+
+ShmArena *Shm::arena() const
+{
+    return m_arena;
+}
 #endif
 
 
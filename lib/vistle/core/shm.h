@@ -37,6 +37,7 @@
 #include "shmname.h"
 #include "shmdata.h"
 #include "shm_config.h"
+#include "shm_arena.h"
 
 #if defined(BOOST_INTERPROCESS_POSIX_BARRIERS) && defined(BOOST_INTERPROCESS_POSIX_PROCESS_SHARED)
 #define SHMBARRIER
@@ -95,10 +96,11 @@ struct ShmDebugInfo {
 template<typename T>
 struct shm {
     typedef vistle::shm_allocator<T> allocator;
+    typedef vistle::shm_array_allocator<T> array_allocator;
 #ifdef NO_SHMEM
     typedef std::basic_string<T> string;
     typedef std::vector<T> vector;
-    typedef vistle::shm_array<T, allocator> array;
+    typedef vistle::shm_array<T, array_allocator> array;
     typedef array *array_ptr;
     struct Constructor {
         std::string name;
@@ -112,7 +114,7 @@ struct shm {
 #else
     typedef boost::interprocess::basic_string<T, std::char_traits<T>, allocator> string;
     typedef boost::interprocess::vector<T, allocator> vector;
-    typedef vistle::shm_array<T, allocator> array;
+    typedef vistle::shm_array<T, array_allocator> array;
     typedef boost::interprocess::offset_ptr<array> array_ptr;
     static typename managed_shm::segment_manager::template construct_proxy<T>::type construct(const std::string &name);
 #endif
@@ -125,7 +127,7 @@ struct shm {
 template<class T>
 class shm_array_ref;
 template<class T>
-using ShmVector = shm_array_ref<shm_array<T, typename shm<T>::allocator>>;
+using ShmVector = shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>;
 
 class V_COREEXPORT Shm {
     template<typename T>
@@ -160,6 +162,8 @@ public:
     typedef boost::interprocess::allocator<void, managed_shm::segment_manager> void_allocator;
     managed_shm &shm();
     const managed_shm &shm() const;
+    //! arena serving array storage
+    ShmArena *arena() const;
 #endif
     const void_allocator &allocator() const;
 
@@ -233,6 +237,7 @@ private:
     mutable boost::interprocess::interprocess_recursive_mutex *m_shmDeletionMutex;
     mutable boost::interprocess::interprocess_recursive_mutex *m_objectDictionaryMutex;
     managed_shm *m_shm;
+    ShmArena *m_arena;
 #endif
     mutable std::atomic<int> m_lockCount;
 #ifdef SHMBARRIER
@@ -370,7 +375,7 @@ T *shm<T>::Constructor::operator()(Args &&...args)
 #include "shm_reference.h"
 
 namespace vistle {
-//using ShmVector = shm_array_ref<shm_array<T, typename shm<T>::allocator>>;
+//using ShmVector = shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>;
 
 
 }
@@ -0,0 +1,331 @@
+#include "shm_arena.h"
+
+#ifndef NO_SHMEM
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <vector>
+
+namespace vistle {
+
+namespace {
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "free lists shared between processes have to be lock-free");
+
+// free list heads: offset from segment manager in units of Granularity, tagged with a counter against ABA
+const size_t Granularity = 16;
+const unsigned OffsetBits = 44;
+const uint64_t OffsetMask = (uint64_t(1) << OffsetBits) - 1;
+
+const size_t MinChunkSize = size_t(1) << 16;
+const size_t MaxChunkSize = size_t(1) << 21;
+const size_t CacheBytes = size_t(1) << 20; // per size class and thread
+
+std::atomic<ShmArena *> s_current(nullptr);
+MemoryPlacement s_placement = MemoryPlacement::Default;
+
+std::atomic<uint64_t> &next(char *block)
+{
+    return *reinterpret_cast<std::atomic<uint64_t> *>(block);
+}
+
+size_t cacheCapacity(unsigned cls)
+{
+    return std::min<size_t>(256, std::max<size_t>(4, CacheBytes / ShmArena::classSize(cls)));
+}
+
+uint64_t tagged(uint64_t head, uint64_t offset)
+{
+    return (((head >> OffsetBits) + 1) << OffsetBits) | offset;
+}
+
+} // namespace
+
+struct ShmArena::ThreadCache {
+    ShmArena *arena = nullptr;
+    std::vector<char *> blocks[NumClasses];
+    int64_t allocated = 0, requested = 0; // not yet accounted for in arena
+
+    ~ThreadCache()
+    {
+        if (arena && arena == s_current.load())
+            flush();
+    }
+
+    void reset(ShmArena *a)
+    {
+        if (arena && arena == s_current.load())
+            flush();
+        for (auto &b: blocks)
+            b.clear();
+        allocated = requested = 0;
+        arena = a;
+    }
+
+    void spill(unsigned cls, size_t keep)
+    {
+        auto &b = blocks[cls];
+        if (b.size() <= keep)
+            return;
+        for (size_t i = keep; i + 1 < b.size(); ++i)
+            new (b[i]) std::atomic<uint64_t>(arena->encode(b[i + 1]));
+        arena->push(cls, b[keep], b.back(), b.size() - keep);
+        b.resize(keep);
+    }
+
+    void account()
+    {
+        arena->account(allocated, requested);
+        allocated = requested = 0;
+    }
+
+    void flush()
+    {
+        for (unsigned cls = 0; cls < NumClasses; ++cls)
+            spill(cls, 0);
+        account();
+    }
+};
+
+ShmArena::ThreadCache &ShmArena::threadCache()
+{
+    static thread_local ThreadCache cache;
+    return cache;
+}
+
+ShmArena::ShmArena(segment_manager *segment)
+: m_segment(segment)
+, m_reserved(0)
+, m_allocated(0)
+, m_requested(0)
+, m_highWater(0)
+, m_listed(0)
+, m_chunks(0)
+, m_large(0)
+{
+    for (auto &h: m_head)
+        h = 0;
+}
+
+ShmArena *ShmArena::of(segment_manager *segment)
+{
+    auto arena = s_current.load();
+    if (arena && arena->m_segment.get() == segment)
+        return arena;
+    arena = segment->find_or_construct<ShmArena>("vistle_arena")(segment);
+    s_current = arena;
+    return arena;
+}
+
+void ShmArena::detach()
+{
+    auto &cache = threadCache();
+    cache.reset(nullptr);
+    s_current = nullptr;
+}
+
+void ShmArena::releaseThreadCache()
+{
+    auto &cache = threadCache();
+    if (cache.arena && cache.arena == s_current.load())
+        cache.flush();
+}
+
+void ShmArena::setPlacement(MemoryPlacement placement)
+{
+    s_placement = placement;
+}
+
+unsigned ShmArena::sizeClass(size_t bytes)
+{
+    assert(bytes <= MaxBlockSize);
+    if (bytes <= MinBlockSize)
+        return 0;
+    // four classes per power of two
+    const size_t s = bytes - 1;
+    unsigned b = 0;
+    while (s >> (b + 1))
+        ++b;
+    const unsigned sub = (s >> (b - 2)) & 3;
+    return (b - 6) * 4 + sub + 1;
+}
+
+size_t ShmArena::classSize(unsigned cls)
+{
+    if (cls == 0)
+        return MinBlockSize;
+    const unsigned b = (cls - 1) / 4 + 6;
+    const unsigned sub = (cls - 1) % 4;
+    return size_t(4 + sub + 1) << (b - 2);
+}
+
+uint64_t ShmArena::encode(void *p) const
+{
+    const auto offset = static_cast<char *>(p) - reinterpret_cast<char *>(m_segment.get());
+    assert(offset > 0);
+    assert(offset % Granularity == 0);
+    return uint64_t(offset) / Granularity;
+}
+
+char *ShmArena::decode(uint64_t offset) const
+{
+    return reinterpret_cast<char *>(m_segment.get()) + offset * Granularity;
+}
+
+void ShmArena::push(unsigned cls, char *first, char *last, size_t count)
+{
+    const uint64_t f = encode(first);
+    uint64_t head = m_head[cls].load(std::memory_order_acquire);
+    do {
+        new (last) std::atomic<uint64_t>(head & OffsetMask);
+    } while (!m_head[cls].compare_exchange_weak(head, tagged(head, f), std::memory_order_release,
+                                                std::memory_order_acquire));
+    m_listed.fetch_add(count * classSize(cls), std::memory_order_relaxed);
+}
+
+char *ShmArena::pop(unsigned cls)
+{
+    uint64_t head = m_head[cls].load(std::memory_order_acquire);
+    while (head & OffsetMask) {
+        char *block = decode(head & OffsetMask);
+        // block may have been popped concurrently, then the tag has changed and the exchange fails
+        const uint64_t n = next(block).load(std::memory_order_relaxed);
+        if (m_head[cls].compare_exchange_weak(head, tagged(head, n), std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+            m_listed.fetch_sub(classSize(cls), std::memory_order_relaxed);
+            return block;
+        }
+    }
+    return nullptr;
+}
+
+void ShmArena::carve(unsigned cls)
+{
+    const size_t size = classSize(cls);
+    const size_t n = std::min(MaxChunkSize, std::max(MinChunkSize, 64 * size)) / size;
+    char *chunk = static_cast<char *>(m_segment->allocate(n * size));
+    for (size_t i = 0; i + 1 < n; ++i)
+        new (chunk + i * size) std::atomic<uint64_t>(encode(chunk + (i + 1) * size));
+    m_reserved.fetch_add(n * size, std::memory_order_relaxed);
+    m_chunks.fetch_add(1, std::memory_order_relaxed);
+    push(cls, chunk, chunk + (n - 1) * size, n);
+}
+
+void ShmArena::account(int64_t allocated, int64_t requested)
+{
+    if (requested != 0)
+        m_requested.fetch_add(uint64_t(requested), std::memory_order_relaxed);
+    if (allocated == 0)
+        return;
+    const uint64_t a = m_allocated.fetch_add(uint64_t(allocated), std::memory_order_relaxed) + uint64_t(allocated);
+    if (int64_t(a) < 0)
+        return;
+    uint64_t hw = m_highWater.load(std::memory_order_relaxed);
+    while (a > hw && !m_highWater.compare_exchange_weak(hw, a, std::memory_order_relaxed)) {
+    }
+}
+
+void *ShmArena::allocate(size_t bytes)
+{
+    if (bytes > MaxBlockSize) {
+        void *p = m_segment->allocate(bytes);
+        if (bytes >= PlacementThreshold)
+            place_memory(p, bytes, s_placement);
+        m_reserved.fetch_add(bytes, std::memory_order_relaxed);
+        m_large.fetch_add(1, std::memory_order_relaxed);
+        account(bytes, bytes);
+        return p;
+    }
+
+    const unsigned cls = sizeClass(bytes);
+    auto &cache = threadCache();
+    if (cache.arena != this)
+        cache.reset(this);
+    auto &blocks = cache.blocks[cls];
+    if (blocks.empty()) {
+        const size_t want = std::max<size_t>(1, cacheCapacity(cls) / 2);
+        while (blocks.size() < want) {
+            if (char *block = pop(cls)) {
+                blocks.push_back(block);
+            } else if (blocks.empty()) {
+                carve(cls);
+            } else {
+                break;
+            }
+        }
+        cache.account();
+    }
+
+    char *block = blocks.back();
+    blocks.pop_back();
+    cache.allocated += classSize(cls);
+    cache.requested += bytes;
+    return block;
+}
+
+void ShmArena::deallocate(void *p, size_t bytes)
+{
+    if (!p)
+        return;
+
+    if (bytes > MaxBlockSize) {
+        m_segment->deallocate(p);
+        m_reserved.fetch_sub(bytes, std::memory_order_relaxed);
+        m_large.fetch_sub(1, std::memory_order_relaxed);
+        account(-int64_t(bytes), -int64_t(bytes));
+        return;
+    }
+
+    const unsigned cls = sizeClass(bytes);
+    auto &cache = threadCache();
+    if (cache.arena != this)
+        cache.reset(this);
+    auto &blocks = cache.blocks[cls];
+    blocks.push_back(static_cast<char *>(p));
+    cache.allocated -= classSize(cls);
+    cache.requested -= bytes;
+    const size_t capacity = cacheCapacity(cls);
+    if (blocks.size() > capacity) {
+        cache.spill(cls, capacity / 2);
+        cache.account();
+    }
+}
+
+void ShmArena::flushThreadCache()
+{
+    auto &cache = threadCache();
+    if (cache.arena == this)
+        cache.flush();
+}
+
+ShmArena::Statistics ShmArena::statistics() const
+{
+    auto value = [](const std::atomic<uint64_t> &a) -> size_t {
+        // may be transiently negative while threads have not accounted for blocks freed by others
+        return std::max<int64_t>(0, int64_t(a.load(std::memory_order_relaxed)));
+    };
+
+    Statistics stats;
+    stats.reserved = value(m_reserved);
+    stats.allocated = value(m_allocated);
+    stats.requested = value(m_requested);
+    stats.highWater = value(m_highWater);
+    stats.listed = value(m_listed);
+    stats.chunks = value(m_chunks);
+    stats.large = value(m_large);
+    return stats;
+}
+
+std::ostream &operator<<(std::ostream &os, const ShmArena::Statistics &stats)
+{
+    const double MiB = 1024. * 1024.;
+    os << "reserved " << stats.reserved / MiB << " MiB, allocated " << stats.allocated / MiB << " MiB (high water "
+       << stats.highWater / MiB << " MiB), requested " << stats.requested / MiB << " MiB, free lists "
+       << stats.listed / MiB << " MiB, " << stats.chunks << " chunks, " << stats.large
+       << " large allocations, fragmentation " << stats.fragmentation() * 100. << "% (internal "
+       << stats.internalFragmentation() * 100. << "%)";
+    return os;
+}
+
+} // namespace vistle
+#endif
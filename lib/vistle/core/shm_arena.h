@@ -0,0 +1,142 @@
+#ifndef VISTLE_SHM_ARENA_H
+#define VISTLE_SHM_ARENA_H
+
+#include "shm_config.h"
+
+#ifndef NO_SHMEM
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+#include <vistle/util/boost_interprocess_config.h>
+#include <boost/interprocess/offset_ptr.hpp>
+
+#include <vistle/util/affinity.h>
+
+#include "export.h"
+
+namespace vistle {
+
+//! size-class allocator for array storage carved from large chunks of the shared memory segment
+/*! The arena lives in the segment and is shared by all processes attached to it.
+ *  Requests up to MaxBlockSize are rounded up to one of NumClasses size classes and served from
+ *  per-thread caches, which exchange blocks with lock-free per-class free lists in the segment.
+ *  Only carving new chunks and larger requests go through the (locked) segment manager.
+ *  Chunks are never returned to the segment manager, but their blocks are reused across all processes. */
+class V_COREEXPORT ShmArena {
+public:
+    typedef managed_shm::segment_manager segment_manager;
+
+    static const size_t MinBlockSize = 64;
+    static const size_t MaxBlockSize = size_t(1) << 18;
+    static const unsigned NumClasses = 49;
+    //! minimum size of allocations for which NUMA placement is applied
+    static const size_t PlacementThreshold = size_t(1) << 22;
+
+    struct Statistics {
+        size_t reserved = 0; //< bytes obtained from segment manager
+        size_t allocated = 0; //< bytes handed out, rounded up to size classes
+        size_t requested = 0; //< bytes requested by users
+        size_t highWater = 0; //< maximum of allocated
+        size_t listed = 0; //< bytes in shared free lists, not counting thread caches
+        size_t chunks = 0; //< number of chunks carved for size classes
+        size_t large = 0; //< number of live allocations larger than MaxBlockSize
+
+        //! fraction of reserved memory not requested by users
+        double fragmentation() const { return reserved > 0 ? 1. - double(requested) / double(reserved) : 0.; }
+        //! fraction of allocated memory lost to rounding up to size classes
+        double internalFragmentation() const
+        {
+            return allocated > 0 ? 1. - double(requested) / double(allocated) : 0.;
+        }
+    };
+
+    explicit ShmArena(segment_manager *segment);
+    ShmArena(const ShmArena &) = delete;
+    ShmArena &operator=(const ShmArena &) = delete;
+
+    //! find arena of segment, or create it if not present
+    static ShmArena *of(segment_manager *segment);
+    //! stop using arena of currently attached segment, returning blocks cached by calling thread
+    static void detach();
+    //! return blocks cached by calling thread to arena of currently attached segment, e.g. before a worker exits
+    static void releaseThreadCache();
+    //! NUMA placement of large allocations made by this process
+    static void setPlacement(MemoryPlacement placement);
+
+    void *allocate(size_t bytes);
+    void deallocate(void *p, size_t bytes);
+
+    //! consistent once all threads have returned their cached blocks, otherwise approximate
+    Statistics statistics() const;
+    //! return blocks cached by calling thread to shared free lists
+    void flushThreadCache();
+
+    static unsigned sizeClass(size_t bytes);
+    static size_t classSize(unsigned cls);
+
+private:
+    struct ThreadCache;
+    static ThreadCache &threadCache();
+
+    uint64_t encode(void *p) const;
+    char *decode(uint64_t offset) const;
+    //! push linked list of blocks from first to last
+    void push(unsigned cls, char *first, char *last, size_t count);
+    char *pop(unsigned cls);
+    void carve(unsigned cls);
+    void account(int64_t allocated, int64_t requested);
+
+    boost::interprocess::offset_ptr<segment_manager> m_segment;
+    std::atomic<uint64_t> m_head[NumClasses]; //< tagged free list heads
+    std::atomic<uint64_t> m_reserved, m_allocated, m_requested, m_highWater, m_listed, m_chunks, m_large;
+};
+
+V_COREEXPORT std::ostream &operator<<(std::ostream &os, const ShmArena::Statistics &stats);
+
+//! allocator for shm_array storage using ShmArena
+template<typename T>
+class shm_arena_allocator {
+    template<typename U>
+    friend class shm_arena_allocator;
+
+public:
+    typedef T value_type;
+    typedef boost::interprocess::offset_ptr<T> pointer;
+    typedef boost::interprocess::offset_ptr<const T> const_pointer;
+    typedef size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind {
+        typedef shm_arena_allocator<U> other;
+    };
+
+    template<typename U>
+    shm_arena_allocator(const boost::interprocess::allocator<U, managed_shm::segment_manager> &alloc)
+    : m_arena(ShmArena::of(alloc.get_segment_manager()))
+    {}
+    template<typename U>
+    shm_arena_allocator(const shm_arena_allocator<U> &other): m_arena(other.m_arena)
+    {}
+    shm_arena_allocator(const shm_arena_allocator &other): m_arena(other.m_arena) {}
+    shm_arena_allocator &operator=(const shm_arena_allocator &other)
+    {
+        m_arena = other.m_arena;
+        return *this;
+    }
+
+    pointer allocate(size_type n) { return pointer(static_cast<T *>(m_arena->allocate(n * sizeof(T)))); }
+    void deallocate(const pointer &p, size_type n) { m_arena->deallocate(p.get(), n * sizeof(T)); }
+
+    bool operator==(const shm_arena_allocator &other) const { return m_arena == other.m_arena; }
+    bool operator!=(const shm_arena_allocator &other) const { return m_arena != other.m_arena; }
+
+private:
+    boost::interprocess::offset_ptr<ShmArena> m_arena;
+};
+
+} // namespace vistle
+
+#endif
+#endif
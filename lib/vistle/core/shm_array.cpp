@@ -6,7 +6,7 @@
 
 namespace vistle {
 
-#define SHMARR(T) template class shm_array<T, shm_allocator<T>>;
+#define SHMARR(T) template class shm_array<T, shm_array_allocator<T>>;
 
 FOR_ALL_SCALARS(SHMARR)
 SHMARR(CelltreeNode1)
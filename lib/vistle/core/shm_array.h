@@ -11,6 +11,7 @@
 //#include "archives_config.h"
 #include "shmdata.h"
 #include "shm_config.h"
+#include "shm_arena.h"
 #include "scalars.h"
 #include "celltreenode_decl.h"
 
@@ -115,7 +116,7 @@ private:
     shm_array &operator=(const shm_array &rhs) = delete;
 };
 
-#define SHMARR_EXPORT(T) extern template class V_COREEXPORT shm_array<T, shm_allocator<T>>;
+#define SHMARR_EXPORT(T) extern template class V_COREEXPORT shm_array<T, shm_array_allocator<T>>;
 
 FOR_ALL_SCALARS(SHMARR_EXPORT)
 #if 0
@@ -29,9 +29,16 @@ typedef managed_shm::handle_t shm_handle_t;
 #ifdef NO_SHMEM
 template<typename T>
 using shm_allocator = vistle::default_init_allocator<T>;
+template<typename T>
+using shm_array_allocator = shm_allocator<T>;
 #else
 template<typename T>
 using shm_allocator = boost::interprocess::allocator<T, managed_shm::segment_manager>;
+template<typename T>
+class shm_arena_allocator;
+//! allocator for array storage, see shm_arena.h
+template<typename T>
+using shm_array_allocator = shm_arena_allocator<T>;
 #endif
 
 } // namespace vistle
@@ -31,7 +31,7 @@ int shm_array<T, allocator>::typeId()
 template<typename T>
 const ShmVector<T> Shm::getArrayFromName(const std::string &name) const
 {
-    typedef vistle::shm_array<T, typename vistle::shm<T>::allocator> array;
+    typedef vistle::shm_array<T, typename vistle::shm<T>::array_allocator> array;
 
     if (name.empty()) {
         return vistle::shm_array_ref<array>();
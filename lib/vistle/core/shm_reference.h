@@ -161,62 +161,62 @@ private:
 #ifdef USE_BOOST_ARCHIVE
 #ifdef USE_YAS
 #define V_DECLARE_SHMREF(T) \
-    extern template class V_COREEXPORT shm_array_ref<shm_array<T, typename shm<T>::allocator>>; \
+    extern template class V_COREEXPORT shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>; \
     extern template void V_COREEXPORT \
-        shm_array_ref<shm_array<T, typename shm<T>::allocator>>::load<vistle::yas_iarchive>(vistle::yas_iarchive & \
+        shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::load<vistle::yas_iarchive>(vistle::yas_iarchive & \
                                                                                             ar); \
     extern template void V_COREEXPORT \
-        shm_array_ref<shm_array<T, typename shm<T>::allocator>>::load<vistle::boost_iarchive>(vistle::boost_iarchive & \
+        shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::load<vistle::boost_iarchive>(vistle::boost_iarchive & \
                                                                                               ar); \
     extern template void V_COREEXPORT \
-        shm_array_ref<shm_array<T, typename shm<T>::allocator>>::save<vistle::yas_oarchive>(vistle::yas_oarchive & ar) \
+        shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::save<vistle::yas_oarchive>(vistle::yas_oarchive & ar) \
             const; \
     extern template void V_COREEXPORT \
-        shm_array_ref<shm_array<T, typename shm<T>::allocator>>::save<vistle::boost_oarchive>(vistle::boost_oarchive & \
+        shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::save<vistle::boost_oarchive>(vistle::boost_oarchive & \
                                                                                               ar) const;
 
 #define V_DEFINE_SHMREF(T) \
-    template class shm_array_ref<shm_array<T, typename shm<T>::allocator>>; \
-    template void shm_array_ref<shm_array<T, typename shm<T>::allocator>>::load<vistle::yas_iarchive>( \
+    template class shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>; \
+    template void shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::load<vistle::yas_iarchive>( \
         vistle::yas_iarchive & ar); \
-    template void shm_array_ref<shm_array<T, typename shm<T>::allocator>>::load<vistle::boost_iarchive>( \
+    template void shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::load<vistle::boost_iarchive>( \
         vistle::boost_iarchive & ar); \
-    template void shm_array_ref<shm_array<T, typename shm<T>::allocator>>::save<vistle::yas_oarchive>( \
+    template void shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::save<vistle::yas_oarchive>( \
         vistle::yas_oarchive & ar) const; \
-    template void shm_array_ref<shm_array<T, typename shm<T>::allocator>>::save<vistle::boost_oarchive>( \
+    template void shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::save<vistle::boost_oarchive>( \
         vistle::boost_oarchive & ar) const;
 #else
 #define V_DECLARE_SHMREF(T) \
-    extern template class V_COREEXPORT shm_array_ref<shm_array<T, typename shm<T>::allocator>>; \
+    extern template class V_COREEXPORT shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>; \
     extern template void V_COREEXPORT \
-        shm_array_ref<shm_array<T, typename shm<T>::allocator>>::load<vistle::boost_iarchive>(vistle::boost_iarchive & \
+        shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::load<vistle::boost_iarchive>(vistle::boost_iarchive & \
                                                                                               ar); \
     extern template void V_COREEXPORT \
-        shm_array_ref<shm_array<T, typename shm<T>::allocator>>::save<vistle::boost_oarchive>(vistle::boost_oarchive & \
+        shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::save<vistle::boost_oarchive>(vistle::boost_oarchive & \
                                                                                               ar) const;
 
 #define V_DEFINE_SHMREF(T) \
-    template class shm_array_ref<shm_array<T, typename shm<T>::allocator>>; \
-    template void shm_array_ref<shm_array<T, typename shm<T>::allocator>>::load<vistle::boost_iarchive>( \
+    template class shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>; \
+    template void shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::load<vistle::boost_iarchive>( \
         vistle::boost_iarchive & ar); \
-    template void shm_array_ref<shm_array<T, typename shm<T>::allocator>>::save<vistle::boost_oarchive>( \
+    template void shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::save<vistle::boost_oarchive>( \
         vistle::boost_oarchive & ar) const;
 #endif
 #else
 #define V_DECLARE_SHMREF(T) \
-    extern template class V_COREEXPORT shm_array_ref<shm_array<T, typename shm<T>::allocator>>; \
+    extern template class V_COREEXPORT shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>; \
     extern template void V_COREEXPORT \
-        shm_array_ref<shm_array<T, typename shm<T>::allocator>>::load<vistle::yas_iarchive>(vistle::yas_iarchive & \
+        shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::load<vistle::yas_iarchive>(vistle::yas_iarchive & \
                                                                                             ar); \
     extern template void V_COREEXPORT \
-        shm_array_ref<shm_array<T, typename shm<T>::allocator>>::save<vistle::yas_oarchive>(vistle::yas_oarchive & ar) \
+        shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::save<vistle::yas_oarchive>(vistle::yas_oarchive & ar) \
             const;
 
 #define V_DEFINE_SHMREF(T) \
-    template class shm_array_ref<shm_array<T, typename shm<T>::allocator>>; \
-    template void shm_array_ref<shm_array<T, typename shm<T>::allocator>>::load<vistle::yas_iarchive>( \
+    template class shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>; \
+    template void shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::load<vistle::yas_iarchive>( \
         vistle::yas_iarchive & ar); \
-    template void shm_array_ref<shm_array<T, typename shm<T>::allocator>>::save<vistle::yas_oarchive>( \
+    template void shm_array_ref<shm_array<T, typename shm<T>::array_allocator>>::save<vistle::yas_oarchive>( \
         vistle::yas_oarchive & ar) const;
 #endif
 
@@ -500,7 +500,7 @@ bool StateTracker::handle(const message::Message &msg, const char *payload, size
     m_aggregatedPayload += msg.payloadSize();
 
 #ifndef NDEBUG
-    if (msg.type() != message::ADDOBJECT && msg.uuid() != msg.referrer()) {
+    if (msg.type() != message::ADDOBJECT && msg.type() != message::ADDOBJECTS && msg.uuid() != msg.referrer()) {
         if (m_alreadySeen.find(msg.uuid()) != m_alreadySeen.end()) {
             CERR << "duplicate message: " << msg << std::endl;
         }
@@ -585,6 +585,9 @@ bool StateTracker::handle(const message::Message &msg, const char *payload, size
     case ADDOBJECTCOMPLETED: {
         break;
     }
+    case ADDOBJECTS: {
+        break;
+    }
     case ADDPORT: {
         const auto &ap = msg.as<AddPort>();
         handled = handlePriv(ap);
@@ -277,6 +277,11 @@ Index StructuredGrid::findCell(const Vector3 &point, Index hint, int flags) cons
     return InvalidIndex;
 }
 
+void StructuredGrid::findCells(Index numPoints, const Vector3 *points, Index *cells, const Index *hints, int flags) const
+{
+    findCellsOfGrid(this, numPoints, points, cells, hints, flags);
+}
+
 // INSIDE CHECK
 //-------------------------------------------------------------------------
 bool StructuredGrid::inside(Index elem, const Vector3 &point) const
@@ -391,25 +396,26 @@ GridInterface::Interpolator StructuredGrid::getInterpolator(Index elem, const Ve
 #endif
 
     if (mapping == Element) {
-        std::vector<Scalar> weights(1, 1.);
-        std::vector<Index> indices(1, elem);
-
-        return Interpolator(weights, indices);
+        Interpolator interp(1);
+        interp.weights()[0] = 1;
+        interp.indices()[0] = elem;
+        return interp;
     }
 
     auto cl = cellVertices(elem, m_numDivisions);
     Index nvert = cl.size();
 
     const Scalar *x[3] = {&this->x()[0], &this->y()[0], &this->z()[0]};
-    std::vector<Vector3> corners(nvert);
+    Vector3 corners[8];
     for (Index i = 0; i < nvert; ++i) {
         corners[i][0] = x[0][cl[i]];
         corners[i][1] = x[1][cl[i]];
         corners[i][2] = x[2][cl[i]];
     }
 
-    std::vector<Index> indices((mode == Linear || mode == Mean) ? nvert : 1);
-    std::vector<Scalar> weights((mode == Linear || mode == Mean) ? nvert : 1);
+    Interpolator interp((mode == Linear || mode == Mean) ? nvert : 1);
+    Scalar *weights = interp.weights();
+    Index *indices = interp.indices();
 
     if (mode == Mean) {
         const Scalar w = Scalar(1) / nvert;
@@ -422,15 +428,8 @@ GridInterface::Interpolator StructuredGrid::getInterpolator(Index elem, const Ve
         for (Index i = 0; i < nvert; ++i) {
             indices[i] = cl[i];
         }
-        const Vector3 ss = trilinearInverse(point, corners.data());
-        weights[0] = (1 - ss[0]) * (1 - ss[1]) * (1 - ss[2]);
-        weights[1] = ss[0] * (1 - ss[1]) * (1 - ss[2]);
-        weights[2] = ss[0] * ss[1] * (1 - ss[2]);
-        weights[3] = (1 - ss[0]) * ss[1] * (1 - ss[2]);
-        weights[4] = (1 - ss[0]) * (1 - ss[1]) * ss[2];
-        weights[5] = ss[0] * (1 - ss[1]) * ss[2];
-        weights[6] = ss[0] * ss[1] * ss[2];
-        weights[7] = (1 - ss[0]) * ss[1] * ss[2];
+        const Vector3 ss = trilinearInverse(point, corners);
+        trilinearWeights(ss, weights);
     } else {
         weights[0] = 1;
 
@@ -451,7 +450,44 @@ GridInterface::Interpolator StructuredGrid::getInterpolator(Index elem, const Ve
         }
     }
 
-    return Interpolator(weights, indices);
+    return interp;
+}
+
+void StructuredGrid::interpolate(Index numPoints, const Index *cells, const Scalar *const x[3], int numComponents,
+                                 const Scalar *const field[], Scalar *const out[], DataBase::Mapping mapping,
+                                 InterpolationMode mode) const
+{
+    if (mapping == DataBase::Element || mode != Linear) {
+        GridInterface::interpolate(numPoints, cells, x, numComponents, field, out, mapping, mode);
+        return;
+    }
+
+    const Scalar *coords[3] = {&this->x()[0], &this->y()[0], &this->z()[0]};
+    Vector3 corners[8];
+    Scalar w[8];
+    for (Index i = 0; i < numPoints; ++i) {
+        const Index elem = cells[i];
+        if (elem == InvalidIndex) {
+            for (int c = 0; c < numComponents; ++c)
+                out[c][i] = Scalar(0);
+            continue;
+        }
+
+        const auto cl = cellVertices(elem, m_numDivisions);
+        for (int k = 0; k < 8; ++k) {
+            for (int c = 0; c < 3; ++c)
+                corners[k][c] = coords[c][cl[k]];
+        }
+        const Vector3 ss = trilinearInverse(Vector3(x[0][i], x[1][i], x[2][i]), corners);
+        trilinearWeights(ss, w);
+        for (int c = 0; c < numComponents; ++c) {
+            const Scalar *f = field[c];
+            Scalar v(0);
+            for (int k = 0; k < 8; ++k)
+                v += f[cl[k]] * w[k];
+            out[c][i] = v;
+        }
+    }
 }
 
 void StructuredGrid::Data::initData()
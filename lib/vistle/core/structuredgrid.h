@@ -49,9 +49,14 @@ public:
     void setNormals(Normals::const_ptr normals) override;
     std::pair<Vector3, Vector3> cellBounds(Index elem) const override;
     Index findCell(const Vector3 &point, Index hint = InvalidIndex, int flags = NoFlags) const override;
+    void findCells(Index numPoints, const Vector3 *points, Index *cells, const Index *hints = nullptr,
+                   int flags = NoFlags) const override;
     bool inside(Index elem, const Vector3 &point) const override;
     Interpolator getInterpolator(Index elem, const Vector3 &point, DataBase::Mapping mapping = DataBase::Vertex,
                                  InterpolationMode mode = Linear) const override;
+    void interpolate(Index numPoints, const Index *cells, const Scalar *const x[3], int numComponents,
+                     const Scalar *const field[], Scalar *const out[], DataBase::Mapping mapping = DataBase::Vertex,
+                     InterpolationMode mode = Linear) const override;
 
     bool hasCelltree() const override;
     Celltree::const_ptr getCelltree() const override;
@@ -115,6 +115,18 @@ public:
         }
         return cl;
     }
+    //! trilinear weights for vertices in the order of cellVertices from local coordinates ss within cell
+    static inline void trilinearWeights(const Vector3 &ss, Scalar w[8])
+    {
+        w[0] = (1 - ss[0]) * (1 - ss[1]) * (1 - ss[2]);
+        w[1] = ss[0] * (1 - ss[1]) * (1 - ss[2]);
+        w[2] = ss[0] * ss[1] * (1 - ss[2]);
+        w[3] = (1 - ss[0]) * ss[1] * (1 - ss[2]);
+        w[4] = (1 - ss[0]) * (1 - ss[1]) * ss[2];
+        w[5] = ss[0] * (1 - ss[1]) * ss[2];
+        w[6] = ss[0] * ss[1] * ss[2];
+        w[7] = (1 - ss[0]) * ss[1] * ss[2];
+    }
 
     virtual bool isGhostCell(Index elem) const override;
 
@@ -252,10 +252,10 @@ GridInterface::Interpolator UniformGrid::getInterpolator(Index elem, const Vecto
 #endif
 
     if (mapping == DataBase::Element) {
-        std::vector<Scalar> weights(1, 1.);
-        std::vector<Index> indices(1, elem);
-
-        return Interpolator(weights, indices);
+        Interpolator interp(1);
+        interp.weights()[0] = 1;
+        interp.indices()[0] = elem;
+        return interp;
     }
 
     std::array<Index, 3> n = cellCoordinates(elem, m_numDivisions);
@@ -265,8 +265,9 @@ GridInterface::Interpolator UniformGrid::getInterpolator(Index elem, const Vecto
     const Vector3 diff = point - corner;
 
     const Index nvert = cl.size();
-    std::vector<Index> indices((mode == Linear || mode == Mean) ? nvert : 1);
-    std::vector<Scalar> weights((mode == Linear || mode == Mean) ? nvert : 1);
+    Interpolator interp((mode == Linear || mode == Mean) ? nvert : 1);
+    Scalar *weights = interp.weights();
+    Index *indices = interp.indices();
 
     if (mode == Mean) {
         const Scalar w = Scalar(1) / nvert;
@@ -285,14 +286,7 @@ GridInterface::Interpolator UniformGrid::getInterpolator(Index elem, const Vecto
             assert(ss[c] >= 0.0);
             assert(ss[c] <= 1.0);
         }
-        weights[0] = (1 - ss[0]) * (1 - ss[1]) * (1 - ss[2]);
-        weights[1] = ss[0] * (1 - ss[1]) * (1 - ss[2]);
-        weights[2] = ss[0] * ss[1] * (1 - ss[2]);
-        weights[3] = (1 - ss[0]) * ss[1] * (1 - ss[2]);
-        weights[4] = (1 - ss[0]) * (1 - ss[1]) * ss[2];
-        weights[5] = ss[0] * (1 - ss[1]) * ss[2];
-        weights[6] = ss[0] * ss[1] * ss[2];
-        weights[7] = (1 - ss[0]) * ss[1] * ss[2];
+        trilinearWeights(ss, weights);
     } else {
         weights[0] = 1;
 
@@ -311,7 +305,42 @@ GridInterface::Interpolator UniformGrid::getInterpolator(Index elem, const Vecto
         }
     }
 
-    return Interpolator(weights, indices);
+    return interp;
+}
+
+void UniformGrid::interpolate(Index numPoints, const Index *cells, const Scalar *const x[3], int numComponents,
+                              const Scalar *const field[], Scalar *const out[], DataBase::Mapping mapping,
+                              InterpolationMode mode) const
+{
+    if (mapping == DataBase::Element || mode != Linear) {
+        GridInterface::interpolate(numPoints, cells, x, numComponents, field, out, mapping, mode);
+        return;
+    }
+
+    // closed-form weights, cell size is constant
+    Scalar w[8];
+    for (Index i = 0; i < numPoints; ++i) {
+        const Index elem = cells[i];
+        if (elem == InvalidIndex) {
+            for (int c = 0; c < numComponents; ++c)
+                out[c][i] = Scalar(0);
+            continue;
+        }
+
+        const auto n = cellCoordinates(elem, m_numDivisions);
+        const auto cl = cellVertices(elem, m_numDivisions);
+        Vector3 ss;
+        for (int c = 0; c < 3; ++c)
+            ss[c] = (x[c][i] - m_min[c] - n[c] * m_dist[c]) / m_dist[c];
+        trilinearWeights(ss, w);
+        for (int c = 0; c < numComponents; ++c) {
+            const Scalar *f = field[c];
+            Scalar v(0);
+            for (int k = 0; k < 8; ++k)
+                v += f[cl[k]] * w[k];
+            out[c][i] = v;
+        }
+    }
 }
 
 void UniformGrid::Data::initData()
@@ -58,6 +58,9 @@ public:
     bool inside(Index elem, const Vector3 &point) const override;
     Interpolator getInterpolator(Index elem, const Vector3 &point, DataBase::Mapping mapping = DataBase::Vertex,
                                  InterpolationMode mode = Linear) const override;
+    void interpolate(Index numPoints, const Index *cells, const Scalar *const x[3], int numComponents,
+                     const Scalar *const field[], Scalar *const out[], DataBase::Mapping mapping = DataBase::Vertex,
+                     InterpolationMode mode = Linear) const override;
     Scalar exitDistance(Index elem, const Vector3 &point, const Vector3 &dir) const override;
     Vector3 getVertex(Index v) const override;
 
@@ -343,6 +343,11 @@ Index UnstructuredGrid::findCell(const Vector3 &point, Index hint, int flags) co
     return InvalidIndex;
 }
 
+void UnstructuredGrid::findCells(Index numPoints, const Vector3 *points, Index *cells, const Index *hints, int flags) const
+{
+    findCellsOfGrid(this, numPoints, points, cells, hints, flags);
+}
+
 namespace {
 
 
@@ -608,6 +613,104 @@ bool UnstructuredGrid::inside(Index elem, const Vector3 &point) const
     return insideCell(point, type, end - begin, cl, &this->x()[0], &this->y()[0], &this->z()[0]);
 }
 
+// multilinear interpolation weights for cells with at most 8 vertices, weights correspond to cell vertices in order
+static bool linearWeights(Byte type, Index nvert, const Index *cl, const Scalar *const x[3], const Vector3 &point,
+                          Scalar *weights)
+{
+    switch (type) {
+    case UnstructuredGrid::TETRAHEDRON: {
+        assert(nvert == 4);
+        Vector3 coord[4];
+        for (int i = 0; i < 4; ++i) {
+            const Index ind = cl[i];
+            for (int c = 0; c < 3; ++c) {
+                coord[i][c] = x[c][ind];
+            }
+        }
+        Matrix3 T;
+        T << coord[0] - coord[3], coord[1] - coord[3], coord[2] - coord[3];
+        Vector3 w = T.inverse() * (point - coord[3]);
+        weights[3] = 1.;
+        for (int c = 0; c < 3; ++c) {
+            weights[c] = w[c];
+            weights[3] -= w[c];
+        }
+        return true;
+    }
+    case UnstructuredGrid::PYRAMID: {
+        assert(nvert == 5);
+        Vector3 coord[5];
+        for (int i = 0; i < 5; ++i) {
+            const Index ind = cl[i];
+            for (int c = 0; c < 3; ++c) {
+                coord[i][c] = x[c][ind];
+            }
+        }
+        const Vector3 first(coord[1] - coord[0]);
+        Vector3 normal(0, 0, 0);
+        for (int i = 2; i < 4; ++i) {
+            normal += cross(first, coord[i] - coord[i - 1]);
+        }
+        const Vector3 top = coord[4] - coord[0];
+        const Scalar h = normal.dot(top);
+        const Scalar hp = normal.dot(point - coord[0]);
+        weights[4] = hp / h;
+        const Scalar w = 1 - weights[4];
+        const Vector3 p = (point - weights[4] * coord[4]) / w;
+        const Vector2 ss = bilinearInverse(p, coord);
+        weights[0] = (1 - ss[0]) * (1 - ss[1]) * w;
+        weights[1] = ss[0] * (1 - ss[1]) * w;
+        weights[2] = ss[0] * ss[1] * w;
+        weights[3] = (1 - ss[0]) * ss[1] * w;
+        return true;
+    }
+    case UnstructuredGrid::PRISM: {
+        assert(nvert == 6);
+        Vector3 coord[8];
+        for (int i = 0; i < 3; ++i) {
+            const Index ind1 = cl[i];
+            const Index ind2 = cl[i + 3];
+            for (int c = 0; c < 3; ++c) {
+                coord[i][c] = x[c][ind1];
+                coord[i + 4][c] = x[c][ind2];
+            }
+        }
+        // we interpolate in a hexahedron with coinciding corners
+        coord[3] = coord[2];
+        coord[7] = coord[6];
+        const Vector3 ss = trilinearInverse(point, coord);
+        weights[0] = (1 - ss[0]) * (1 - ss[1]) * (1 - ss[2]);
+        weights[1] = ss[0] * (1 - ss[1]) * (1 - ss[2]);
+        weights[2] = ss[1] * (1 - ss[2]);
+        weights[3] = (1 - ss[0]) * (1 - ss[1]) * ss[2];
+        weights[4] = ss[0] * (1 - ss[1]) * ss[2];
+        weights[5] = ss[1] * ss[2];
+        return true;
+    }
+    case UnstructuredGrid::HEXAHEDRON: {
+        assert(nvert == 8);
+        Vector3 coord[8];
+        for (int i = 0; i < 8; ++i) {
+            const Index ind = cl[i];
+            for (int c = 0; c < 3; ++c) {
+                coord[i][c] = x[c][ind];
+            }
+        }
+        const Vector3 ss = trilinearInverse(point, coord);
+        weights[0] = (1 - ss[0]) * (1 - ss[1]) * (1 - ss[2]);
+        weights[1] = ss[0] * (1 - ss[1]) * (1 - ss[2]);
+        weights[2] = ss[0] * ss[1] * (1 - ss[2]);
+        weights[3] = (1 - ss[0]) * ss[1] * (1 - ss[2]);
+        weights[4] = (1 - ss[0]) * (1 - ss[1]) * ss[2];
+        weights[5] = ss[0] * (1 - ss[1]) * ss[2];
+        weights[6] = ss[0] * ss[1] * ss[2];
+        weights[7] = (1 - ss[0]) * ss[1] * ss[2];
+        return true;
+    }
+    }
+    return false;
+}
+
 GridInterface::Interpolator UnstructuredGrid::getInterpolator(Index elem, const Vector3 &point, Mapping mapping,
                                                               InterpolationMode mode) const
 {
@@ -620,10 +723,10 @@ GridInterface::Interpolator UnstructuredGrid::getInterpolator(Index elem, const
 #endif
 
     if (mapping == Element) {
-        std::vector<Scalar> weights(1, 1.);
-        std::vector<Index> indices(1, elem);
-
-        return Interpolator(weights, indices);
+        Interpolator interp(1);
+        interp.weights()[0] = 1;
+        interp.indices()[0] = elem;
+        return interp;
     }
 
     const auto el = &this->el()[0];
@@ -632,315 +735,245 @@ GridInterface::Interpolator UnstructuredGrid::getInterpolator(Index elem, const
     const Scalar *x[3] = {&this->x()[0], &this->y()[0], &this->z()[0]};
 
     const Index nvert = el[elem + 1] - el[elem];
-    std::vector<Scalar> weights((mode == Linear || mode == Mean) ? nvert : 1);
-    std::vector<Index> indices((mode == Linear || mode == Mean) ? nvert : 1);
+    if ((tl[elem] & TYPE_MASK) == POLYHEDRON) {
+        if (mode == Mean) {
+            std::vector<Index> indices = cellVertices(elem);
+            std::vector<Scalar> weights(indices.size(), Scalar(1) / indices.size());
+            return Interpolator(weights, indices);
+        } else if (mode == Linear) {
+            return polyhedronInterpolator(elem, point);
+        }
+    }
+
+    Interpolator interp((mode == Linear || mode == Mean) ? nvert : 1);
+    Scalar *weights = interp.weights();
+    Index *indices = interp.indices();
 
     if (mode == Mean) {
-        if ((tl[elem] & TYPE_MASK) == POLYHEDRON) {
-            indices = cellVertices(elem);
-            const Index n = indices.size();
-            Scalar w = Scalar(1) / n;
-            weights.resize(n, w);
-        } else {
-            const Scalar w = Scalar(1) / nvert;
-            for (Index i = 0; i < nvert; ++i) {
-                indices[i] = cl[i];
-                weights[i] = w;
-            }
+        const Scalar w = Scalar(1) / nvert;
+        for (Index i = 0; i < nvert; ++i) {
+            indices[i] = cl[i];
+            weights[i] = w;
         }
     } else if (mode == Linear) {
         switch (tl[elem] & TYPE_MASK) {
-        case TETRAHEDRON: {
-            assert(nvert == 4);
-            Vector3 coord[4];
-            for (int i = 0; i < 4; ++i) {
-                const Index ind = cl[i];
-                indices[i] = ind;
-                for (int c = 0; c < 3; ++c) {
-                    coord[i][c] = x[c][ind];
-                }
-            }
-            Matrix3 T;
-            T << coord[0] - coord[3], coord[1] - coord[3], coord[2] - coord[3];
-            Vector3 w = T.inverse() * (point - coord[3]);
-            weights[3] = 1.;
-            for (int c = 0; c < 3; ++c) {
-                weights[c] = w[c];
-                weights[3] -= w[c];
-            }
-            break;
-        }
-        case PYRAMID: {
-            assert(nvert == 5);
-            Vector3 coord[5];
-            for (int i = 0; i < 5; ++i) {
-                const Index ind = cl[i];
-                indices[i] = ind;
-                for (int c = 0; c < 3; ++c) {
-                    coord[i][c] = x[c][ind];
-                }
-            }
-            const Vector3 first(coord[1] - coord[0]);
-            Vector3 normal(0, 0, 0);
-            for (int i = 2; i < 4; ++i) {
-                normal += cross(first, coord[i] - coord[i - 1]);
-            }
-            const Vector3 top = coord[4] - coord[0];
-            const Scalar h = normal.dot(top);
-            const Scalar hp = normal.dot(point - coord[0]);
-            weights[4] = hp / h;
-            const Scalar w = 1 - weights[4];
-            const Vector3 p = (point - weights[4] * coord[4]) / w;
-            const Vector2 ss = bilinearInverse(p, coord);
-            weights[0] = (1 - ss[0]) * (1 - ss[1]) * w;
-            weights[1] = ss[0] * (1 - ss[1]) * w;
-            weights[2] = ss[0] * ss[1] * w;
-            weights[3] = (1 - ss[0]) * ss[1] * w;
+        case TETRAHEDRON:
+        case PYRAMID:
+        case PRISM:
+        case HEXAHEDRON: {
+            for (Index i = 0; i < nvert; ++i)
+                indices[i] = cl[i];
+            linearWeights(tl[elem] & TYPE_MASK, nvert, cl, x, point, weights);
             break;
         }
-        case PRISM: {
-            assert(nvert == 6);
-            Vector3 coord[8];
-            for (int i = 0; i < 3; ++i) {
-                const Index ind1 = cl[i];
-                const Index ind2 = cl[i + 3];
-                indices[i] = ind1;
-                indices[i + 3] = ind2;
-                for (int c = 0; c < 3; ++c) {
-                    coord[i][c] = x[c][ind1];
-                    coord[i + 4][c] = x[c][ind2];
-                }
-            }
-            // we interpolate in a hexahedron with coinciding corners
-            coord[3] = coord[2];
-            coord[7] = coord[6];
-            const Vector3 ss = trilinearInverse(point, coord);
-            weights[0] = (1 - ss[0]) * (1 - ss[1]) * (1 - ss[2]);
-            weights[1] = ss[0] * (1 - ss[1]) * (1 - ss[2]);
-            weights[2] = ss[1] * (1 - ss[2]);
-            weights[3] = (1 - ss[0]) * (1 - ss[1]) * ss[2];
-            weights[4] = ss[0] * (1 - ss[1]) * ss[2];
-            weights[5] = ss[1] * ss[2];
-            break;
         }
-        case HEXAHEDRON: {
-            assert(nvert == 8);
-            Vector3 coord[8];
-            for (int i = 0; i < 8; ++i) {
-                const Index ind = cl[i];
-                indices[i] = ind;
-                for (int c = 0; c < 3; ++c) {
-                    coord[i][c] = x[c][ind];
+    } else {
+        weights[0] = 1;
+
+        if (mode == First) {
+            indices[0] = cl[0];
+        } else if (mode == Nearest) {
+            Scalar mindist = std::numeric_limits<Scalar>::max();
+
+            // also for POLYHEDRON
+            for (Index i = 0; i < nvert; ++i) {
+                const Index k = cl[i];
+                const Vector3 vert(x[0][k], x[1][k], x[2][k]);
+                const Scalar dist = (point - vert).squaredNorm();
+                if (dist < mindist) {
+                    mindist = dist;
+                    indices[0] = k;
                 }
             }
-            const Vector3 ss = trilinearInverse(point, coord);
-            weights[0] = (1 - ss[0]) * (1 - ss[1]) * (1 - ss[2]);
-            weights[1] = ss[0] * (1 - ss[1]) * (1 - ss[2]);
-            weights[2] = ss[0] * ss[1] * (1 - ss[2]);
-            weights[3] = (1 - ss[0]) * ss[1] * (1 - ss[2]);
-            weights[4] = (1 - ss[0]) * (1 - ss[1]) * ss[2];
-            weights[5] = ss[0] * (1 - ss[1]) * ss[2];
-            weights[6] = ss[0] * ss[1] * ss[2];
-            weights[7] = (1 - ss[0]) * ss[1] * ss[2];
-            break;
         }
-        case POLYHEDRON: {
-            /* subdivide n-hedron into n pyramids with tip at the center,
-               interpolate within pyramid containing point */
-
-            // polyhedron compute center
-            std::vector<Index> verts = cellVertices(elem);
-            Vector3 center(0, 0, 0);
-            for (auto v: verts) {
-                Vector3 c(x[0][v], x[1][v], x[2][v]);
-                center += c;
-            }
-            center /= verts.size();
+    }
+
+    return interp;
+}
+
+GridInterface::Interpolator UnstructuredGrid::polyhedronInterpolator(Index elem, const Vector3 &point) const
+{
+    const auto el = &this->el()[0];
+    const auto cl = &this->cl()[el[elem]];
+    const Scalar *x[3] = {&this->x()[0], &this->y()[0], &this->z()[0]};
+
+    const Index nvert = el[elem + 1] - el[elem];
+    std::vector<Scalar> weights(nvert);
+    std::vector<Index> indices(nvert);
+
+    /* subdivide n-hedron into n pyramids with tip at the center,
+       interpolate within pyramid containing point */
+
+    // polyhedron compute center
+    std::vector<Index> verts = cellVertices(elem);
+    Vector3 center(0, 0, 0);
+    for (auto v: verts) {
+        Vector3 c(x[0][v], x[1][v], x[2][v]);
+        center += c;
+    }
+    center /= verts.size();
 #ifdef INTERPOL_DEBUG
-            std::cerr << "center: " << center.transpose() << std::endl;
-            assert(inside(elem, center));
+    std::cerr << "center: " << center.transpose() << std::endl;
+    assert(inside(elem, center));
 #endif
 
-            std::vector<Vector3> coord(nvert);
-            Index nfaces = 0;
-            Index n = 0;
-            Index facestart = InvalidIndex;
-            Index term = 0;
-            for (Index i = 0; i < nvert; ++i) {
-                if (facestart == InvalidIndex) {
-                    facestart = i;
-                    term = cl[i];
-                } else if (cl[i] == term) {
-                    const Index N = i - facestart;
-                    ++nfaces;
-                    for (Index k = facestart; k < facestart + N; ++k) {
-                        indices[n] = cl[k];
-                        for (int c = 0; c < 3; ++c) {
-                            coord[n][c] = x[c][cl[k]];
-                        }
-                        ++n;
-                    }
-                    facestart = InvalidIndex;
+    std::vector<Vector3> coord(nvert);
+    Index nfaces = 0;
+    Index n = 0;
+    Index facestart = InvalidIndex;
+    Index term = 0;
+    for (Index i = 0; i < nvert; ++i) {
+        if (facestart == InvalidIndex) {
+            facestart = i;
+            term = cl[i];
+        } else if (cl[i] == term) {
+            const Index N = i - facestart;
+            ++nfaces;
+            for (Index k = facestart; k < facestart + N; ++k) {
+                indices[n] = cl[k];
+                for (int c = 0; c < 3; ++c) {
+                    coord[n][c] = x[c][cl[k]];
                 }
+                ++n;
             }
-            Index ncoord = n;
-            coord.resize(ncoord);
-            weights.resize(ncoord);
-
-            // find face that is hit by ray from polyhedron center through query point
-            Scalar scale = 0;
-            Vector3 isect;
-            bool foundFace = false;
-            n = 0;
-            Index nFaceVert = 0;
-            Vector3 faceCenter(0, 0, 0);
             facestart = InvalidIndex;
-            term = 0;
-            for (Index i = 0; i < nvert; ++i) {
-                if (facestart == InvalidIndex) {
-                    facestart = i;
-                    term = cl[i];
-                } else if (term == cl[i]) {
-                    nFaceVert = i - facestart;
-                    auto nc = faceNormalAndCenter(nFaceVert, &cl[facestart], x[0], x[1], x[2]);
-                    const Vector3 dir = point - center;
-                    Vector3 normal = nc.first;
-                    faceCenter = nc.second;
-                    scale = normal.dot(dir) / normal.dot(faceCenter - center);
+        }
+    }
+    Index ncoord = n;
+    coord.resize(ncoord);
+    weights.resize(ncoord);
+
+    // find face that is hit by ray from polyhedron center through query point
+    Scalar scale = 0;
+    Vector3 isect;
+    bool foundFace = false;
+    n = 0;
+    Index nFaceVert = 0;
+    Vector3 faceCenter(0, 0, 0);
+    facestart = InvalidIndex;
+    term = 0;
+    for (Index i = 0; i < nvert; ++i) {
+        if (facestart == InvalidIndex) {
+            facestart = i;
+            term = cl[i];
+        } else if (term == cl[i]) {
+            nFaceVert = i - facestart;
+            auto nc = faceNormalAndCenter(nFaceVert, &cl[facestart], x[0], x[1], x[2]);
+            const Vector3 dir = point - center;
+            Vector3 normal = nc.first;
+            faceCenter = nc.second;
+            scale = normal.dot(dir) / normal.dot(faceCenter - center);
 #ifdef INTERPOL_DEBUG
-                    std::cerr << "face: normal=" << normal.transpose() << ", center=" << faceCenter.transpose()
-                              << ", endvert=" << i << ", numvert=" << nFaceVert << ", scale=" << scale << std::endl;
-                    assert(scale <= 1.01); // otherwise, point is outside of the polyhedron
+            std::cerr << "face: normal=" << normal.transpose() << ", center=" << faceCenter.transpose()
+                      << ", endvert=" << i << ", numvert=" << nFaceVert << ", scale=" << scale << std::endl;
+            assert(scale <= 1.01); // otherwise, point is outside of the polyhedron
 #endif
-                    if (scale > 1.)
-                        scale = 1;
-                    if (scale >= 0) {
-                        scale = std::min(Scalar(1), scale);
-                        if (scale > 0.001) {
-                            isect = center + dir / scale;
+            if (scale > 1.)
+                scale = 1;
+            if (scale >= 0) {
+                scale = std::min(Scalar(1), scale);
+                if (scale > 0.001) {
+                    isect = center + dir / scale;
 #ifdef INTERPOL_DEBUG
-                            std::cerr << "isect: " << isect.transpose() << std::endl;
+                    std::cerr << "isect: " << isect.transpose() << std::endl;
 #endif
-                            if (insideConvexPolygon(isect, &coord[n], nFaceVert, normal)) {
+                    if (insideConvexPolygon(isect, &coord[n], nFaceVert, normal)) {
 #ifdef INTERPOL_DEBUG
-                                std::cerr << "found face: normal: " << normal.transpose()
-                                          << ", first: " << coord[n].transpose() << ", dir: " << dir.transpose()
-                                          << ", isect: " << isect.transpose() << std::endl;
-                                assert(insidePolygon(isect, &coord[n], nFaceVert, normal));
+                        std::cerr << "found face: normal: " << normal.transpose()
+                                  << ", first: " << coord[n].transpose() << ", dir: " << dir.transpose()
+                                  << ", isect: " << isect.transpose() << std::endl;
+                        assert(insidePolygon(isect, &coord[n], nFaceVert, normal));
 #endif
-                                foundFace = true;
-                                break;
-                            } else {
+                        foundFace = true;
+                        break;
+                    } else {
 #ifdef INTERPOL_DEBUG
-                                assert(!insidePolygon(isect, &coord[n], nFaceVert, normal));
+                        assert(!insidePolygon(isect, &coord[n], nFaceVert, normal));
 #endif
-                            }
-                        } else {
-                            scale = 0;
-                            break;
-                        }
                     }
-                    n += nFaceVert;
-                    facestart = InvalidIndex;
+                } else {
+                    scale = 0;
+                    break;
                 }
             }
-            const Index startIndex = n;
+            n += nFaceVert;
+            facestart = InvalidIndex;
+        }
+    }
+    const Index startIndex = n;
 
-            // compute contribution of polyhedron center
-            Scalar centerWeight = 1 - scale;
-#ifdef INTERPOL_DEBUG
-            std::cerr << "center weight: " << centerWeight << ", scale: " << scale << std::endl;
-#endif
-            Scalar sum = 0;
-            if (centerWeight >= 0.0001) {
-                std::set<Index> usedIndices;
-                for (Index i = 0; i < ncoord; ++i) {
-                    if (!usedIndices.insert(indices[i]).second) {
-                        weights[i] = 0;
-                        continue;
-                    }
-                    Scalar centerDist = (coord[i] - center).norm();
+    // compute contribution of polyhedron center
+    Scalar centerWeight = 1 - scale;
 #ifdef INTERPOL_DEBUG
-                    //std::cerr << "ind " << i << ", centerDist: " << centerDist << std::endl;
+    std::cerr << "center weight: " << centerWeight << ", scale: " << scale << std::endl;
 #endif
-                    if (std::abs(centerDist) > 0) {
-                        weights[i] = 1 / centerDist;
-                        sum += weights[i];
-                    } else {
-                        for (Index j = 0; j < ncoord; ++j) {
-                            weights[j] = 0;
-                        }
-                        weights[i] = 1;
-                        sum = weights[i];
-                        break;
-                    }
-                }
+    Scalar sum = 0;
+    if (centerWeight >= 0.0001) {
+        std::set<Index> usedIndices;
+        for (Index i = 0; i < ncoord; ++i) {
+            if (!usedIndices.insert(indices[i]).second) {
+                weights[i] = 0;
+                continue;
+            }
+            Scalar centerDist = (coord[i] - center).norm();
 #ifdef INTERPOL_DEBUG
-                std::cerr << "sum: " << sum << std::endl;
+            //std::cerr << "ind " << i << ", centerDist: " << centerDist << std::endl;
 #endif
-            }
-
-            if (sum > 0) {
-                for (Index i = 0; i < ncoord; ++i) {
-                    weights[i] *= centerWeight / sum;
-                }
+            if (std::abs(centerDist) > 0) {
+                weights[i] = 1 / centerDist;
+                sum += weights[i];
             } else {
-                for (Index i = 0; i < ncoord; ++i) {
-                    weights[i] = 0;
+                for (Index j = 0; j < ncoord; ++j) {
+                    weights[j] = 0;
                 }
+                weights[i] = 1;
+                sum = weights[i];
+                break;
             }
-
-            if (foundFace) {
-                // contribution of hit face,
-                // interpolate compatible with simple cells for faces with 3 or 4 vertices
-                if (nFaceVert == 3) {
-                    Matrix2 T;
-                    T << (coord[startIndex + 0] - coord[startIndex + 2]).block<2, 1>(0, 0),
-                        (coord[startIndex + 1] - coord[startIndex + 2]).block<2, 1>(0, 0);
-                    Vector2 w = T.inverse() * (isect - coord[startIndex + 2]).block<2, 1>(0, 0);
-                    weights[startIndex] += w[0] * (1 - centerWeight);
-                    weights[startIndex + 1] += w[1] * (1 - centerWeight);
-                    weights[startIndex + 2] += (1 - w[0] - w[1]) * (1 - centerWeight);
-                } else if (nFaceVert == 4) {
-                    Vector2 ss = bilinearInverse(isect, &coord[startIndex]);
-                    weights[startIndex] += (1 - ss[0]) * (1 - ss[1]) * (1 - centerWeight);
-                    weights[startIndex + 1] += ss[0] * (1 - ss[1]) * (1 - centerWeight);
-                    weights[startIndex + 2] += ss[0] * ss[1] * (1 - centerWeight);
-                    weights[startIndex + 3] += (1 - ss[0]) * ss[1] * (1 - centerWeight);
-                } else if (nFaceVert > 0) {
-                    // subdivide face into triangles around faceCenter
-                    Scalar sum = 0;
-                    std::vector<Scalar> fweights(nFaceVert);
-                    for (Index i = 0; i < nFaceVert; ++i) {
-                        Scalar centerDist = (coord[i] - faceCenter).norm();
-                        fweights[i] = 1 / centerDist;
-                        sum += fweights[i];
-                    }
-                    for (Index i = 0; i < nFaceVert; ++i) {
-                        weights[i + startIndex] += fweights[i] / sum * (1 - centerWeight);
-                    }
-                }
-            }
-            break;
         }
+#ifdef INTERPOL_DEBUG
+        std::cerr << "sum: " << sum << std::endl;
+#endif
+    }
+
+    if (sum > 0) {
+        for (Index i = 0; i < ncoord; ++i) {
+            weights[i] *= centerWeight / sum;
         }
     } else {
-        weights[0] = 1;
-
-        if (mode == First) {
-            indices[0] = cl[0];
-        } else if (mode == Nearest) {
-            Scalar mindist = std::numeric_limits<Scalar>::max();
+        for (Index i = 0; i < ncoord; ++i) {
+            weights[i] = 0;
+        }
+    }
 
-            // also for POLYHEDRON
-            for (Index i = 0; i < nvert; ++i) {
-                const Index k = cl[i];
-                const Vector3 vert(x[0][k], x[1][k], x[2][k]);
-                const Scalar dist = (point - vert).squaredNorm();
-                if (dist < mindist) {
-                    mindist = dist;
-                    indices[0] = k;
-                }
+    if (foundFace) {
+        // contribution of hit face,
+        // interpolate compatible with simple cells for faces with 3 or 4 vertices
+        if (nFaceVert == 3) {
+            Matrix2 T;
+            T << (coord[startIndex + 0] - coord[startIndex + 2]).block<2, 1>(0, 0),
+                (coord[startIndex + 1] - coord[startIndex + 2]).block<2, 1>(0, 0);
+            Vector2 w = T.inverse() * (isect - coord[startIndex + 2]).block<2, 1>(0, 0);
+            weights[startIndex] += w[0] * (1 - centerWeight);
+            weights[startIndex + 1] += w[1] * (1 - centerWeight);
+            weights[startIndex + 2] += (1 - w[0] - w[1]) * (1 - centerWeight);
+        } else if (nFaceVert == 4) {
+            Vector2 ss = bilinearInverse(isect, &coord[startIndex]);
+            weights[startIndex] += (1 - ss[0]) * (1 - ss[1]) * (1 - centerWeight);
+            weights[startIndex + 1] += ss[0] * (1 - ss[1]) * (1 - centerWeight);
+            weights[startIndex + 2] += ss[0] * ss[1] * (1 - centerWeight);
+            weights[startIndex + 3] += (1 - ss[0]) * ss[1] * (1 - centerWeight);
+        } else if (nFaceVert > 0) {
+            // subdivide face into triangles around faceCenter
+            Scalar sum = 0;
+            std::vector<Scalar> fweights(nFaceVert);
+            for (Index i = 0; i < nFaceVert; ++i) {
+                Scalar centerDist = (coord[i] - faceCenter).norm();
+                fweights[i] = 1 / centerDist;
+                sum += fweights[i];
+            }
+            for (Index i = 0; i < nFaceVert; ++i) {
+                weights[i + startIndex] += fweights[i] / sum * (1 - centerWeight);
             }
         }
     }
@@ -948,6 +981,51 @@ GridInterface::Interpolator UnstructuredGrid::getInterpolator(Index elem, const
     return Interpolator(weights, indices);
 }
 
+void UnstructuredGrid::interpolate(Index numPoints, const Index *cells, const Scalar *const x[3], int numComponents,
+                                   const Scalar *const field[], Scalar *const out[], Mapping mapping,
+                                   InterpolationMode mode) const
+{
+    if (mapping != Element && mode != Linear) {
+        GridInterface::interpolate(numPoints, cells, x, numComponents, field, out, mapping, mode);
+        return;
+    }
+
+    const auto el = &this->el()[0];
+    const auto tl = &this->tl()[0];
+    const Scalar *coords[3] = {&this->x()[0], &this->y()[0], &this->z()[0]};
+    Scalar weights[8];
+    for (Index i = 0; i < numPoints; ++i) {
+        const Index elem = cells[i];
+        if (elem == InvalidIndex) {
+            for (int c = 0; c < numComponents; ++c)
+                out[c][i] = Scalar(0);
+            continue;
+        }
+        if (mapping == Element) {
+            for (int c = 0; c < numComponents; ++c)
+                out[c][i] = field[c][elem];
+            continue;
+        }
+
+        const Vector3 point(x[0][i], x[1][i], x[2][i]);
+        const auto cl = &this->cl()[el[elem]];
+        const Index nvert = el[elem + 1] - el[elem];
+        if (nvert > 8 || !linearWeights(tl[elem] & TYPE_MASK, nvert, cl, coords, point, weights)) {
+            const auto interp = getInterpolator(elem, point, mapping, mode);
+            for (int c = 0; c < numComponents; ++c)
+                out[c][i] = interp(field[c]);
+            continue;
+        }
+        for (int c = 0; c < numComponents; ++c) {
+            const Scalar *f = field[c];
+            Scalar v(0);
+            for (Index k = 0; k < nvert; ++k)
+                v += f[cl[k]] * weights[k];
+            out[c][i] = v;
+        }
+    }
+}
+
 std::pair<Vector3, Vector3> UnstructuredGrid::elementBounds(Index elem) const
 {
     const auto t = tl()[elem] & UnstructuredGrid::TYPE_MASK;
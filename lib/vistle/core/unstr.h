@@ -55,6 +55,8 @@ public:
     bool isGhostCell(Index elem) const override;
     std::pair<Vector3, Vector3> cellBounds(Index elem) const override;
     Index findCell(const Vector3 &point, Index hint = InvalidIndex, int flags = NoFlags) const override;
+    void findCells(Index numPoints, const Vector3 *points, Index *cells, const Index *hints = nullptr,
+                   int flags = NoFlags) const override;
     bool insideConvex(Index elem, const Vector3 &point) const;
     bool inside(Index elem, const Vector3 &point) const override;
     Index checkConvexity(); //< return number of non-convex cells
@@ -62,6 +64,9 @@ public:
 
     Interpolator getInterpolator(Index elem, const Vector3 &point, Mapping mapping = Vertex,
                                  InterpolationMode mode = Linear) const override;
+    void interpolate(Index numPoints, const Index *cells, const Scalar *const x[3], int numComponents,
+                     const Scalar *const field[], Scalar *const out[], Mapping mapping = Vertex,
+                     InterpolationMode mode = Linear) const override;
     std::pair<Vector3, Vector3> elementBounds(Index elem) const override;
     std::vector<Index> cellVertices(Index elem) const override;
     Scalar cellDiameter(Index elem) const override;
@@ -70,6 +75,8 @@ public:
     Index cellNumFaces(Index elem) const override;
 
 private:
+    Interpolator polyhedronInterpolator(Index elem, const Vector3 &point) const;
+
     mutable const Byte *m_tl;
 
     V_DATA_BEGIN(UnstructuredGrid);
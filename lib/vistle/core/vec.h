@@ -33,6 +33,7 @@ public:
     unsigned dimension() const override { return Dim; }
 
     bool copyEntry(Index to, DataBase::const_ptr src, Index from) override;
+    bool copyEntries(Index count, const Index *to, DataBase::const_ptr src, const Index *from) override;
     void setValue(Index idx, unsigned component, const double &value) override;
     double value(Index idx, unsigned c = 0) const override;
 
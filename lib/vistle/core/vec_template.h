@@ -5,6 +5,7 @@
 #include "structuredgridbase.h"
 #include <vistle/util/exception.h>
 
+#include <algorithm>
 #include <limits>
 #include <type_traits>
 
@@ -70,6 +71,33 @@ bool Vec<T, Dim>::copyEntry(Index to, DataBase::const_ptr src, Index from)
     return true;
 }
 
+template<class T, unsigned Dim>
+bool Vec<T, Dim>::copyEntries(Index count, const Index *to, DataBase::const_ptr src, const Index *from)
+{
+    auto s = Vec<T, Dim>::as(src);
+    if (!s)
+        return false;
+
+    for (unsigned c = 0; c < Dim; ++c) {
+        T *dst = x(c).data();
+        const T *sx = s->x(c);
+        if (to && from) {
+            for (Index i = 0; i < count; ++i)
+                dst[to[i]] = sx[from[i]];
+        } else if (to) {
+            for (Index i = 0; i < count; ++i)
+                dst[to[i]] = sx[i];
+        } else if (from) {
+            for (Index i = 0; i < count; ++i)
+                dst[i] = sx[from[i]];
+        } else {
+            std::copy(sx, sx + count, dst);
+        }
+    }
+
+    return true;
+}
+
 template<class T, unsigned Dim>
 void Vec<T, Dim>::setValue(Index idx, unsigned component, const double &value)
 {
@@ -0,0 +1,72 @@
+#ifndef VISTLE_VECDISPATCH_H
+#define VISTLE_VECDISPATCH_H
+
+#include "vec.h"
+#include "scalars.h"
+
+#include <boost/mpl/for_each.hpp>
+
+namespace vistle {
+
+namespace detail {
+
+template<class DataPtr, class Visitor, unsigned Dim>
+struct VecDispatch {
+    DataPtr data;
+    Visitor &visitor;
+    bool &handled;
+
+    template<typename S>
+    void operator()(S)
+    {
+        typedef Vec<S, Dim> V;
+        if (handled)
+            return;
+        if (auto v = V::as(data)) {
+            handled = true;
+            visitor(v);
+        }
+    }
+};
+
+template<class Types, class DataPtr, class Visitor>
+bool dispatchVec(DataPtr data, Visitor &visitor)
+{
+    if (!data)
+        return false;
+
+    bool handled = false;
+    switch (data->dimension()) {
+    case 1:
+        boost::mpl::for_each<Types>(VecDispatch<DataPtr, Visitor, 1>{data, visitor, handled});
+        break;
+    case 2:
+        boost::mpl::for_each<Types>(VecDispatch<DataPtr, Visitor, 2>{data, visitor, handled});
+        break;
+    case 3:
+        boost::mpl::for_each<Types>(VecDispatch<DataPtr, Visitor, 3>{data, visitor, handled});
+        break;
+    }
+    return handled;
+}
+
+} // namespace detail
+
+//! resolve the concrete Vec<T,Dim> behind data once and call visitor with its typed pointer
+/*! visitor is invoked as visitor(typename Vec<T,Dim>::const_ptr) and may use the contiguous arrays x(c) directly,
+ *  Types restricts the scalar types tried, returns false if data is not a Vec of a matching type */
+template<class Types = Scalars, class Visitor>
+bool visitVec(DataBase::const_ptr data, Visitor &&visitor)
+{
+    return detail::dispatchVec<Types, DataBase::const_ptr>(data, visitor);
+}
+
+//! like visitVec, but provides writable access via typename Vec<T,Dim>::ptr
+template<class Types = Scalars, class Visitor>
+bool visitVec(DataBase::ptr data, Visitor &&visitor)
+{
+    return detail::dispatchVec<Types, DataBase::ptr>(data, visitor);
+}
+
+} // namespace vistle
+#endif
@@ -782,6 +782,12 @@ bool ClusterManager::handle(const message::Buffer &message, const MessagePayload
         break;
     }
 
+    case message::ADDOBJECTS: {
+        const message::AddObjects &m = message.as<AddObjects>();
+        result = handlePriv(m, payload);
+        break;
+    }
+
     case message::EXECUTIONPROGRESS: {
         const message::ExecutionProgress &prog = message.as<ExecutionProgress>();
         result = handlePriv(prog);
@@ -959,25 +965,32 @@ bool ClusterManager::handlePriv(const message::Spawn &spawn)
         std::string mname = "vistle:mq" + std::to_string(newId);
         setThreadName(mname);
 
+        std::vector<message::Buffer> bufs;
         for (;;) {
-            message::Buffer buf;
+            bufs.clear();
+            bufs.emplace_back();
             try {
-                if (!mod.recvQueue->receive(buf))
+                if (!mod.recvQueue->receive(bufs.back()))
                     return;
+                // hand over everything that has queued up in the meantime at once
+                mod.recvQueue->tryReceive(bufs, mod.recvQueue->capacity());
             } catch (boost::interprocess::interprocess_exception &ex) {
                 CERR << "receive mq " << ex.what() << std::endl;
                 return;
             }
 
-            MessagePayload pl;
-            if (buf.payloadSize() > 0) {
-                pl = Shm::the().getArrayFromName<char>(buf.payloadName());
+            std::vector<MessagePayload> pls(bufs.size());
+            for (size_t i = 0; i < bufs.size(); ++i) {
+                if (bufs[i].payloadSize() > 0) {
+                    pls[i] = Shm::the().getArrayFromName<char>(bufs[i].payloadName());
+                }
             }
             std::lock_guard<std::mutex> guard(m_incomingMutex);
-            m_incomingMessages.emplace_back(buf, pl);
-
-            if (buf.type() == message::MODULEEXIT)
-                return;
+            for (size_t i = 0; i < bufs.size(); ++i) {
+                m_incomingMessages.emplace_back(bufs[i], pls[i]);
+                if (bufs[i].type() == message::MODULEEXIT)
+                    return;
+            }
         }
     });
     mod.messageThread = std::move(mt);
@@ -1331,70 +1344,79 @@ bool ClusterManager::addObjectDestination(const message::AddObject &addObj, Obje
     }
 
     for (const Port *destPort: *list) {
-        int destId = destPort->getModuleID();
-        if (!isLocal(destId))
+        if (!isLocal(destPort->getModuleID()))
             continue;
+        if (!addObjectToPort(addObj, obj, destPort))
+            return false;
+    }
 
-        auto it = m_stateTracker.runningMap.find(destId);
-        if (it == m_stateTracker.runningMap.end()) {
-            CERR << "port connection to module " << destId << ":" << destPort->getName() << ", which is not running"
-                 << std::endl;
-            assert("port connection to module that is not running" == 0);
-            continue;
-        }
-        auto &destMod = it->second;
+    return true;
+}
 
-        message::AddObject addObj2(addObj);
-        addObj2.setRank(m_rank); // object is/will be present on this rank
-        addObj2.setDestId(destId);
-        addObj2.setDestPort(destPort->getName());
-        addObj2.setDestRank(-1);
-        if (obj) {
-            addObj2.setObject(obj);
-        } else {
-            // receiving module will wait until it is unblocked
-            addObj2.setBlocker();
-        }
+bool ClusterManager::addObjectToPort(const message::AddObject &addObj, Object::const_ptr obj, const Port *destPort)
+{
+    int destId = destPort->getModuleID();
+    assert(isLocal(destId));
 
-        bool broadcast = false;
-        if (destMod.objectPolicy == message::ObjectReceivePolicy::Local) {
-            CERR << "LOCAL object add at " << destId << ": " << addObj2.objectName() << std::endl;
-            if (!sendMessage(destId, addObj2))
-                return false;
-            portManager().addObject(destPort);
+    auto it = m_stateTracker.runningMap.find(destId);
+    if (it == m_stateTracker.runningMap.end()) {
+        CERR << "port connection to module " << destId << ":" << destPort->getName() << ", which is not running"
+             << std::endl;
+        assert("port connection to module that is not running" == 0);
+        return true;
+    }
+    auto &destMod = it->second;
 
-            if (!checkExecuteObject(destId))
-                return false;
-        } else {
-            CERR << "BROADCAST object add at " << destId << ": " << addObj2.objectName() << std::endl;
-            broadcast = true;
-            if (!Communicator::the().broadcastAndHandleMessage(addObj2))
-                return false;
-        }
+    message::AddObject addObj2(addObj);
+    addObj2.setRank(m_rank); // object is/will be present on this rank
+    addObj2.setDestId(destId);
+    addObj2.setDestPort(destPort->getName());
+    addObj2.setDestRank(-1);
+    if (obj) {
+        addObj2.setObject(obj);
+    } else {
+        // receiving module will wait until it is unblocked
+        addObj2.setBlocker();
+    }
 
-        if (!obj) {
-            // block messages of receiving module until remote object is available
-            assert(!isLocal(addObj.senderId()));
-            auto it = runningMap.find(destId);
-            if (it != runningMap.end()) {
-                Communicator::the().dataManager().requestObject(
-                    addObj, addObj.objectName(), [this, addObj, addObj2, broadcast](Object::const_ptr newobj) mutable {
-                        auto obj = addObj.getObject();
-                        assert(obj);
-                        assert(obj->getName() == newobj->getName());
-                        addObj2.setObject(newobj);
-                        obj.reset();
-                        // unblock receiving module
-                        addObj2.setUnblocking();
-
-                        std::unique_lock<Communicator> guard(Communicator::the());
-                        if (broadcast) {
-                            Communicator::the().broadcastAndHandleMessage(addObj2);
-                        } else {
-                            sendMessage(addObj2.destId(), addObj2);
-                        }
-                    });
-            }
+    bool broadcast = false;
+    if (destMod.objectPolicy == message::ObjectReceivePolicy::Local) {
+        CERR << "LOCAL object add at " << destId << ": " << addObj2.objectName() << std::endl;
+        if (!sendMessage(destId, addObj2))
+            return false;
+        portManager().addObject(destPort);
+
+        if (!checkExecuteObject(destId))
+            return false;
+    } else {
+        CERR << "BROADCAST object add at " << destId << ": " << addObj2.objectName() << std::endl;
+        broadcast = true;
+        if (!Communicator::the().broadcastAndHandleMessage(addObj2))
+            return false;
+    }
+
+    if (!obj) {
+        // block messages of receiving module until remote object is available
+        assert(!isLocal(addObj.senderId()));
+        auto it = runningMap.find(destId);
+        if (it != runningMap.end()) {
+            Communicator::the().dataManager().requestObject(
+                addObj, addObj.objectName(), [this, addObj, addObj2, broadcast](Object::const_ptr newobj) mutable {
+                    auto obj = addObj.getObject();
+                    assert(obj);
+                    assert(obj->getName() == newobj->getName());
+                    addObj2.setObject(newobj);
+                    obj.reset();
+                    // unblock receiving module
+                    addObj2.setUnblocking();
+
+                    std::unique_lock<Communicator> guard(Communicator::the());
+                    if (broadcast) {
+                        Communicator::the().broadcastAndHandleMessage(addObj2);
+                    } else {
+                        sendMessage(addObj2.destId(), addObj2);
+                    }
+                });
         }
     }
 
@@ -1469,56 +1491,149 @@ bool ClusterManager::handlePriv(const message::AddObject &addObj)
     return addObjectDestination(addObj, obj);
 }
 
-bool ClusterManager::checkExecuteObject(int destId)
+bool ClusterManager::handlePriv(const message::AddObjects &addObjs, const MessagePayload &payload)
 {
-    if (!isReadyForExecute(destId))
-        return true;
+    assert(payload);
+    if (!payload) {
+        return false;
+    }
 
-    int numconn = 0;
-    for (const auto input: portManager().getConnectedInputPorts(destId)) {
-        if (input->flags() & Port::NOCOMPUTE)
-            continue;
-        ++numconn;
-        if (!portManager().hasObject(input)) {
-            return true;
-        }
+    buffer data(payload->begin(), payload->end());
+    auto pl = message::getPayload<message::AddObjects::Payload>(data);
+    auto objects = addObjs.takeObjects(pl);
+    const bool complete = objects.size() == addObjs.numObjects();
+
+    const Port *port = portManager().findPort(addObjs.senderId(), addObjs.getSenderPort());
+    if (!port) {
+        CERR << "AddObjects [" << objects.size() << " objects] to port [" << addObjs.getSenderPort() << "] of ["
+             << addObjs.senderId() << "]: port not found" << std::endl;
+        return true;
     }
-    CERR << "checkExecuteObject " << destId << ": " << numconn << " connections" << std::endl;
-    if (numconn == 0)
+    const Port::ConstPortSet *list = portManager().getConnectionList(port);
+    if (!list) {
+        assert(list);
         return true;
-    for (const auto input: portManager().getConnectedInputPorts(destId)) {
-        if (input->flags() & Port::NOCOMPUTE)
-            continue;
-        portManager().popObject(input);
     }
 
-    auto it = m_stateTracker.runningMap.find(destId);
-    if (it == m_stateTracker.runningMap.end()) {
-        CERR << "port connection to module that is not running" << std::endl;
-        assert("port connection to module that is not running" == 0);
-        return true;
+    // objects have to be announced individually to remote hubs and to modules that do not receive them locally
+    std::vector<message::AddObject> individual;
+    auto announceIndividually = [this, &addObjs, &objects, &individual]() -> std::vector<message::AddObject> & {
+        if (individual.empty()) {
+            individual.reserve(objects.size());
+            for (const auto &obj: objects) {
+                individual.emplace_back(addObjs.getSenderPort(), obj);
+                individual.back().setSenderId(addObjs.senderId());
+                individual.back().setRank(addObjs.rank());
+            }
+        }
+        return individual;
+    };
+
+    for (const Port *destPort: *list) {
+        if (!isLocal(destPort->getModuleID())) {
+            for (const auto &add: announceIndividually())
+                addObjectSource(add);
+            break;
+        }
     }
-    auto &destMod = it->second;
-    message::Execute c(message::Execute::ComputeObject, destId);
-    c.setDestId(destId);
-    //c.setUuid(addObj.uuid());
-    if (destMod.schedulingPolicy == message::SchedulingPolicy::Single) {
-        sendMessage(destId, c);
-    } else if (destMod.schedulingPolicy == message::SchedulingPolicy::Gang) {
-        c.setAllRanks(true);
-        CERR << "checkExecuteObject " << destId << ": exec b/c gang scheduling: " << c << std::endl;
-        if (!Communicator::the().broadcastAndHandleMessage(c))
+
+    for (const Port *destPort: *list) {
+        int destId = destPort->getModuleID();
+        if (!isLocal(destId))
+            continue;
+
+        auto it = m_stateTracker.runningMap.find(destId);
+        if (it == m_stateTracker.runningMap.end()) {
+            CERR << "port connection to module " << destId << ":" << destPort->getName() << ", which is not running"
+                 << std::endl;
+            assert("port connection to module that is not running" == 0);
+            continue;
+        }
+        auto &destMod = it->second;
+
+        if (destMod.objectPolicy != message::ObjectReceivePolicy::Local || !complete) {
+            auto &adds = announceIndividually();
+            for (size_t i = 0; i < adds.size(); ++i) {
+                if (!addObjectToPort(adds[i], objects[i], destPort))
+                    return false;
+            }
+            continue;
+        }
+
+        message::AddObjects batch(addObjs);
+        batch.setRank(m_rank);
+        batch.setDestId(destId);
+        batch.setDestPort(destPort->getName());
+        batch.setDestRank(-1);
+        // receiving module takes over another reference, payload is shared with other receivers
+        message::AddObjects::ref(objects);
+        CERR << "LOCAL add of " << objects.size() << " objects at " << destId << std::endl;
+        if (!sendMessage(destId, batch, -1, payload))
             return false;
-    } else if (destMod.schedulingPolicy == message::SchedulingPolicy::LazyGang) {
-        if (getRank() == 0) {
-            handle(c);
-        } else {
-            if (!Communicator::the().forwardToMaster(c))
+        for (size_t i = 0; i < objects.size(); ++i)
+            portManager().addObject(destPort);
+
+        if (!checkExecuteObject(destId))
+            return false;
+    }
+
+    for (const auto &add: individual)
+        add.takeObject();
+
+    return true;
+}
+
+bool ClusterManager::checkExecuteObject(int destId)
+{
+    // issue one execution for every complete set of input objects
+    for (;;) {
+        if (!isReadyForExecute(destId))
+            return true;
+
+        int numconn = 0;
+        for (const auto input: portManager().getConnectedInputPorts(destId)) {
+            if (input->flags() & Port::NOCOMPUTE)
+                continue;
+            ++numconn;
+            if (!portManager().hasObject(input)) {
+                return true;
+            }
+        }
+        CERR << "checkExecuteObject " << destId << ": " << numconn << " connections" << std::endl;
+        if (numconn == 0)
+            return true;
+        for (const auto input: portManager().getConnectedInputPorts(destId)) {
+            if (input->flags() & Port::NOCOMPUTE)
+                continue;
+            portManager().popObject(input);
+        }
+
+        auto it = m_stateTracker.runningMap.find(destId);
+        if (it == m_stateTracker.runningMap.end()) {
+            CERR << "port connection to module that is not running" << std::endl;
+            assert("port connection to module that is not running" == 0);
+            return true;
+        }
+        auto &destMod = it->second;
+        message::Execute c(message::Execute::ComputeObject, destId);
+        c.setDestId(destId);
+        //c.setUuid(addObj.uuid());
+        if (destMod.schedulingPolicy == message::SchedulingPolicy::Single) {
+            sendMessage(destId, c);
+        } else if (destMod.schedulingPolicy == message::SchedulingPolicy::Gang) {
+            c.setAllRanks(true);
+            CERR << "checkExecuteObject " << destId << ": exec b/c gang scheduling: " << c << std::endl;
+            if (!Communicator::the().broadcastAndHandleMessage(c))
                 return false;
+        } else if (destMod.schedulingPolicy == message::SchedulingPolicy::LazyGang) {
+            if (getRank() == 0) {
+                handle(c);
+            } else {
+                if (!Communicator::the().forwardToMaster(c))
+                    return false;
+            }
         }
     }
-
-    return checkExecuteObject(destId);
 }
 
 bool ClusterManager::handlePriv(const message::AddObjectCompleted &complete)
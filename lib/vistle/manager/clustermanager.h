@@ -104,6 +104,7 @@ private:
 
     bool addObjectSource(const message::AddObject &addObj);
     bool addObjectDestination(const message::AddObject &addObj, Object::const_ptr obj);
+    bool addObjectToPort(const message::AddObject &addObj, Object::const_ptr obj, const Port *destPort);
 
     bool handlePriv(const message::Trace &trace);
     bool handlePriv(const message::Quit &quit);
@@ -120,6 +121,7 @@ private:
     bool handlePriv(const message::SetParameterChoices &setChoices, const MessagePayload &payload);
     bool handlePriv(const message::AddObject &addObj);
     bool handlePriv(const message::AddObjectCompleted &complete);
+    bool handlePriv(const message::AddObjects &addObjs, const MessagePayload &payload);
     bool handlePriv(const message::Barrier &barrier);
     bool handlePriv(const message::BarrierReached &barrierReached);
     bool handlePriv(const message::SendText &text, const MessagePayload &payload);
@@ -8,7 +8,10 @@
 
 #include <mpi.h>
 
+#include <algorithm>
+#include <climits>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include <vistle/core/message.h>
@@ -21,6 +24,7 @@
 #include <vistle/util/tools.h>
 #include <vistle/util/hostname.h>
 #include <vistle/util/crypto.h>
+#include <vistle/util/stopwatch.h>
 
 #include "communicator.h"
 #include "clustermanager.h"
@@ -41,6 +45,10 @@ using message::Id;
 
 Communicator *Communicator::s_singleton = NULL;
 
+namespace {
+const uint64_t ShutdownFrame = ~uint64_t(0); //< number of messages in frame signalling end of broadcasts
+}
+
 Communicator::Communicator(int r, const std::vector<std::string> &hosts, boost::mpi::communicator comm)
 : m_comm(comm)
 , m_clusterManager(new ClusterManager(m_comm, hosts))
@@ -48,7 +56,9 @@ Communicator::Communicator(int r, const std::vector<std::string> &hosts, boost::
 , m_hubId(message::Id::Invalid)
 , m_rank(r)
 , m_size(hosts.size())
-, m_recvSize(0)
+, m_bcastComm(comm, boost::mpi::comm_duplicate)
+, m_broadcastLatency(message::NumMessageTypes)
+, m_toRankLatency(message::NumMessageTypes)
 , m_hubSocket(m_ioService)
 {
     crypto::initialize();
@@ -58,12 +68,12 @@ Communicator::Communicator(int r, const std::vector<std::string> &hosts, boost::
 
     message::DefaultSender::init(m_hubId, m_rank);
 
-    // post requests for length of next MPI message
+    // post requests for next MPI message
     if (m_size > 1) {
-        MPI_Irecv(&m_recvSize, 1, MPI_UNSIGNED, MPI_ANY_SOURCE, TagStartBroadcast, comm, &m_reqAny);
-
         MPI_Irecv(m_recvBufToRank.data(), m_recvBufToRank.bufferSize(), MPI_BYTE, MPI_ANY_SOURCE, TagToRank, comm,
                   &m_reqToRank);
+        if (m_rank > 0)
+            postBroadcastHeader();
     }
 }
 
@@ -162,6 +172,45 @@ void Communicator::unlock()
     m_mutex.unlock();
 }
 
+void Communicator::Latency::add(double seconds)
+{
+    ++count;
+    total += seconds;
+    max = std::max(max, seconds);
+}
+
+double Communicator::Latency::average() const
+{
+    if (count == 0)
+        return 0.;
+    return total / count;
+}
+
+const std::vector<Communicator::Latency> &Communicator::broadcastLatency() const
+{
+    return m_broadcastLatency;
+}
+
+const std::vector<Communicator::Latency> &Communicator::toRankLatency() const
+{
+    return m_toRankLatency;
+}
+
+void Communicator::printLatency() const
+{
+    auto print = [this](const char *kind, const std::vector<Latency> &latency) {
+        for (int t = 0; t < message::NumMessageTypes; ++t) {
+            const auto &l = latency[t];
+            if (l.count == 0)
+                continue;
+            CERR << kind << " " << message::Type(t) << ": " << l.count << " messages, avg " << l.average() * 1e3
+                 << " ms, max " << l.max * 1e3 << " ms" << std::endl;
+        }
+    };
+    print("broadcast", m_broadcastLatency);
+    print("to rank", m_toRankLatency);
+}
+
 bool Communicator::connectData()
 {
     return m_dataManager->connect(m_dataEndpoint);
@@ -216,82 +265,57 @@ bool Communicator::dispatch(bool *work)
     // check for new UIs and other network clients
     // handle or broadcast messages received from slaves (rank > 0)
     if (m_size > 1) {
-        int flag;
+        // payloads are received asynchronously, messages are handled in order of arrival once they are complete
+        int flag = 0;
         MPI_Status status;
         MPI_Test(&m_reqToRank, &flag, &status);
-        if (flag && status.MPI_TAG == TagToRank) {
-            received = true;
-            message::Message *message = &m_recvBufToRank;
-            MessagePayload payload;
-            if (message->payloadSize() > 0) {
-                payload.construct(message->payloadSize());
-                MPI_Status status2;
-                MPI_Recv(payload->data(), payload->size(), MPI_BYTE, status.MPI_SOURCE, TagToRank, m_comm, &status2);
-                message->setPayloadName(payload.name());
-            }
-            if (m_rank == 0 && message->isForBroadcast()) {
-                if (!broadcastAndHandleMessage(*message, payload)) {
-                    CERR << "Quit reason: broadcast & handle" << std::endl;
-                    done = true;
-                }
-            } else {
-                if (!handleMessage(*message, payload)) {
-                    CERR << "Quit reason: handle" << std::endl;
-                    done = true;
-                }
+        while (flag) {
+            auto rr = std::make_shared<RecvRequest>(m_recvBufToRank);
+            rr->start = Clock::time();
+            if (rr->buf.payloadSize() > 0) {
+                rr->payload.construct(rr->buf.payloadSize());
+                MPI_Irecv(rr->payload->data(), rr->payload->size(), MPI_BYTE, status.MPI_SOURCE, TagToRankPayload,
+                          m_comm, &rr->req);
+                rr->buf.setPayloadName(rr->payload.name());
             }
+            m_ongoingRecvs.emplace_back(rr);
             MPI_Irecv(m_recvBufToRank.data(), m_recvBufToRank.bufferSize(), MPI_BYTE, MPI_ANY_SOURCE, TagToRank, m_comm,
                       &m_reqToRank);
+            MPI_Test(&m_reqToRank, &flag, &status);
         }
 
-        // test for message size from another MPI node
-        //    - receive actual message from broadcast (on any rank)
-        //    - receive actual message from slave rank (on rank 0) for broadcasting
-        //    - handle message
-        //    - post another MPI receive for size of next message
-        MPI_Test(&m_reqAny, &flag, &status);
-        if (flag && status.MPI_TAG == TagStartBroadcast) {
-            if (m_recvSize > m_recvBufToAny.bufferSize()) {
-                CERR << "invalid m_recvSize: " << m_recvSize << ", flag=" << flag
-                     << ", status.MPI_SOURCE=" << status.MPI_SOURCE << std::endl;
+        // consecutive messages to be broadcast are sent in a single frame
+        while (!m_ongoingRecvs.empty() && m_ongoingRecvs.front()->testComplete()) {
+            auto rr = m_ongoingRecvs.front();
+            m_ongoingRecvs.pop_front();
+            received = true;
+            m_toRankLatency[rr->buf.type()].add(Clock::time() - rr->start);
+            if (m_rank == 0 && rr->buf.isForBroadcast()) {
+                queueBroadcast(rr->buf, rr->payload);
+                continue;
             }
-            assert(m_recvSize <= m_recvBufToAny.bufferSize());
-            MPI_Bcast(m_recvBufToAny.data(), m_recvSize, MPI_BYTE, status.MPI_SOURCE, m_comm);
-
-            unsigned recvSize = m_recvSize;
-
-            // post new receive
-            MPI_Irecv(&m_recvSize, 1, MPI_UNSIGNED, MPI_ANY_SOURCE, TagStartBroadcast, m_comm, &m_reqAny);
-
-            if (recvSize > 0) {
-                received = true;
-
-                message::Message *message = &m_recvBufToAny;
-#if 0
-            printf("[%02d] message from [%02d] message type %d m_size %d\n",
-                  m_rank, status.MPI_SOURCE, message->getType(), mpiMessageSize);
-#endif
-                MessagePayload payload;
-                if (message->payloadSize() > 0) {
-                    payload.construct(message->payloadSize());
-                    MPI_Bcast(payload->data(), payload->size(), MPI_BYTE, status.MPI_SOURCE, m_comm);
-                    message->setPayloadName(payload.name());
-                }
-                //CERR << "handle broadcast: " << *message << std::endl;
-                if (!handleMessage(*message, payload)) {
-                    CERR << "Quit reason: handle message received via broadcast: " << *message << std::endl;
-                    done = true;
-                }
+            if (!flushBroadcasts()) {
+                CERR << "Quit reason: broadcast & handle" << std::endl;
+                done = true;
+            }
+            if (!handleMessage(rr->buf, rr->payload)) {
+                CERR << "Quit reason: handle" << std::endl;
+                done = true;
             }
         }
+        if (!flushBroadcasts()) {
+            CERR << "Quit reason: broadcast & handle" << std::endl;
+            done = true;
+        }
 
-#if 0
-      if (m_ongoingSends.size() > 0) {
-          CERR << m_ongoingSends.size() << " ongoing MPI sends" << std::endl;
-      }
-#endif
+        if (!progressBroadcasts(&received)) {
+            done = true;
+        }
+
+        const double now = Clock::time();
         for (auto it = m_ongoingSends.begin(), next = it; it != m_ongoingSends.end(); it = next) {
             if ((*it)->testComplete()) {
+                m_toRankLatency[(*it)->buf.type()].add(now - (*it)->start);
                 next = m_ongoingSends.erase(it);
             } else {
                 ++next;
@@ -361,7 +385,7 @@ bool Communicator::dispatch(bool *work)
 #endif
 
     if (work)
-        *work = received;
+        *work = received || !m_ongoingRecvs.empty() || !m_sendFrames.empty() || !m_recvFrames.empty();
 
     if (m_rank == 0 && done) {
         if (hubId() == Id::MasterHub)
@@ -375,13 +399,20 @@ bool Communicator::dispatch(bool *work)
 
 bool Communicator::startSend(int destRank, const message::Message &message, const MessagePayload &payload)
 {
+    if (m_rank == 0) {
+        // make sure that broadcasts queued earlier reach other ranks before this message
+        postPendingBroadcasts();
+    }
+
     auto p = m_ongoingSends.emplace(new SendRequest(message));
     auto it = p.first;
     auto &sr = **it;
+    sr.start = Clock::time();
     MPI_Isend(sr.buf.data(), sr.buf.size(), MPI_BYTE, destRank, TagToRank, m_comm, &sr.req);
     if (sr.buf.payloadSize() > 0) {
         sr.payload = payload;
-        MPI_Isend(sr.payload->data(), sr.payload->size(), MPI_BYTE, 0, TagToRank, m_comm, &sr.payload_req);
+        MPI_Isend(sr.payload->data(), sr.payload->size(), MPI_BYTE, destRank, TagToRankPayload, m_comm,
+                  &sr.payload_req);
     }
     return true;
 }
@@ -408,6 +439,206 @@ bool Communicator::SendRequest::testComplete()
     return flag;
 }
 
+bool Communicator::RecvRequest::testComplete()
+{
+    if (req == MPI_REQUEST_NULL)
+        return true;
+    int flag = 0;
+    MPI_Test(&req, &flag, MPI_STATUS_IGNORE);
+    return flag;
+}
+
+Communicator::QueuedMessage::QueuedMessage(const message::Message &msg, const MessagePayload &payload)
+: buf(msg), payload(payload), queued(Clock::time())
+{}
+
+void Communicator::BroadcastFrame::postData(MPI_Comm comm)
+{
+    data.resize(header[1]);
+    for (size_t off = 0; off < data.size(); off += INT_MAX) {
+        reqs.emplace_back();
+        MPI_Ibcast(data.data() + off, int(std::min(size_t(INT_MAX), data.size() - off)), MPI_BYTE, 0, comm,
+                   &reqs.back());
+    }
+}
+
+bool Communicator::BroadcastFrame::testComplete()
+{
+    int flag = 0;
+    MPI_Testall(reqs.size(), reqs.data(), &flag, MPI_STATUSES_IGNORE);
+    if (flag)
+        reqs.clear();
+    return flag;
+}
+
+void Communicator::BroadcastFrame::waitComplete()
+{
+    MPI_Waitall(reqs.size(), reqs.data(), MPI_STATUSES_IGNORE);
+    reqs.clear();
+}
+
+void Communicator::postBroadcastHeader()
+{
+    assert(m_rank > 0);
+    m_recvHeader.reset(new BroadcastFrame);
+    m_recvHeader->reqs.emplace_back();
+    MPI_Ibcast(m_recvHeader->header, 2, MPI_UINT64_T, 0, m_bcastComm, &m_recvHeader->reqs.back());
+}
+
+void Communicator::queueBroadcast(const message::Message &message, const MessagePayload &payload)
+{
+    assert(m_rank == 0);
+    m_pendingBroadcasts.emplace_back(message, payload);
+    auto &buf = m_pendingBroadcasts.back().buf;
+    buf.setForBroadcast(false);
+    buf.setWasBroadcast(true);
+}
+
+void Communicator::postPendingBroadcasts()
+{
+    if (m_pendingBroadcasts.empty())
+        return;
+
+    if (m_size > 1) {
+        std::unique_ptr<BroadcastFrame> frame(new BroadcastFrame);
+        size_t size = 0;
+        for (const auto &m: m_pendingBroadcasts)
+            size += m.buf.size() + m.buf.payloadSize();
+        frame->header[0] = m_pendingBroadcasts.size();
+        frame->header[1] = size;
+        frame->data.reserve(size);
+        for (const auto &m: m_pendingBroadcasts) {
+            frame->data.insert(frame->data.end(), m.buf.data(), m.buf.data() + m.buf.size());
+            if (m.buf.payloadSize() > 0) {
+                assert(m.payload && m.payload->size() == m.buf.payloadSize());
+                frame->data.insert(frame->data.end(), m.payload->data(), m.payload->data() + m.payload->size());
+            }
+            frame->messages.emplace_back(m.buf.type(), m.queued);
+        }
+        frame->reqs.emplace_back();
+        MPI_Ibcast(frame->header, 2, MPI_UINT64_T, 0, m_bcastComm, &frame->reqs.back());
+        frame->postData(m_bcastComm);
+        m_sendFrames.emplace_back(std::move(frame));
+    }
+
+    for (auto &m: m_pendingBroadcasts)
+        m_unhandledBroadcasts.emplace_back(std::move(m));
+    m_pendingBroadcasts.clear();
+}
+
+bool Communicator::flushBroadcasts()
+{
+    if (m_handlingBroadcasts) {
+        // broadcast from within a message handler: handled after all broadcasts that have been sent before
+        return true;
+    }
+
+    m_handlingBroadcasts = true;
+    bool ok = true;
+    while (!m_pendingBroadcasts.empty() || !m_unhandledBroadcasts.empty()) {
+        postPendingBroadcasts();
+        while (!m_unhandledBroadcasts.empty()) {
+            auto m = std::move(m_unhandledBroadcasts.front());
+            m_unhandledBroadcasts.pop_front();
+            if (m.payload)
+                m.buf.setPayloadName(m.payload.name());
+            if (!handleMessage(m.buf, m.payload))
+                ok = false;
+        }
+    }
+    m_handlingBroadcasts = false;
+
+    return ok;
+}
+
+bool Communicator::progressBroadcasts(bool *received)
+{
+    const double now = Clock::time();
+    while (!m_sendFrames.empty() && m_sendFrames.front()->testComplete()) {
+        for (const auto &m: m_sendFrames.front()->messages)
+            m_broadcastLatency[m.first].add(now - m.second);
+        m_sendFrames.pop_front();
+    }
+
+    // as soon as the size of a frame is known, receive its contents and the header of the next frame
+    while (m_recvHeader && m_recvHeader->testComplete()) {
+        auto frame = std::move(m_recvHeader);
+        if (frame->header[0] == ShutdownFrame)
+            break;
+        frame->start = now;
+        frame->postData(m_bcastComm);
+        m_recvFrames.emplace_back(std::move(frame));
+        postBroadcastHeader();
+    }
+
+    bool ok = true;
+    while (!m_recvFrames.empty() && m_recvFrames.front()->testComplete()) {
+        auto frame = std::move(m_recvFrames.front());
+        m_recvFrames.pop_front();
+        *received = true;
+
+        const char *p = frame->data.data(), *end = p + frame->data.size();
+        for (uint64_t i = 0; i < frame->header[0]; ++i) {
+            message::Buffer buf;
+            assert(p + sizeof(message::Message) <= end);
+            memcpy(buf.data(), p, sizeof(message::Message));
+            assert(buf.size() <= buf.bufferSize());
+            memcpy(buf.data(), p, buf.size());
+            p += buf.size();
+
+            MessagePayload payload;
+            if (buf.payloadSize() > 0) {
+                assert(p + buf.payloadSize() <= end);
+                payload.construct(buf.payloadSize());
+                memcpy(payload->data(), p, buf.payloadSize());
+                p += buf.payloadSize();
+                buf.setPayloadName(payload.name());
+            }
+
+            m_broadcastLatency[buf.type()].add(Clock::time() - frame->start);
+            if (!handleMessage(buf, payload)) {
+                CERR << "Quit reason: handle message received via broadcast: " << buf << std::endl;
+                ok = false;
+            }
+        }
+        assert(p == end);
+    }
+
+    return ok;
+}
+
+void Communicator::shutdownBroadcasts()
+{
+    if (m_size <= 1)
+        return;
+
+    if (m_rank == 0) {
+        // let other ranks complete their request for the next frame header
+        std::unique_ptr<BroadcastFrame> frame(new BroadcastFrame);
+        frame->header[0] = ShutdownFrame;
+        frame->reqs.emplace_back();
+        MPI_Ibcast(frame->header, 2, MPI_UINT64_T, 0, m_bcastComm, &frame->reqs.back());
+        m_sendFrames.emplace_back(std::move(frame));
+        for (auto &f: m_sendFrames)
+            f->waitComplete();
+        m_sendFrames.clear();
+    } else {
+        // discard broadcasts that have not been handled yet
+        while (m_recvHeader) {
+            m_recvHeader->waitComplete();
+            auto frame = std::move(m_recvHeader);
+            if (frame->header[0] == ShutdownFrame)
+                break;
+            frame->postData(m_bcastComm);
+            m_recvFrames.emplace_back(std::move(frame));
+            postBroadcastHeader();
+        }
+        for (auto &f: m_recvFrames)
+            f->waitComplete();
+        m_recvFrames.clear();
+    }
+}
+
 bool Communicator::sendMessage(const int moduleId, const message::Message &message, int destRank,
                                const MessagePayload &payload)
 {
@@ -446,44 +677,16 @@ bool Communicator::broadcastAndHandleMessage(const message::Message &message, co
     }
 
     // message will be handled when received again from rank 0
-    message::Buffer buf(message);
     if (m_rank > 0) {
+        message::Buffer buf(message);
         buf.setForBroadcast(true);
         buf.setWasBroadcast(false);
         return forwardToMaster(buf, payload);
     }
 
-    buf.setForBroadcast(false);
-    buf.setWasBroadcast(true);
-
-    MessagePayload pl = payload;
-    if (m_size > 0) {
-        std::lock_guard<Communicator> guard(*this);
-        std::vector<MPI_Request> s(m_size);
-        unsigned int size = buf.size();
-        for (int index = 0; index < m_size; ++index) {
-            if (index != m_rank) {
-                MPI_Isend(&size, 1, MPI_UNSIGNED, index, TagStartBroadcast, m_comm, &s[index]);
-            }
-        }
-
-        // wait for completion
-        for (int index = 0; index < m_size; ++index) {
-            if (index == m_rank)
-                continue;
-
-            MPI_Wait(&s[index], MPI_STATUS_IGNORE);
-        }
-
-        MPI_Bcast(buf.data(), buf.size(), MPI_BYTE, m_rank, m_comm);
-        if (buf.payloadSize() > 0) {
-            MPI_Bcast(pl->data(), pl->size(), MPI_BYTE, m_rank, m_comm);
-        }
-    }
-
-    if (pl)
-        buf.setPayloadName(pl.name());
-    return handleMessage(buf, pl);
+    std::lock_guard<Communicator> guard(*this);
+    queueBroadcast(message, payload);
+    return flushBroadcasts();
 }
 
 bool Communicator::handleMessage(const message::Buffer &message, const MessagePayload &payload)
@@ -514,6 +717,13 @@ Communicator::~Communicator()
         (*it)->waitComplete();
         next = m_ongoingSends.erase(it);
     }
+    for (auto &rr: m_ongoingRecvs) {
+        if (rr->req != MPI_REQUEST_NULL)
+            MPI_Wait(&rr->req, MPI_STATUS_IGNORE);
+    }
+    m_ongoingRecvs.clear();
+    shutdownBroadcasts();
+    printLatency();
 
     delete m_dataManager;
     m_dataManager = nullptr;
@@ -527,8 +737,6 @@ Communicator::~Communicator()
     CERR << "shut down: done init BARRIER" << std::endl;
 
     if (m_size > 1) {
-        MPI_Cancel(&m_reqAny);
-        MPI_Wait(&m_reqAny, MPI_STATUS_IGNORE);
         MPI_Cancel(&m_reqToRank);
         MPI_Wait(&m_reqToRank, MPI_STATUS_IGNORE);
     }
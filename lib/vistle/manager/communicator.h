@@ -1,6 +1,8 @@
 #ifndef COMMUNICATOR_COLLECTIVE_H
 #define COMMUNICATOR_COLLECTIVE_H
 
+#include <deque>
+#include <memory>
 #include <vector>
 #include <set>
 
@@ -25,10 +27,19 @@ class Communicator {
 public:
     enum MpiTags {
         TagToRank,
-        TagStartBroadcast,
+        TagToRankPayload,
         TagData,
     };
 
+    //! time messages spend in the communicator until their transfer has completed
+    struct Latency {
+        size_t count = 0;
+        double total = 0., max = 0.;
+
+        void add(double seconds);
+        double average() const;
+    };
+
     Communicator(int rank, const std::vector<std::string> &hosts, boost::mpi::communicator comm);
     ~Communicator();
     static Communicator &the();
@@ -56,6 +67,11 @@ public:
     void lock();
     void unlock();
 
+    //! latencies of broadcasts and messages to individual ranks, indexed by message type
+    const std::vector<Latency> &broadcastLatency() const;
+    const std::vector<Latency> &toRankLatency() const;
+    void printLatency() const;
+
 private:
     bool sendHub(const message::Message &message, const MessagePayload &payload = MessagePayload());
     bool connectData();
@@ -72,21 +88,66 @@ private:
     const int m_size;
     std::string m_vistleRoot;
 
-    unsigned m_recvSize;
-    message::Buffer m_recvBufToRank, m_recvBufToAny;
-    MPI_Request m_reqAny, m_reqToRank;
+    message::Buffer m_recvBufToRank;
+    MPI_Request m_reqToRank;
     struct SendRequest {
         SendRequest(const message::Message &msg): buf(msg) {}
         SendRequest(const message::Buffer &buf): buf(buf) {}
         message::Buffer buf;
         MessagePayload payload;
         MPI_Request req, payload_req;
+        double start = 0.;
 
         bool waitComplete();
         bool testComplete();
     };
     std::set<std::shared_ptr<SendRequest>> m_ongoingSends;
     bool startSend(int destRank, const message::Message &message, const MessagePayload &payload);
+    struct RecvRequest {
+        RecvRequest(const message::Buffer &buf): buf(buf) {}
+        message::Buffer buf;
+        MessagePayload payload;
+        MPI_Request req = MPI_REQUEST_NULL;
+        double start = 0.;
+
+        bool testComplete();
+    };
+    //! messages from other ranks in order of arrival, waiting for their payload
+    std::deque<std::shared_ptr<RecvRequest>> m_ongoingRecvs;
+
+    // broadcasts are sent from rank 0 with non-blocking collectives on a separate communicator,
+    // so that they cannot be confused with collective operations on m_comm
+    boost::mpi::communicator m_bcastComm;
+    struct BroadcastFrame {
+        uint64_t header[2] = {0, 0}; //< number of messages, number of bytes
+        std::vector<char> data;
+        std::vector<MPI_Request> reqs;
+        std::vector<std::pair<int, double>> messages; //< type and time of queueing (rank 0)
+        double start = 0.;
+
+        void postData(MPI_Comm comm);
+        bool testComplete();
+        void waitComplete();
+    };
+    std::deque<std::unique_ptr<BroadcastFrame>> m_sendFrames, m_recvFrames;
+    std::unique_ptr<BroadcastFrame> m_recvHeader;
+    struct QueuedMessage {
+        QueuedMessage(const message::Message &msg, const MessagePayload &payload);
+        message::Buffer buf;
+        MessagePayload payload;
+        double queued = 0.;
+    };
+    //! broadcasts not yet sent to other ranks and broadcasts not yet handled on rank 0
+    std::deque<QueuedMessage> m_pendingBroadcasts, m_unhandledBroadcasts;
+    bool m_handlingBroadcasts = false;
+    void queueBroadcast(const message::Message &message, const MessagePayload &payload);
+    void postPendingBroadcasts();
+    bool flushBroadcasts();
+    void postBroadcastHeader();
+    bool progressBroadcasts(bool *received);
+    void shutdownBroadcasts();
+
+    std::vector<Latency> m_broadcastLatency, m_toRankLatency;
 
     static Communicator *s_singleton;
 
@@ -1,5 +1,6 @@
 #include <cstdlib>
 #include <cstdio>
+#include <climits>
 
 #include <sys/types.h>
 
@@ -276,6 +277,19 @@ Module::Module(const std::string &moduleName, const int moduleId, mpi::communica
         addIntParameter("_concurrency", "number of tasks to keep in flight per MPI rank (-1: #cores/2)", -1);
     setParameterRange(m_concurrency, Integer(-1), Integer(hardware_concurrency()));
 
+    m_broadcastSegmentSize = addIntParameter("_broadcast_segment_size",
+                                             "size of segments for pipelined object broadcast in KiB (0: unsegmented)",
+                                             PipelinedBroadcast::DefaultSegmentSize / 1024);
+    setParameterRange(m_broadcastSegmentSize, Integer(0), Integer(INT_MAX / 1024));
+    m_broadcastTopology = addIntParameter("_broadcast_topology", "forwarding of segments during object broadcast",
+                                          PipelinedBroadcast::Tree, Parameter::Choice);
+    V_ENUM_SET_CHOICES_SCOPE(m_broadcastTopology, Topology, PipelinedBroadcast);
+
+    m_objectBatchSize = addIntParameter("_object_batch_size",
+                                        "maximum number of objects per output port announced in a single message", 64);
+    setParameterRange(m_objectBatchSize, Integer(1), Integer(65536));
+    m_maxObjectBatch = m_objectBatchSize->getValue();
+
     int leader = Shm::the().owningRank();
     m_commShmGroup = boost::mpi::communicator(m_comm.split(leader));
     m_commShmLeaders = boost::mpi::communicator(m_comm.split(leader == m_rank ? 1 : MPI_UNDEFINED));
@@ -592,9 +606,26 @@ bool Module::removeParameter(Parameter *param)
     return ParameterManager::removeParameter(param);
 }
 
+namespace {
+
+// load object from its archive, after all its arrays have been made available in shm
+Object::ptr loadTransferredObject(const buffer &mem, const std::map<std::string, buffer> &objects)
+{
+    std::map<std::string, buffer> arrays;
+    std::map<std::string, message::CompressionMode> comp;
+    std::map<std::string, size_t> rawsizes;
+    vecistreambuf<buffer> membuf(mem);
+    vistle::iarchive memar(membuf);
+    auto fetcher = std::make_shared<DeepArchiveFetcher>(objects, arrays, comp, rawsizes);
+    memar.setFetcher(fetcher);
+    return Object::ptr(Object::loadObject(memar));
+}
+
+} // namespace
+
 bool Module::sendObject(const mpi::communicator &comm, Object::const_ptr obj, int destRank) const
 {
-    auto saver = std::make_shared<DeepArchiveSaver>();
+    auto saver = std::make_shared<ShallowArraySaver>();
     vecostreambuf<buffer> memstr;
     vistle::oarchive memar(memstr);
     memar.setSaver(saver);
@@ -606,6 +637,16 @@ bool Module::sendObject(const mpi::communicator &comm, Object::const_ptr obj, in
     for (auto &ent: dir) {
         comm.send(destRank, 0, ent.data, ent.size);
     }
+    // array contents are sent directly from shm, unless receiver already has them
+    auto arrays = saver->getArrayDirectory();
+    comm.send(destRank, 0, arrays);
+    std::vector<char> missing;
+    comm.recv(destRank, 0, missing);
+    assert(missing.size() == arrays.size());
+    for (size_t i = 0; i < arrays.size(); ++i) {
+        if (missing[i])
+            comm.send(destRank, 0, arrays[i].data, arrays[i].size);
+    }
     return true;
 }
 
@@ -619,25 +660,24 @@ Object::const_ptr Module::receiveObject(const mpi::communicator &comm, int sourc
     buffer mem;
     comm.recv(sourceRank, 0, mem);
     vistle::SubArchiveDirectory dir;
-    std::map<std::string, buffer> objects, arrays;
-    std::map<std::string, message::CompressionMode> comp;
-    std::map<std::string, size_t> rawsizes;
+    std::map<std::string, buffer> objects;
     comm.recv(sourceRank, 0, dir);
     for (auto &ent: dir) {
-        if (ent.is_array) {
-            arrays[ent.name].resize(ent.size);
-            ent.data = arrays[ent.name].data();
-        } else {
-            objects[ent.name].resize(ent.size);
-            ent.data = objects[ent.name].data();
-        }
+        assert(!ent.is_array);
+        objects[ent.name].resize(ent.size);
+        ent.data = objects[ent.name].data();
         comm.recv(sourceRank, 0, ent.data, ent.size);
     }
-    vecistreambuf<buffer> membuf(mem);
-    vistle::iarchive memar(membuf);
-    auto fetcher = std::make_shared<DeepArchiveFetcher>(objects, arrays, comp, rawsizes);
-    memar.setFetcher(fetcher);
-    Object::ptr p(Object::loadObject(memar));
+    // receive array contents into their final location in shm
+    vistle::RawArrayDirectory arrays;
+    comm.recv(sourceRank, 0, arrays);
+    auto missing = prepareRawArrays(arrays);
+    comm.send(sourceRank, 0, missing);
+    for (size_t i = 0; i < arrays.size(); ++i) {
+        if (missing[i])
+            comm.recv(sourceRank, 0, arrays[i].data, arrays[i].size);
+    }
+    Object::ptr p = loadTransferredObject(mem, objects);
     //CERR << "receiveObject " << p->getName() << ": refcount=" << p->refcount() << std::endl;
     return p;
 }
@@ -652,44 +692,71 @@ bool Module::broadcastObject(const mpi::communicator &comm, Object::const_ptr &o
     if (comm.size() == 1)
         return true;
 
+    buffer mem;
+    std::map<std::string, buffer> objects;
+    vistle::RawArrayDirectory arrays;
+    std::vector<char> missing;
     if (comm.rank() == root) {
         vecostreambuf<buffer> memstr;
         vistle::oarchive memar(memstr);
-        auto saver = std::make_shared<DeepArchiveSaver>();
+        auto saver = std::make_shared<ShallowArraySaver>();
         memar.setSaver(saver);
         obj->saveObject(memar);
-        const buffer &mem = memstr.get_vector();
-        mpi::broadcast(comm, const_cast<buffer &>(mem), root);
+        mem = std::move(memstr.get_vector());
+        mpi::broadcast(comm, mem, root);
         auto dir = saver->getDirectory();
         mpi::broadcast(comm, dir, root);
         for (auto &ent: dir) {
             mpi::broadcast(comm, ent.data, ent.size, root);
         }
+        arrays = saver->getArrayDirectory();
+        mpi::broadcast(comm, arrays, root);
+        missing.resize(arrays.size(), 0);
     } else {
-        buffer mem;
         mpi::broadcast(comm, mem, root);
         vistle::SubArchiveDirectory dir;
-        std::map<std::string, buffer> objects, arrays;
-        std::map<std::string, message::CompressionMode> comp;
-        std::map<std::string, size_t> rawsizes;
         mpi::broadcast(comm, dir, root);
         for (auto &ent: dir) {
-            if (ent.is_array) {
-                arrays[ent.name].resize(ent.size);
-                ent.data = arrays[ent.name].data();
-            } else {
-                objects[ent.name].resize(ent.size);
-                ent.data = objects[ent.name].data();
-            }
+            assert(!ent.is_array);
+            objects[ent.name].resize(ent.size);
+            ent.data = objects[ent.name].data();
             mpi::broadcast(comm, ent.data, ent.size, root);
         }
-        vecistreambuf<buffer> membuf(mem);
-        vistle::iarchive memar(membuf);
-        auto fetcher = std::make_shared<DeepArchiveFetcher>(objects, arrays, comp, rawsizes);
-        memar.setFetcher(fetcher);
-        obj.reset(Object::loadObject(memar));
+        mpi::broadcast(comm, arrays, root);
+        missing = missingRawArrays(arrays);
+    }
+
+    // only arrays missing on at least one rank are transferred,
+    // ranks already having them receive into scratch memory for forwarding
+    std::vector<char> anyMissing(missing.size());
+    if (!missing.empty())
+        mpi::all_reduce(comm, missing.data(), missing.size(), anyMissing.data(), mpi::maximum<char>());
+    std::vector<size_t> transfer, sizes;
+    for (size_t i = 0; i < arrays.size(); ++i) {
+        if (anyMissing[i]) {
+            transfer.push_back(i);
+            sizes.push_back(arrays[i].size);
+        }
+    }
+    std::map<size_t, buffer> scratch;
+    auto topology = PipelinedBroadcast::Topology(m_broadcastTopology->getValue());
+    size_t segmentSize = m_broadcastSegmentSize->getValue() * 1024;
+    PipelinedBroadcast bcast(comm, root, topology, segmentSize);
+    bcast.broadcast(sizes, [&](size_t idx) -> char * {
+        auto &ent = arrays[transfer[idx]];
+        if (comm.rank() == root)
+            return ent.data;
+        if (missing[transfer[idx]] && createRawArray(ent))
+            return ent.data;
+        auto &buf = scratch[idx];
+        buf.resize(std::max(ent.size, size_t(1)));
+        return buf.data();
+    });
+    m_broadcastStats += bcast.statistics();
+
+    if (comm.rank() != root) {
+        obj = loadTransferredObject(mem, objects);
         //std::cerr << "broadcastObject recv " << obj->getName() << ": refcount=" << obj->refcount() << std::endl;
-        //obj->unref();
     }
 
     return true;
@@ -700,6 +767,18 @@ bool Module::broadcastObject(Object::const_ptr &object, int root) const
     return broadcastObject(comm(), object, root);
 }
 
+const PipelinedBroadcast::Statistics &Module::broadcastStatistics() const
+{
+    return m_broadcastStats;
+}
+
+TaskPool::Statistics Module::taskStatistics() const
+{
+    if (!m_taskPool)
+        return TaskPool::Statistics();
+    return m_taskPool->statistics();
+}
+
 bool Module::broadcastObjectViaShm(Object::const_ptr &object, const std::string &objName, int root) const
 {
     if (shmLeader(rank()) == shmLeader(root)) {
@@ -824,11 +903,43 @@ bool Module::passThroughObject(Port *port, vistle::Object::const_ptr object)
     object->refresh();
     assert(object->check());
 
-    message::AddObject message(port->getName(), object);
-    sendMessage(message);
+    std::lock_guard<std::recursive_mutex> guard(m_objectBatchMutex);
+    auto &objects = m_objectBatches[port];
+    objects.push_back(object);
+    if (objects.size() >= m_maxObjectBatch) {
+        std::vector<Object::const_ptr> batch;
+        std::swap(batch, objects);
+        sendObjects(port, batch);
+    }
     return true;
 }
 
+void Module::sendObjects(const Port *port, const std::vector<Object::const_ptr> &objects) const
+{
+    if (objects.empty())
+        return;
+
+    if (objects.size() == 1) {
+        message::AddObject message(port->getName(), objects[0]);
+        sendMessage(message);
+        return;
+    }
+
+    message::AddObjects::Payload pl(objects);
+    message::AddObjects message(port->getName(), pl);
+    sendMessageWithPayload(message, pl);
+}
+
+void Module::flushObjectBatches() const
+{
+    // objects are only ordered per port, so batches may be sent in any order
+    std::lock_guard<std::recursive_mutex> guard(m_objectBatchMutex);
+    std::map<const Port *, std::vector<Object::const_ptr>> batches;
+    std::swap(batches, m_objectBatches);
+    for (const auto &b: batches)
+        sendObjects(b.first, b.second);
+}
+
 ObjectList Module::getObjects(const std::string &portName)
 {
     ObjectList objects;
@@ -890,8 +1001,18 @@ void Module::addResultCache(ResultCacheBase &cache)
 
 void Module::clearResultCaches()
 {
-    for (auto &c: m_resultCaches)
-        c->clear();
+    for (auto &c: m_resultCaches) {
+        if (!c->isPersistent())
+            c->clear();
+    }
+}
+
+void Module::pruneResultCaches()
+{
+    for (auto &c: m_resultCaches) {
+        if (c->isPersistent())
+            c->prune();
+    }
 }
 
 void Module::enableResultCaches(bool on)
@@ -1024,6 +1145,9 @@ bool Module::changeParameter(const Parameter *p)
             m_prioritizeVisible = getIntParameter("_prioritize_visible");
         } else if (name == "_use_result_cache") {
             enableResultCaches(getIntParameter(name));
+        } else if (name == "_object_batch_size") {
+            std::lock_guard<std::recursive_mutex> guard(m_objectBatchMutex);
+            m_maxObjectBatch = std::max(Integer(1), getIntParameter(name));
         }
     }
 
@@ -1166,6 +1290,8 @@ bool Module::dispatch(bool block, bool *messageReceived, unsigned int minPrio)
             throw(except::parent_died());
 #endif
 
+        flushObjectBatches();
+
         message::Buffer buf;
         if (!getNextMessage(buf, block, minPrio)) {
             if (messageReceived)
@@ -1237,6 +1363,10 @@ void Module::sendParameterMessage(const message::Message &message, const buffer
 
 bool Module::sendMessage(const message::Message &message, const buffer *payload) const
 {
+    // objects have to be announced before any message that might depend on them
+    if (message.type() != message::ADDOBJECT && message.type() != message::ADDOBJECTS)
+        flushObjectBatches();
+
     // exclude SendText messages to avoid circular calls
     if (message.type() != message::SENDTEXT && (m_traceMessages == message::ANY || m_traceMessages == message.type())) {
         CERR << "SEND: " << message << std::endl;
@@ -1264,6 +1394,10 @@ bool Module::sendMessage(const message::Message &message, const buffer *payload)
 
 bool Module::sendMessage(const message::Message &message, const MessagePayload &payload) const
 {
+    // objects have to be announced before any message that might depend on them
+    if (message.type() != message::ADDOBJECT && message.type() != message::ADDOBJECTS)
+        flushObjectBatches();
+
     // exclude SendText messages to avoid circular calls
     if (message.type() != message::SENDTEXT && (m_traceMessages == message::ANY || m_traceMessages == message.type())) {
         CERR << "SEND: " << message << std::endl;
@@ -1531,6 +1665,27 @@ bool Module::handleMessage(const vistle::message::Message *message, const Messag
         break;
     }
 
+    case message::ADDOBJECTS: {
+        const message::AddObjects *add = static_cast<const message::AddObjects *>(message);
+        assert(payload);
+        if (!payload) {
+            CERR << "no payload for AddObjects to port " << add->getDestPort() << std::endl;
+            return true;
+        }
+        buffer data(payload->begin(), payload->end());
+        auto pl = message::getPayload<message::AddObjects::Payload>(data);
+        for (const auto &obj: add->takeObjects(pl)) {
+            // handle individually, so that every object is seen by handleMessage overrides
+            message::AddObject single(add->getSenderPort(), obj, add->getDestPort());
+            single.setSenderId(add->senderId());
+            single.setRank(add->rank());
+            single.setDestId(add->destId());
+            if (!handleMessage(&single, MessagePayload()))
+                return false;
+        }
+        break;
+    }
+
     case message::SETPARAMETER: {
         const message::SetParameter *param = static_cast<const message::SetParameter *>(message);
 
@@ -2151,6 +2306,9 @@ Module::~Module()
     delete receiveMessageQueue;
     receiveMessageQueue = nullptr;
 
+    // workers return their cached shm blocks when they exit
+    m_taskPool.reset();
+
 #ifndef MODULE_THREAD
     Shm::the().detach();
 #endif
@@ -2307,6 +2465,7 @@ bool Module::prepareWrapper(const message::Execute *exec)
     m_executeAfterCancelFound = false;
 
     clearResultCaches();
+    pruneResultCaches();
 
     m_withOutput.clear();
 
@@ -2342,6 +2501,9 @@ bool Module::prepareWrapper(const message::Execute *exec)
     if (m_benchmark) {
         comm().barrier();
         m_benchmarkStart = Clock::time();
+        m_broadcastStats = PipelinedBroadcast::Statistics();
+        if (m_taskPool)
+            m_taskPool->resetStatistics();
     }
 
     //CERR << "prepareWrapper: prepared=" << m_prepared << std::endl;
@@ -2379,17 +2541,25 @@ bool Module::compute()
     if (concurrency <= 1)
         concurrency = 1;
 
-    while (m_tasks.size() >= unsigned(concurrency)) {
+    if (!m_taskPool)
+        m_taskPool.reset(new TaskPool(name() + ":Block", concurrency));
+    else
+        m_taskPool->setNumThreads(concurrency);
+
+    // blocks may finish out of order, but their results are added in order of submission
+    while (!m_tasks.empty() && m_tasks.front()->isDone()) {
         m_tasks.front()->wait();
         m_tasks.pop_front();
     }
+    // a slow block only stalls submission once all workers have been kept busy for a while
+    m_taskPool->waitPending(2 * concurrency - 1);
     m_tasks.push_back(task);
 
     std::unique_lock<std::mutex> guard(task->m_mutex);
-    auto tname = name() + ":Block:" + std::to_string(m_tasks.size());
-    task->m_future = std::async(std::launch::async, [this, tname, task] {
-        setThreadName(tname);
-        return compute(task);
+    // task is kept alive by m_tasks, holding a reference from its own future would create a cycle
+    task->m_future = m_taskPool->submit([this, weak = std::weak_ptr<BlockTask>(task)] {
+        auto task = weak.lock();
+        return task && compute(task);
     });
     return true;
 }
@@ -2484,6 +2654,22 @@ bool Module::reduceWrapper(const message::Execute *exec, bool reordered)
             printf("%s:%d: compute() took %fs (no OpenMP)", name().c_str(), id(), duration);
 #endif
         }
+        const auto &bs = m_broadcastStats;
+        if (bs.buffers > 0) {
+            CERR << "broadcast " << bs.buffers << " arrays in " << bs.segments << " segments: " << bs.bytes
+                 << " bytes in " << bs.seconds << "s (" << bs.throughput() / (1024. * 1024.) << " MiB/s)"
+                 << std::endl;
+        }
+        const auto ts = taskStatistics();
+        if (ts.submitted > 0) {
+            CERR << "tasks: " << ts.completed << " of " << ts.submitted << " completed, " << ts.stolen
+                 << " stolen, max. queue depth " << ts.maxPending << ", " << ts.idleSeconds << "s idle" << std::endl;
+        }
+#ifndef NO_SHMEM
+        if (auto arena = Shm::the().arena()) {
+            CERR << "shm arena: " << arena->statistics() << std::endl;
+        }
+#endif
     }
 
     message::ExecutionProgress fin(message::ExecutionProgress::Finish, m_executionCount);
@@ -2691,6 +2877,11 @@ bool BlockTask::wait()
     return result;
 }
 
+bool BlockTask::isDone() const
+{
+    return m_future.valid() && m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
 bool BlockTask::waitDependencies()
 {
     std::unique_lock<std::mutex> guard(m_mutex);
@@ -41,6 +41,8 @@
 #include "objectcache.h"
 #define RESULTCACHE_SKIP_DEFINITION
 #include "resultcache.h"
+#include "pipelinedbroadcast.h"
+#include "taskpool.h"
 #undef RESULTCACHE_SKIP_DEFINITION
 #include "export.h"
 
@@ -99,6 +101,7 @@ protected:
 
     bool wait();
     bool waitDependencies();
+    bool isDone() const;
 
     Module *m_module = nullptr;
     std::map<const Port *, Object::const_ptr> m_input;
@@ -157,6 +160,10 @@ public:
     bool broadcastObject(const mpi::communicator &comm, vistle::Object::const_ptr &object, int root) const;
     bool broadcastObject(vistle::Object::const_ptr &object, int root) const;
     bool broadcastObjectViaShm(vistle::Object::const_ptr &object, const std::string &objName, int root) const;
+    //! transfer statistics of array contents broadcast from or received on this rank
+    const PipelinedBroadcast::Statistics &broadcastStatistics() const;
+    //! queue depth and idle time of threads working on compute(std::shared_ptr<BlockTask>)
+    TaskPool::Statistics taskStatistics() const;
 
     bool addObject(Port *port, vistle::Object::ptr object);
     bool addObject(const std::string &portName, vistle::Object::ptr object);
@@ -314,7 +321,8 @@ protected:
     bool reduceWrapper(const message::Execute *exec, bool reordered = false);
     bool prepareWrapper(const message::Execute *exec);
 
-    void clearResultCaches();
+    void clearResultCaches(); //< clear all but persistent result caches
+    void pruneResultCaches(); //< discard unused entries from persistent result caches
     void enableResultCaches(bool on);
 
 private:
@@ -364,6 +372,17 @@ private:
     mpi::communicator m_comm, m_commShmGroup, m_commShmLeaders;
     std::vector<int> m_shmLeaders; // leader rank in m_comm of m_commShmGroup for every rank in m_comm
     std::vector<int> m_shmLeadersSubrank; // leader rank in m_commShmLeaders of m_commShmGroup for every rank in m_comm
+    IntParameter *m_broadcastSegmentSize = nullptr, *m_broadcastTopology = nullptr;
+    mutable PipelinedBroadcast::Statistics m_broadcastStats;
+
+    //! objects added to an output port are announced to the manager in batches
+    IntParameter *m_objectBatchSize = nullptr;
+    //! held while sending, so that objects stay in order on each port, recursive as sending may flush batches
+    mutable std::recursive_mutex m_objectBatchMutex;
+    size_t m_maxObjectBatch = 1;
+    mutable std::map<const Port *, std::vector<Object::const_ptr>> m_objectBatches;
+    void sendObjects(const Port *port, const std::vector<Object::const_ptr> &objects) const;
+    void flushObjectBatches() const;
 
     int m_numTimesteps;
     bool m_cancelRequested = false, m_cancelExecuteCalled = false, m_executeAfterCancelFound = false;
@@ -377,6 +396,7 @@ private:
     void waitAllTasks();
     std::shared_ptr<BlockTask> m_lastTask;
     std::deque<std::shared_ptr<BlockTask>> m_tasks;
+    std::unique_ptr<TaskPool> m_taskPool;
 
     unsigned m_hardware_concurrency = 1;
 };
@@ -0,0 +1,159 @@
+#include "pipelinedbroadcast.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <deque>
+
+#include <mpi.h>
+
+#include <vistle/util/stopwatch.h>
+
+namespace vistle {
+
+namespace {
+
+const int Tag = 1001;
+const size_t Window = 4; //< number of segments in flight per peer
+
+struct Segment {
+    size_t buffer;
+    size_t offset;
+    int count;
+};
+
+void waitAll(std::deque<MPI_Request> &reqs)
+{
+    while (!reqs.empty()) {
+        MPI_Wait(&reqs.front(), MPI_STATUS_IGNORE);
+        reqs.pop_front();
+    }
+}
+
+} // namespace
+
+PipelinedBroadcast::Statistics &PipelinedBroadcast::Statistics::operator+=(const Statistics &other)
+{
+    bytes += other.bytes;
+    segments += other.segments;
+    buffers += other.buffers;
+    seconds += other.seconds;
+    return *this;
+}
+
+double PipelinedBroadcast::Statistics::throughput() const
+{
+    if (seconds <= 0.)
+        return 0.;
+    return bytes / seconds;
+}
+
+PipelinedBroadcast::PipelinedBroadcast(const boost::mpi::communicator &comm, int root, Topology topology,
+                                       size_t segmentSize)
+: m_comm(comm), m_root(root), m_topology(topology), m_segmentSize(segmentSize)
+{
+    if (m_segmentSize == 0 || m_segmentSize > INT_MAX)
+        m_segmentSize = INT_MAX;
+}
+
+const PipelinedBroadcast::Statistics &PipelinedBroadcast::statistics() const
+{
+    return m_stats;
+}
+
+int PipelinedBroadcast::parent() const
+{
+    const int size = m_comm.size();
+    const int rel = (m_comm.rank() - m_root + size) % size;
+    if (rel == 0)
+        return -1;
+    const int relParent = m_topology == Ring ? rel - 1 : (rel - 1) / 2;
+    return (relParent + m_root) % size;
+}
+
+std::vector<int> PipelinedBroadcast::children() const
+{
+    const int size = m_comm.size();
+    const int rel = (m_comm.rank() - m_root + size) % size;
+    std::vector<int> result;
+    if (m_topology == Ring) {
+        if (rel + 1 < size)
+            result.push_back((rel + 1 + m_root) % size);
+    } else {
+        for (int c = 2 * rel + 1; c <= 2 * rel + 2 && c < size; ++c)
+            result.push_back((c + m_root) % size);
+    }
+    return result;
+}
+
+bool PipelinedBroadcast::broadcast(const std::vector<size_t> &sizes, const BufferFunc &buffer)
+{
+    const double start = Clock::time();
+    MPI_Comm comm = m_comm;
+    const int from = parent();
+    const auto to = children();
+
+    std::vector<Segment> segments;
+    std::vector<char *> data(sizes.size(), nullptr);
+    for (size_t b = 0; b < sizes.size(); ++b) {
+        if (sizes[b] == 0)
+            data[b] = buffer(b);
+        for (size_t off = 0; off < sizes[b]; off += m_segmentSize) {
+            segments.push_back(Segment{b, off, int(std::min(m_segmentSize, sizes[b] - off))});
+        }
+    }
+
+    // storage for a buffer is only requested when its first segment is posted,
+    // so that allocation overlaps with transfers of preceding segments
+    auto segmentData = [&data, &buffer](const Segment &seg) -> char * {
+        if (!data[seg.buffer]) {
+            data[seg.buffer] = buffer(seg.buffer);
+            assert(data[seg.buffer]);
+        }
+        return data[seg.buffer] + seg.offset;
+    };
+
+    std::deque<MPI_Request> recvs, sends;
+    size_t posted = 0;
+    auto postRecv = [&]() {
+        if (from < 0 || posted >= segments.size())
+            return;
+        const auto &seg = segments[posted];
+        recvs.emplace_back();
+        MPI_Irecv(segmentData(seg), seg.count, MPI_BYTE, from, Tag, comm, &recvs.back());
+        ++posted;
+    };
+    for (size_t i = 0; i < Window; ++i)
+        postRecv();
+
+    for (const auto &seg: segments) {
+        if (from >= 0) {
+            MPI_Wait(&recvs.front(), MPI_STATUS_IGNORE);
+            recvs.pop_front();
+        }
+        char *p = segmentData(seg);
+        for (int dest: to) {
+            sends.emplace_back();
+            MPI_Isend(p, seg.count, MPI_BYTE, dest, Tag, comm, &sends.back());
+        }
+        while (sends.size() > Window * to.size()) {
+            MPI_Wait(&sends.front(), MPI_STATUS_IGNORE);
+            sends.pop_front();
+        }
+        postRecv();
+    }
+    assert(recvs.empty());
+    waitAll(sends);
+
+    Statistics stats;
+    stats.buffers = sizes.size();
+    stats.segments = segments.size();
+    for (auto s: sizes)
+        stats.bytes += s;
+    stats.seconds = Clock::time() - start;
+    m_stats += stats;
+
+    return true;
+}
+
+} // namespace vistle
@@ -0,0 +1,61 @@
+#ifndef VISTLE_MODULE_PIPELINEDBROADCAST_H
+#define VISTLE_MODULE_PIPELINEDBROADCAST_H
+
+#include "export.h"
+
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include <boost/mpi/communicator.hpp>
+
+#include <vistle/util/enum.h>
+
+namespace vistle {
+
+//! broadcast of a sequence of large buffers, split into segments
+/*! segments are forwarded along a ring or a binary tree as soon as they arrive,
+ *  so that transfers to all ranks overlap and no single message exceeds the MPI count limit */
+class V_MODULEEXPORT PipelinedBroadcast {
+public:
+    DEFINE_ENUM_WITH_STRING_CONVERSIONS(Topology, (Tree)(Ring))
+
+    static const size_t DefaultSegmentSize = 4 * 1024 * 1024;
+
+    struct Statistics {
+        size_t bytes = 0; //!< payload received or sent by root
+        size_t segments = 0;
+        size_t buffers = 0;
+        double seconds = 0.;
+
+        Statistics &operator+=(const Statistics &other);
+        double throughput() const; //!< bytes per second
+    };
+
+    //! return pointer to contents of buffer idx
+    /*! on root, this is the data to be sent, on all other ranks the storage to receive into,
+     *  it is called right before the first segment of a buffer is needed */
+    typedef std::function<char *(size_t idx)> BufferFunc;
+
+    PipelinedBroadcast(const boost::mpi::communicator &comm, int root, Topology topology = Tree,
+                       size_t segmentSize = DefaultSegmentSize);
+
+    //! transfer buffers of the given sizes from root to all other ranks
+    bool broadcast(const std::vector<size_t> &sizes, const BufferFunc &buffer);
+    const Statistics &statistics() const;
+
+private:
+    int parent() const;
+    std::vector<int> children() const;
+
+    const boost::mpi::communicator &m_comm;
+    int m_root;
+    Topology m_topology;
+    size_t m_segmentSize;
+    Statistics m_stats;
+};
+
+V_ENUM_OUTPUT_OP(Topology, PipelinedBroadcast)
+
+} // namespace vistle
+#endif
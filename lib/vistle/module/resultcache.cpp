@@ -9,4 +9,14 @@ void ResultCacheBase::enable(bool on)
 {
     m_enabled = on;
 }
+
+void ResultCacheBase::setPersistent(bool persistent)
+{
+    m_persistent = persistent;
+}
+
+bool ResultCacheBase::isPersistent() const
+{
+    return m_persistent;
+}
 } // namespace vistle
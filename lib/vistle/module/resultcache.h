@@ -13,13 +13,20 @@ class V_MODULEEXPORT ResultCacheBase {
 public:
     virtual ~ResultCacheBase();
     virtual void clear() = 0;
+    //! discard entries that have not been accessed since the previous call
+    virtual void prune() = 0;
     virtual void enable(bool on);
+    //! persistent caches are not cleared between executions, only pruned
+    void setPersistent(bool persistent);
+    bool isPersistent() const;
 
 protected:
     bool m_enabled = true;
+    bool m_persistent = false;
 };
 
 //! data structure for retaining data that can be reused between timesteps
+/*! if persistent, data is retained across executions for as long as it is used in each of them */
 template<class Result>
 class ResultCache: public ResultCacheBase {
 public:
@@ -29,6 +36,7 @@ public:
     private:
         std::mutex mutex;
         Result data;
+        bool used = true;
     };
 
     //! if available, retrieve value for key and store to result, return false otherwise
@@ -40,6 +48,7 @@ public:
     bool storeAndUnlock(Entry *entry, const Result &data);
     //! discard all currently stored values
     void clear() override;
+    void prune() override;
 
 protected:
     std::map<std::string, Entry> m_cache;
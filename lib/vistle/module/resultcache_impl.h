@@ -18,6 +18,7 @@ bool ResultCache<Result>::tryGet(const std::string &key, Result &result)
     }
 
     auto &ent = it->second;
+    ent.used = true;
     guard.unlock();
     if (!ent.mutex.try_lock()) {
         return false;
@@ -43,6 +44,7 @@ typename ResultCache<Result>::Entry *ResultCache<Result>::getOrLock(const std::s
     }
 
     auto &ent = it->second;
+    ent.used = true;
     guard.unlock();
     std::unique_lock<std::mutex> member_guard(ent.mutex);
     result = ent.data;
@@ -69,6 +71,20 @@ void ResultCache<Result>::clear()
     m_cache.clear();
 }
 
+template<class Result>
+void ResultCache<Result>::prune()
+{
+    std::unique_lock<std::mutex> guard(m_mutex);
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        if (it->second.used) {
+            it->second.used = false;
+            ++it;
+        } else {
+            it = m_cache.erase(it);
+        }
+    }
+}
+
 } // namespace vistle
 
 #endif
@@ -0,0 +1,168 @@
+#include "taskpool.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <vistle/util/stopwatch.h>
+#include <vistle/util/threadname.h>
+#include <vistle/core/shm_arena.h>
+
+namespace vistle {
+
+TaskPool::TaskPool(const std::string &name, unsigned numThreads): m_name(name)
+{
+    start(numThreads);
+}
+
+TaskPool::~TaskPool()
+{
+    stop();
+}
+
+unsigned TaskPool::numThreads() const
+{
+    return m_workers.size();
+}
+
+void TaskPool::setNumThreads(unsigned numThreads)
+{
+    numThreads = std::max(1u, numThreads);
+    if (numThreads == m_workers.size())
+        return;
+    stop();
+    start(numThreads);
+}
+
+void TaskPool::start(unsigned numThreads)
+{
+    assert(m_workers.empty());
+    numThreads = std::max(1u, numThreads);
+    m_quit = false;
+    m_next = 0;
+    for (unsigned i = 0; i < numThreads; ++i)
+        m_workers.emplace_back(new Worker);
+    for (unsigned i = 0; i < numThreads; ++i)
+        m_workers[i]->thread = std::thread([this, i]() { run(i); });
+}
+
+void TaskPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_quit = true;
+    }
+    m_wakeup.notify_all();
+    for (auto &w: m_workers) {
+        if (w->thread.joinable())
+            w->thread.join();
+    }
+    m_workers.clear();
+}
+
+std::shared_future<bool> TaskPool::submit(std::function<bool()> func)
+{
+    assert(!m_workers.empty());
+    Task task(std::move(func));
+    auto future = task.get_future().share();
+
+    // announce task before queueing it, so that no worker misses it
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        ++m_queued;
+        ++m_pending;
+        ++m_stats.submitted;
+        m_stats.maxPending = std::max(m_stats.maxPending, m_pending);
+    }
+    auto &w = *m_workers[m_next];
+    m_next = (m_next + 1) % m_workers.size();
+    {
+        std::lock_guard<std::mutex> guard(w.mutex);
+        w.queue.emplace_back(std::move(task));
+    }
+    m_wakeup.notify_one();
+
+    return future;
+}
+
+size_t TaskPool::pending() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_pending;
+}
+
+void TaskPool::waitPending(size_t maxPending)
+{
+    std::unique_lock<std::mutex> guard(m_mutex);
+    m_finished.wait(guard, [this, maxPending]() { return m_pending <= maxPending; });
+}
+
+TaskPool::Statistics TaskPool::statistics() const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_stats;
+}
+
+void TaskPool::resetStatistics()
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_stats = Statistics();
+    m_stats.maxPending = m_pending;
+}
+
+bool TaskPool::take(unsigned idx, Task &task)
+{
+    const unsigned n = m_workers.size();
+    for (unsigned i = 0; i < n; ++i) {
+        auto &w = *m_workers[(idx + i) % n];
+        std::lock_guard<std::mutex> guard(w.mutex);
+        if (w.queue.empty())
+            continue;
+        if (i == 0) {
+            task = std::move(w.queue.front());
+            w.queue.pop_front();
+        } else {
+            // steal from the end that the owner will get to last
+            task = std::move(w.queue.back());
+            w.queue.pop_back();
+        }
+        std::lock_guard<std::mutex> sguard(m_mutex);
+        --m_queued;
+        if (i > 0)
+            ++m_stats.stolen;
+        return true;
+    }
+    return false;
+}
+
+void TaskPool::run(unsigned idx)
+{
+    setThreadName(m_name + ":" + std::to_string(idx));
+
+    for (;;) {
+        Task task;
+        if (take(idx, task)) {
+            task();
+            {
+                std::lock_guard<std::mutex> guard(m_mutex);
+                --m_pending;
+                ++m_stats.completed;
+            }
+            m_finished.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(m_mutex);
+        if (m_quit && m_queued == 0)
+            break;
+        const double start = Clock::time();
+        m_wakeup.wait(guard, [this]() { return m_queued > 0 || m_quit; });
+        m_stats.idleSeconds += Clock::time() - start;
+    }
+
+#ifndef NO_SHMEM
+    // cached blocks would be lost once shm has been detached
+    ShmArena::releaseThreadCache();
+#endif
+}
+
+} // namespace vistle
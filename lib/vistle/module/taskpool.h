@@ -0,0 +1,71 @@
+#ifndef VISTLE_MODULE_TASKPOOL_H
+#define VISTLE_MODULE_TASKPOOL_H
+
+#include "export.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vistle {
+
+//! long-lived worker threads executing tasks in any order
+/*! each worker has its own queue, idle workers steal tasks from the queues of others */
+class V_MODULEEXPORT TaskPool {
+public:
+    struct Statistics {
+        size_t submitted = 0;
+        size_t completed = 0;
+        size_t stolen = 0; //!< tasks taken from the queue of another worker
+        size_t maxPending = 0; //!< maximum number of tasks queued or running at the same time
+        double idleSeconds = 0.; //!< accumulated over all workers
+    };
+
+    TaskPool(const std::string &name, unsigned numThreads);
+    ~TaskPool();
+
+    unsigned numThreads() const;
+    //! waits for all submitted tasks to finish if number of threads changes
+    void setNumThreads(unsigned numThreads);
+
+    std::shared_future<bool> submit(std::function<bool()> func);
+    //! number of tasks queued or running
+    size_t pending() const;
+    //! block until no more than maxPending tasks are queued or running
+    void waitPending(size_t maxPending);
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+private:
+    typedef std::packaged_task<bool()> Task;
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> queue;
+        std::thread thread;
+    };
+
+    void start(unsigned numThreads);
+    void stop();
+    void run(unsigned idx);
+    bool take(unsigned idx, Task &task);
+
+    std::string m_name;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    unsigned m_next = 0;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeup, m_finished;
+    size_t m_queued = 0, m_pending = 0;
+    bool m_quit = false;
+    Statistics m_stats;
+};
+
+} // namespace vistle
+#endif
@@ -4,6 +4,7 @@
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/map.hpp>
+#include <vistle/util/stopwatch.h>
 
 #include <IceT.h>
 #include <IceTMPI.h>
@@ -530,10 +531,12 @@ void ParallelRemoteRenderManager::finishCurrentView(const IceTImagePtr imgp, int
                 }
 
                 if (color && depth && rhr->rgba(i) && rhr->depth(i)) {
+                    double start = Clock::time();
                     for (int y = 0; y < h; ++y) {
                         memcpy(rhr->rgba(i) + w * bpp * y, color + w * (h - 1 - y) * bpp, bpp * w);
                         memcpy(rhr->depth(i) + w * y, depth + w * (h - 1 - y), sizeof(float) * w);
                     }
+                    rhr->addReadbackTime(Clock::time() - start);
 
                     m_viewData[i].rhrParam.timestep = timestep;
                     rhr->invalidate(i, 0, 0, rhr->width(i), rhr->height(i), m_viewData[i].rhrParam, lastView);
@@ -83,6 +83,18 @@ RhrController::RhrController(vistle::Module *module, int displayRank)
 
     m_dumpImagesParam = module->addIntParameter("rhr_dump_images", "dump image data to disk", (Integer)m_dumpImages,
                                                 Parameter::Boolean);
+    m_printTimingsParam =
+        module->addIntParameter("rhr_print_timings", "print readback, encode and send times for every frame",
+                                (Integer)m_printTimings, Parameter::Boolean);
+    m_skipUnchangedParam = module->addIntParameter(
+        "skip_unchanged_tiles", "only send references to tiles that did not change since previous frame",
+        (Integer)m_skipUnchanged, Parameter::Boolean);
+    m_adaptQualityParam = module->addIntParameter(
+        "adapt_quality", "reduce image quality while view changes to keep target frame rate on slow connections",
+        (Integer)m_adaptQuality, Parameter::Boolean);
+    m_targetFpsParam =
+        module->addFloatParameter("target_fps", "frame rate to keep while adapting quality", m_targetFps);
+    module->setParameterMinimum(m_targetFpsParam, (Float)1.);
 
     initializeServer();
 }
@@ -144,6 +156,10 @@ bool RhrController::initializeServer()
     m_rhr->setColorCodec(m_rgbaCodec);
     m_rhr->setTileSize(m_sendTileSize[0], m_sendTileSize[1]);
     m_rhr->setColorCompression(m_rgbaCompress);
+    m_rhr->setPrintTimings(m_printTimings);
+    m_rhr->setSkipUnchangedTiles(m_skipUnchanged);
+    m_rhr->setTargetFrameRate(m_targetFps);
+    m_rhr->setAdaptiveQuality(m_adaptQuality);
 
     return true;
 }
@@ -231,6 +247,22 @@ bool RhrController::handleParam(const vistle::Parameter *p)
         m_dumpImages = m_dumpImagesParam->getValue() != 0;
         if (m_rhr)
             m_rhr->setDumpImages(m_dumpImages);
+    } else if (p == m_printTimingsParam) {
+        m_printTimings = m_printTimingsParam->getValue() != 0;
+        if (m_rhr)
+            m_rhr->setPrintTimings(m_printTimings);
+    } else if (p == m_skipUnchangedParam) {
+        m_skipUnchanged = m_skipUnchangedParam->getValue() != 0;
+        if (m_rhr)
+            m_rhr->setSkipUnchangedTiles(m_skipUnchanged);
+    } else if (p == m_adaptQualityParam) {
+        m_adaptQuality = m_adaptQualityParam->getValue() != 0;
+        if (m_rhr)
+            m_rhr->setAdaptiveQuality(m_adaptQuality);
+    } else if (p == m_targetFpsParam) {
+        m_targetFps = m_targetFpsParam->getValue();
+        if (m_rhr)
+            m_rhr->setTargetFrameRate(m_targetFps);
     }
 
     return false;
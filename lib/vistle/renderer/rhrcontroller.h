@@ -80,6 +80,17 @@ private:
     IntParameter *m_dumpImagesParam = nullptr;
     bool m_dumpImages = false;
 
+    IntParameter *m_printTimingsParam = nullptr;
+    bool m_printTimings = false;
+
+    IntParameter *m_skipUnchangedParam = nullptr;
+    bool m_skipUnchanged = false;
+
+    IntParameter *m_adaptQualityParam = nullptr;
+    bool m_adaptQuality = false;
+    FloatParameter *m_targetFpsParam = nullptr;
+    Float m_targetFps = 20.;
+
     std::shared_ptr<RhrServer> m_rhr;
 };
 
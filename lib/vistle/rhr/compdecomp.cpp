@@ -177,7 +177,8 @@ buffer compressRgba(const unsigned char *rgba, int x, int y, int w, int h, int s
 #endif
         int ret = tjCompress(tjc->handle, const_cast<unsigned char *>(col), w, stride * bpp, h, bpp,
                              reinterpret_cast<unsigned char *>(jpegbuf.data()), &sz,
-                             param.rgbaCodec == vistle::CompressionParameters::Jpeg_YUV411, 90, TJ_BGR);
+                             param.rgbaCodec == vistle::CompressionParameters::Jpeg_YUV411, param.rgbaQuality,
+                             TJ_BGR);
         jpegbuf.resize(sz);
         locker.lock();
         tjCompContexts.push_back(tjc);
@@ -27,6 +27,7 @@ struct CompressionParameters {
 
     struct RgbaCompressionParameters {
         ColorCodec rgbaCodec = Raw;
+        int rgbaQuality = 90; //!< JPEG quality, 1-100
         message::CompressionMode rgbaCompress = message::CompressionNone;
     };
 
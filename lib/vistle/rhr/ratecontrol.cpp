@@ -0,0 +1,289 @@
+#include "ratecontrol.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vistle {
+
+namespace {
+
+const double Headroom = 0.8; // fraction of frame budget to be used for transfer
+const double Smoothing = 0.25; // weight of new samples
+const int UpgradeDelay = 5; // frames to wait before trying next better level
+const double MaxGrowth = 2.; // limit for ratio of a throughput sample to current estimate
+const size_t MinThroughputSample = 64 * 1024; // smaller frames do not allow for reliable throughput estimates
+const size_t MaxSentFrames = 64;
+
+double smooth(double avg, double sample)
+{
+    if (avg <= 0.)
+        return sample;
+    return (1. - Smoothing) * avg + Smoothing * sample;
+}
+
+// rough guess for relative frame sizes, until levels have been observed
+double nominalBytesPerPixel(const RateController::Quality &q)
+{
+    double color = 4.;
+    switch (q.colorCodec) {
+    case CompressionParameters::Raw:
+        color = 4.;
+        break;
+    case CompressionParameters::PredictRGB:
+        color = 1.5;
+        break;
+    case CompressionParameters::PredictRGBA:
+        color = 2.;
+        break;
+    case CompressionParameters::Jpeg_YUV444:
+        color = 0.6 * q.jpegQuality / 90.;
+        break;
+    case CompressionParameters::Jpeg_YUV411:
+        color = 0.4 * q.jpegQuality / 90.;
+        break;
+    }
+
+    double depth = 4.;
+    switch (q.depthCodec) {
+    case CompressionParameters::DepthRaw:
+        depth = 3.;
+        break;
+    case CompressionParameters::DepthPredict:
+    case CompressionParameters::DepthPredictPlanar:
+        depth = 2.;
+        break;
+    case CompressionParameters::DepthQuant:
+    case CompressionParameters::DepthQuantPlanar:
+        depth = q.depthPrecision <= 16 ? 0.5 : 0.75;
+        break;
+    case CompressionParameters::DepthZfp:
+        depth = q.zfpMode == CompressionParameters::ZfpFixedRate ? 0.75 : 1.5;
+        break;
+    }
+
+    return (color + depth) * q.resolution * q.resolution;
+}
+
+} // namespace
+
+bool RateController::Quality::operator==(const Quality &other) const
+{
+    return colorCodec == other.colorCodec && jpegQuality == other.jpegQuality && depthCodec == other.depthCodec &&
+           depthPrecision == other.depthPrecision && zfpMode == other.zfpMode && resolution == other.resolution;
+}
+
+RateController::RateController()
+{
+    buildLevels();
+}
+
+void RateController::setEnabled(bool enable)
+{
+    m_enabled = enable;
+    decide();
+}
+
+bool RateController::enabled() const
+{
+    return m_enabled;
+}
+
+void RateController::setTargetFrameRate(double fps)
+{
+    m_targetFps = std::max(1., fps);
+}
+
+double RateController::targetFrameRate() const
+{
+    return m_targetFps;
+}
+
+void RateController::setFullQuality(const Quality &quality)
+{
+    if (quality == m_full)
+        return;
+    m_full = quality;
+    buildLevels();
+    m_level = std::min(m_level, numLevels() - 1);
+}
+
+void RateController::buildLevels()
+{
+    m_levels.clear();
+    m_levels.push_back(m_full);
+
+    auto add = [this](const Quality &q) {
+        if (q != m_levels.back())
+            m_levels.push_back(q);
+    };
+
+    Quality q = m_full;
+    bool jpeg = q.colorCodec == CompressionParameters::Jpeg_YUV411 || q.colorCodec == CompressionParameters::Jpeg_YUV444;
+    if (!jpeg)
+        q.colorCodec = CompressionParameters::Jpeg_YUV444;
+    q.jpegQuality = std::min(q.jpegQuality, 85);
+    if (q.depthCodec == CompressionParameters::DepthZfp) {
+        q.zfpMode = CompressionParameters::ZfpFixedRate;
+    } else if (q.depthCodec != CompressionParameters::DepthQuantPlanar) {
+        q.depthCodec = CompressionParameters::DepthQuant;
+    }
+    add(q);
+
+    q.colorCodec = CompressionParameters::Jpeg_YUV411;
+    q.jpegQuality = std::min(q.jpegQuality, 70);
+    add(q);
+
+    q.jpegQuality = std::min(q.jpegQuality, 60);
+    q.resolution = 0.7;
+    add(q);
+
+    q.jpegQuality = std::min(q.jpegQuality, 50);
+    q.resolution = 0.5;
+    add(q);
+
+    m_bytesPerFrame.assign(m_levels.size(), 0.);
+}
+
+void RateController::frameSent(unsigned frame, size_t bytes, double firstSend, double lastSend)
+{
+    SentFrame f;
+    f.frame = frame;
+    f.bytes = bytes;
+    f.firstSend = firstSend;
+    f.lastSend = lastSend;
+    f.level = m_level;
+    m_sent.push_back(f);
+    while (m_sent.size() > MaxSentFrames)
+        m_sent.pop_front();
+
+    m_bytesPerFrame[m_level] = smooth(m_bytesPerFrame[m_level], bytes);
+    ++m_framesSinceChange;
+}
+
+void RateController::frameAcknowledged(unsigned frame, double now, double receiveTime)
+{
+    while (!m_sent.empty() && m_sent.front().frame < frame)
+        m_sent.pop_front();
+    if (m_sent.empty() || m_sent.front().frame != frame)
+        return;
+
+    const SentFrame f = m_sent.front();
+    m_sent.pop_front();
+
+    const double rtt = std::max(0., now - f.lastSend);
+    m_minRtt = m_minRtt > 0. ? std::min(m_minRtt, rtt) : rtt;
+    m_rtt = smooth(m_rtt, rtt);
+
+    if (f.bytes >= MinThroughputSample) {
+        // link might still have been busy with previous frame,
+        // and acknowledgements processed in bursts make intervals between them too short
+        const double start = std::max(f.firstSend + m_minRtt, m_lastAck);
+        const double duration = std::max(1e-4, std::max(now - start, receiveTime));
+        double sample = f.bytes / duration;
+        if (m_throughput > 0.)
+            sample = std::min(sample, MaxGrowth * m_throughput); // suppress outliers caused by scheduling delays
+        m_throughput = smooth(m_throughput, sample);
+    }
+    m_lastAck = now;
+
+    decide();
+}
+
+void RateController::setInteracting(bool interacting)
+{
+    m_interacting = interacting;
+    decide();
+}
+
+bool RateController::interacting() const
+{
+    return m_interacting;
+}
+
+void RateController::decide()
+{
+    int level = m_level;
+    if (!m_enabled || !m_interacting) {
+        level = 0;
+    } else if (m_throughput > 0.) {
+        const double budget = 1. / m_targetFps;
+        int best = numLevels() - 1;
+        for (int l = 0; l < numLevels(); ++l) {
+            if (predictedBytes(l) / m_throughput <= budget * Headroom) {
+                best = l;
+                break;
+            }
+        }
+        // frames queue up, although throughput estimate suggests otherwise
+        if (m_rtt > m_minRtt + budget)
+            best = std::max(best, std::min(m_level + 1, numLevels() - 1));
+
+        if (best > m_level) {
+            level = best;
+        } else if (best < m_level && m_framesSinceChange >= UpgradeDelay) {
+            level = m_level - 1;
+        }
+    }
+
+    if (level != m_level) {
+        m_level = level;
+        m_framesSinceChange = 0;
+    }
+}
+
+const RateController::Quality &RateController::quality() const
+{
+    return m_levels[m_level];
+}
+
+int RateController::level() const
+{
+    return m_level;
+}
+
+int RateController::numLevels() const
+{
+    return int(m_levels.size());
+}
+
+double RateController::throughput() const
+{
+    return m_throughput;
+}
+
+double RateController::roundTripTime() const
+{
+    return m_rtt;
+}
+
+double RateController::predictedBytes(int level) const
+{
+    if (m_bytesPerFrame[level] > 0.)
+        return m_bytesPerFrame[level];
+
+    // scale observation of closest level by nominal ratio
+    for (int d = 1; d < numLevels(); ++d) {
+        for (int l: {level - d, level + d}) {
+            if (l < 0 || l >= numLevels() || m_bytesPerFrame[l] <= 0.)
+                continue;
+            return m_bytesPerFrame[l] * nominalBytesPerPixel(m_levels[level]) / nominalBytesPerPixel(m_levels[l]);
+        }
+    }
+    return 0.;
+}
+
+std::ostream &operator<<(std::ostream &os, const RateController::Quality &q)
+{
+    os << CompressionParameters::toString(q.colorCodec);
+    if (q.colorCodec == CompressionParameters::Jpeg_YUV411 || q.colorCodec == CompressionParameters::Jpeg_YUV444)
+        os << " q" << q.jpegQuality;
+    os << ", " << CompressionParameters::toString(q.depthCodec);
+    if (q.depthCodec == CompressionParameters::DepthZfp)
+        os << " " << CompressionParameters::toString(q.zfpMode);
+    else if (q.depthCodec == CompressionParameters::DepthQuant || q.depthCodec == CompressionParameters::DepthQuantPlanar)
+        os << " " << q.depthPrecision << " bit";
+    os << ", resolution " << std::lround(q.resolution * 100.) << "%";
+    return os;
+}
+
+} // namespace vistle
@@ -0,0 +1,93 @@
+/**\file
+ * \brief adapt image quality of remote hybrid rendering to available bandwidth
+ *
+ * \copyright LGPL2+
+ */
+
+#ifndef RHR_RATECONTROL_H
+#define RHR_RATECONTROL_H
+
+#include <deque>
+#include <ostream>
+#include <vector>
+
+#include "export.h"
+#include "compdecomp.h"
+
+namespace vistle {
+
+//! choose codecs and render resolution, so that a target frame rate can be kept during interaction
+/*! Throughput and round-trip time are estimated from frame acknowledgements sent by the client.
+ *  While the view changes, the best quality level whose predicted transfer time fits into the frame budget is used.
+ *  Quality is decreased immediately when the budget is exceeded, but only increased one level at a time.
+ *  As soon as the view is still, full quality is restored. */
+class V_RHREXPORT RateController {
+public:
+    struct Quality {
+        CompressionParameters::ColorCodec colorCodec = CompressionParameters::Raw;
+        int jpegQuality = 90;
+        CompressionParameters::DepthCodec depthCodec = CompressionParameters::DepthRaw;
+        int depthPrecision = 24;
+        CompressionParameters::ZfpMode zfpMode = CompressionParameters::ZfpFixedRate;
+        double resolution = 1.; //!< fraction of requested width and height to render
+
+        bool operator==(const Quality &other) const;
+        bool operator!=(const Quality &other) const { return !(*this == other); }
+    };
+
+    RateController();
+
+    void setEnabled(bool enable);
+    bool enabled() const;
+    void setTargetFrameRate(double fps);
+    double targetFrameRate() const;
+    //! quality to use while the view is still, degraded levels are derived from it
+    void setFullQuality(const Quality &quality);
+
+    //! all tiles of frame have been handed to the network
+    void frameSent(unsigned frame, size_t bytes, double firstSend, double lastSend);
+    //! client received all tiles of frame, receiveTime is the time between reception of first and last tile
+    void frameAcknowledged(unsigned frame, double now, double receiveTime = 0.);
+    //! whether view is currently being changed by the user
+    void setInteracting(bool interacting);
+    bool interacting() const;
+
+    //! quality to be used for next frame
+    const Quality &quality() const;
+    int level() const;
+    int numLevels() const;
+
+    //! estimated throughput in bytes/s, 0 if not yet known
+    double throughput() const;
+    //! smoothed round-trip time in s, 0 if not yet known
+    double roundTripTime() const;
+    //! predicted bytes per frame at quality level
+    double predictedBytes(int level) const;
+
+private:
+    struct SentFrame {
+        unsigned frame = 0;
+        size_t bytes = 0;
+        double firstSend = 0., lastSend = 0.;
+        int level = 0;
+    };
+
+    void buildLevels();
+    void decide();
+
+    bool m_enabled = false;
+    bool m_interacting = false;
+    double m_targetFps = 20.;
+    Quality m_full;
+    std::vector<Quality> m_levels;
+    std::vector<double> m_bytesPerFrame; //!< smoothed observation for each level, 0 if not observed
+    int m_level = 0;
+    int m_framesSinceChange = 0;
+    std::deque<SentFrame> m_sent;
+    double m_throughput = 0., m_rtt = 0., m_minRtt = 0., m_lastAck = 0.;
+};
+
+V_RHREXPORT std::ostream &operator<<(std::ostream &os, const RateController::Quality &q);
+
+} // namespace vistle
+#endif
@@ -25,6 +25,9 @@ vistle::message::RemoteRenderMessage::RemoteRenderMessage(const vistle::RhrSubMe
     case rfbVariant:
         sz = sizeof(variantMsg);
         break;
+    case rfbTileAck:
+        sz = sizeof(tileAckMsg);
+        break;
     }
     memcpy(m_rhr.data(), &rhr, sz);
 }
@@ -29,6 +29,7 @@ enum {
     rfbBounds, //!< send scene bounds from server to client
     rfbAnimation, //!< current/total animation time steps
     rfbVariant, //!< control visibility of variants
+    rfbTileAck, //!< acknowledge reception of all tiles of a frame from client to server
 };
 
 //! basic RFB message header
@@ -207,6 +208,8 @@ enum rfbTileFlags {
     rfbTileFirst = 1,
     rfbTileLast = 2,
     rfbTileRequest = 4,
+    rfbTileUnchanged = 8, //!< tile is identical to same tile of previous frame, sent without payload
+    rfbTileRequestAck = 16, //!< client should acknowledge reception of frame with tileAckMsg
 };
 
 enum rfbTileFormats { rfbDepth8Bit, rfbDepth16Bit, rfbDepth24Bit, rfbDepth32Bit, rfbDepthFloat, rfbColorRGBA };
@@ -299,6 +302,17 @@ struct V_RHREXPORT variantMsg: public rfbMsg {
 };
 static_assert(sizeof(variantMsg) < RhrMessageSize, "RHR message too large");
 
+//! client received last tile of a frame, for estimating throughput and round-trip time
+struct V_RHREXPORT tileAckMsg: public rfbMsg {
+    tileAckMsg(): rfbMsg(rfbTileAck), frameNumber(0), tiles(0), bytes(0), receiveTime(0.) {}
+
+    uint32_t frameNumber; //!< frame number copied from last tile
+    uint32_t tiles; //!< number of tiles received for this frame
+    uint64_t bytes; //!< payload bytes received for this frame
+    double receiveTime; //!< seconds between reception of first and last tile
+};
+static_assert(sizeof(tileAckMsg) < RhrMessageSize, "RHR message too large");
+
 //! header for remote hybrid rendering message
 typedef rfbMsg RhrSubMessage;
 
@@ -0,0 +1,336 @@
+// validate bandwidth-adaptive quality control of remote hybrid rendering:
+// stream synthetic frames through an emulated link with limited bandwidth and latency,
+// first while the view changes, then while it is still
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "compdecomp.h"
+#include "ratecontrol.h"
+#include <vistle/util/stopwatch.h>
+
+using namespace vistle;
+
+namespace {
+
+const int Width = 1280, Height = 720;
+const int TileSize = 256;
+
+struct Tile {
+    unsigned frame = 0;
+    bool depth = false;
+    bool last = false;
+    int x = 0, y = 0, w = 0, h = 0;
+    int width = 0, height = 0; //!< of whole frame
+    CompressionParameters param;
+    buffer payload;
+    double deliverAt = 0.;
+};
+
+struct Ack {
+    unsigned frame = 0;
+    double receiveTime = 0.; //!< between reception of first and last tile
+    double deliverAt = 0.;
+};
+
+// serializes data at a fixed rate, with a bounded send buffer blocking the sender like a TCP socket
+class Link {
+public:
+    Link(double bytesPerSecond, double latency, size_t sendBuffer)
+    : m_rate(bytesPerSecond), m_latency(latency), m_bufferTime(sendBuffer / bytesPerSecond)
+    {}
+
+    void send(Tile tile)
+    {
+        const double now = Clock::time();
+        const double start = std::max(now, m_busyUntil);
+        m_busyUntil = start + tile.payload.size() / m_rate;
+        tile.deliverAt = m_busyUntil + m_latency;
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            m_tiles.emplace_back(std::move(tile));
+        }
+        m_cond.notify_one();
+
+        const double wait = m_busyUntil - m_bufferTime - Clock::time();
+        if (wait > 0.)
+            std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+    }
+
+    bool receive(Tile &tile)
+    {
+        std::unique_lock<std::mutex> locker(m_mutex);
+        m_cond.wait(locker, [this]() { return m_closed || !m_tiles.empty(); });
+        if (m_tiles.empty())
+            return false;
+        tile = std::move(m_tiles.front());
+        m_tiles.pop_front();
+        locker.unlock();
+
+        const double wait = tile.deliverAt - Clock::time();
+        if (wait > 0.)
+            std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+        return true;
+    }
+
+    void acknowledge(unsigned frame, double receiveTime)
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        Ack ack;
+        ack.frame = frame;
+        ack.receiveTime = receiveTime;
+        ack.deliverAt = Clock::time() + m_latency;
+        m_acks.push_back(ack);
+    }
+
+    //! non-blocking
+    bool receiveAck(Ack &ack)
+    {
+        std::lock_guard<std::mutex> locker(m_mutex);
+        if (m_acks.empty() || m_acks.front().deliverAt > Clock::time())
+            return false;
+        ack = m_acks.front();
+        m_acks.pop_front();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_mutex);
+            m_closed = true;
+        }
+        m_cond.notify_one();
+    }
+
+private:
+    const double m_rate, m_latency, m_bufferTime;
+    double m_busyUntil = 0.;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Tile> m_tiles;
+    std::deque<Ack> m_acks;
+    bool m_closed = false;
+};
+
+// smooth background with a sphere moving with the view
+void render(std::vector<unsigned char> &rgba, std::vector<float> &depth, int w, int h, double angle)
+{
+    rgba.resize(size_t(w) * h * 4);
+    depth.resize(size_t(w) * h);
+    const double cx = 0.5 + 0.3 * std::cos(angle), cy = 0.5 + 0.3 * std::sin(angle);
+    const double r = 0.2;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const size_t idx = size_t(y) * w + x;
+            const double u = double(x) / w, v = double(y) / h;
+            const double dx = (u - cx) * w / h, dy = v - cy;
+            const double d2 = (dx * dx + dy * dy) / (r * r);
+            unsigned char *p = &rgba[idx * 4];
+            if (d2 < 1.) {
+                const double shade = std::sqrt(1. - d2);
+                p[0] = (unsigned char)(255 * shade);
+                p[1] = (unsigned char)(128 * shade + 64 * std::sin(40. * u));
+                p[2] = (unsigned char)(64 * shade);
+                depth[idx] = float(0.5 - 0.1 * shade);
+            } else {
+                p[0] = (unsigned char)(64 + 32 * v);
+                p[1] = (unsigned char)(64 + 32 * u);
+                p[2] = (unsigned char)(96 + ((x / 16 + y / 16) % 2) * 16);
+                depth[idx] = 1.f;
+            }
+            p[3] = 255;
+        }
+    }
+}
+
+struct ClientStats {
+    std::mutex mutex;
+    size_t frames = 0; //!< completely received
+    size_t errors = 0;
+};
+
+void client(Link &link, ClientStats &stats)
+{
+    std::vector<char> rgba, depth;
+    Tile tile;
+    unsigned frame = ~0u;
+    double first = 0.;
+    while (link.receive(tile)) {
+        if (tile.frame != frame) {
+            frame = tile.frame;
+            first = Clock::time();
+        }
+        auto &dest = tile.depth ? depth : rgba;
+        dest.resize(size_t(tile.width) * tile.height * 4);
+        bool ok = decompressTile(dest.data(), tile.payload, tile.param, tile.x, tile.y, tile.w, tile.h, tile.width);
+        if (tile.last)
+            link.acknowledge(tile.frame, Clock::time() - first);
+
+        std::lock_guard<std::mutex> locker(stats.mutex);
+        if (!ok)
+            ++stats.errors;
+        if (tile.last)
+            ++stats.frames;
+    }
+}
+
+size_t sendFrame(Link &link, unsigned frame, const RateController::Quality &q, double angle,
+                 std::vector<unsigned char> &rgba, std::vector<float> &depth)
+{
+    const int w = std::max(1, int(std::lround(Width * q.resolution)));
+    const int h = std::max(1, int(std::lround(Height * q.resolution)));
+    render(rgba, depth, w, h, angle);
+
+    RgbaCompressionParameters rp;
+    rp.rgbaCodec = q.colorCodec;
+    rp.rgbaQuality = q.jpegQuality;
+    DepthCompressionParameters dp;
+    dp.depthCodec = q.depthCodec;
+    dp.depthPrecision = q.depthPrecision;
+    dp.depthZfpMode = q.zfpMode;
+
+    size_t bytes = 0;
+    for (int depthPass = 0; depthPass < 2; ++depthPass) {
+        for (int y = 0; y < h; y += TileSize) {
+            for (int x = 0; x < w; x += TileSize) {
+                Tile tile;
+                tile.frame = frame;
+                tile.depth = depthPass;
+                tile.x = x;
+                tile.y = y;
+                tile.w = std::min(TileSize, w - x);
+                tile.h = std::min(TileSize, h - y);
+                tile.width = w;
+                tile.height = h;
+                tile.last = depthPass && x + TileSize >= w && y + TileSize >= h;
+                if (depthPass) {
+                    auto p = dp;
+                    tile.payload = compressDepth(depth.data(), x, y, tile.w, tile.h, w, p);
+                    tile.param = CompressionParameters(p);
+                } else {
+                    auto p = rp;
+                    tile.payload = compressRgba(rgba.data(), x, y, tile.w, tile.h, w, p);
+                    tile.param = CompressionParameters(p);
+                }
+                bytes += tile.payload.size();
+                link.send(std::move(tile));
+            }
+        }
+    }
+    return bytes;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    double mbits = 100.;
+    if (argc > 1)
+        mbits = atof(argv[1]);
+    double latency = 0.01;
+    if (argc > 2)
+        latency = atof(argv[2]) / 1000.;
+    double fps = 20.;
+    if (argc > 3)
+        fps = atof(argv[3]);
+    const double interaction = 6., still = 2.;
+    const double maxRenderRate = 60.;
+
+    std::cout << "link: " << mbits << " Mbit/s, latency " << latency * 1000. << " ms, target " << fps << " fps, "
+              << Width << "x" << Height << std::endl;
+
+    RateController::Quality full;
+    full.colorCodec = CompressionParameters::PredictRGB;
+    full.depthCodec = CompressionParameters::DepthPredict;
+    RateController rc;
+    rc.setFullQuality(full);
+    rc.setTargetFrameRate(fps);
+    rc.setEnabled(true);
+
+    Link link(mbits * 1e6 / 8., latency, 256 * 1024);
+    ClientStats stats;
+    std::thread clientThread(client, std::ref(link), std::ref(stats));
+
+    std::vector<unsigned char> rgba;
+    std::vector<float> depth;
+    const double start = Clock::time();
+    double lastReport = start, lastFrame = 0.;
+    size_t framesReported = 0, bytes = 0;
+    int maxLevel = 0, refinedLevel = -1;
+    unsigned frame = 0;
+    double angle = 0.;
+    for (;;) {
+        const double now = Clock::time();
+        const double t = now - start;
+        if (t > interaction + still)
+            break;
+
+        Ack ack;
+        while (link.receiveAck(ack))
+            rc.frameAcknowledged(ack.frame, Clock::time(), ack.receiveTime);
+
+        const bool interacting = t < interaction;
+        rc.setInteracting(interacting);
+        if (interacting) {
+            maxLevel = std::max(maxLevel, rc.level());
+            angle = t;
+        }
+
+        if (now - lastReport >= 0.5) {
+            size_t frames = 0;
+            {
+                std::lock_guard<std::mutex> locker(stats.mutex);
+                frames = stats.frames;
+            }
+            std::cout << std::fixed << std::setprecision(1) << std::setw(5) << t << " s "
+                      << (interacting ? "moving" : "still ") << ": level " << rc.level() << " (" << rc.quality()
+                      << "), " << std::setw(5) << (frames - framesReported) / (now - lastReport) << " fps, "
+                      << std::setw(6) << rc.throughput() * 8e-6 << " Mbit/s, rtt " << std::setw(5)
+                      << rc.roundTripTime() * 1000. << " ms, " << bytes / 1024 << " KiB/frame" << std::endl;
+            framesReported = frames;
+            lastReport = now;
+        }
+
+        // like a renderer: new frames while the view changes, then a single refined frame
+        if (!interacting && refinedLevel >= 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        if (now - lastFrame < 1. / maxRenderRate) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(1. / maxRenderRate - (now - lastFrame)));
+            continue;
+        }
+        lastFrame = now;
+
+        const double firstSend = Clock::time();
+        bytes = sendFrame(link, frame, rc.quality(), angle, rgba, depth);
+        rc.frameSent(frame, bytes, firstSend, Clock::time());
+        ++frame;
+        if (!interacting)
+            refinedLevel = rc.level();
+    }
+
+    link.close();
+    clientThread.join();
+
+    std::cout << "worst level during interaction: " << maxLevel << ", level of refined frame: " << refinedLevel
+              << ", " << stats.errors << " decoding errors" << std::endl;
+
+    if (refinedLevel != 0) {
+        std::cerr << "did not refine to full quality when view was still" << std::endl;
+        return 1;
+    }
+    if (stats.errors > 0) {
+        return 1;
+    }
+    return 0;
+}
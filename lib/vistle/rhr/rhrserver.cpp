@@ -10,6 +10,7 @@
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <thread>
 
 #include "rfbext.h"
@@ -78,12 +79,8 @@ RhrServer::RhrServer(vistle::Module *module)
 // this is called if the plugin is removed at runtime
 RhrServer::~RhrServer()
 {
-    while (m_queuedTiles > 0) {
-        usleep(10000);
-        std::lock_guard<std::mutex> locker(m_taskMutex);
-        m_queuedTiles -= m_finishedTasks.size();
-        m_finishedTasks.clear();
-    }
+    finishTiles(RhrServer::ViewParameters(), true /* finish */, false /* send */);
+    stopEncoders();
     m_clientSocket.reset();
 
     //fprintf(stderr,"RhrServer::~RhrServer\n");
@@ -112,32 +109,128 @@ bool RhrServer::isConnected() const
 
 void RhrServer::setColorCodec(CompressionParameters::ColorCodec value)
 {
-    m_imageParam.rgbaParam.rgbaCodec = value;
+    m_fullImageParam.rgbaParam.rgbaCodec = value;
+    updateImageParameters();
 }
 
 void RhrServer::setDepthCodec(CompressionParameters::DepthCodec value)
 {
-    m_imageParam.depthParam.depthCodec = value;
+    m_fullImageParam.depthParam.depthCodec = value;
+    updateImageParameters();
 }
 
 void RhrServer::setColorCompression(message::CompressionMode mode)
 {
-    m_imageParam.rgbaParam.rgbaCompress = mode;
+    m_fullImageParam.rgbaParam.rgbaCompress = mode;
+    updateImageParameters();
 }
 
 void RhrServer::setDepthCompression(message::CompressionMode mode)
 {
-    m_imageParam.depthParam.depthCompress = mode;
+    m_fullImageParam.depthParam.depthCompress = mode;
+    updateImageParameters();
 }
 
 void RhrServer::setDepthPrecision(int bits)
 {
-    m_imageParam.depthParam.depthPrecision = bits;
+    m_fullImageParam.depthParam.depthPrecision = bits;
+    updateImageParameters();
 }
 
 void RhrServer::setZfpMode(CompressionParameters::ZfpMode mode)
 {
-    m_imageParam.depthParam.depthZfpMode = mode;
+    m_fullImageParam.depthParam.depthZfpMode = mode;
+    updateImageParameters();
+}
+
+void RhrServer::setAdaptiveQuality(bool enable)
+{
+    m_rateControl.setEnabled(enable);
+    updateImageParameters();
+}
+
+void RhrServer::setTargetFrameRate(double fps)
+{
+    m_rateControl.setTargetFrameRate(fps);
+}
+
+const RateController &RhrServer::rateController() const
+{
+    return m_rateControl;
+}
+
+bool RhrServer::updateImageParameters()
+{
+    const auto &full = m_fullImageParam;
+    RateController::Quality fq;
+    fq.colorCodec = full.rgbaParam.rgbaCodec;
+    fq.jpegQuality = full.rgbaParam.rgbaQuality;
+    fq.depthCodec = full.depthParam.depthCodec;
+    fq.depthPrecision = full.depthParam.depthPrecision;
+    fq.zfpMode = full.depthParam.depthZfpMode;
+    m_rateControl.setFullQuality(fq);
+
+    const auto &q = m_rateControl.quality();
+    auto rgba = full.rgbaParam;
+    rgba.rgbaCodec = q.colorCodec;
+    rgba.rgbaQuality = q.jpegQuality;
+    auto depth = full.depthParam;
+    depth.depthCodec = q.depthCodec;
+    depth.depthPrecision = q.depthPrecision;
+    depth.depthZfpMode = q.zfpMode;
+
+    auto &cur = m_imageParam;
+    bool changed = rgba.rgbaCodec != cur.rgbaParam.rgbaCodec || rgba.rgbaQuality != cur.rgbaParam.rgbaQuality ||
+                   depth.depthCodec != cur.depthParam.depthCodec ||
+                   depth.depthPrecision != cur.depthParam.depthPrecision ||
+                   depth.depthZfpMode != cur.depthParam.depthZfpMode || depth.depthFloat != cur.depthParam.depthFloat;
+    cur.rgbaParam = rgba;
+    cur.depthParam = depth;
+
+    if (q.resolution != m_resolution) {
+        m_resolution = q.resolution;
+        for (size_t i = 0; i < numViews(); ++i) {
+            auto &vd = m_viewData[i];
+            resize(i, scaled(vd.requestedWidth), scaled(vd.requestedHeight));
+            if (!m_resizeBlocked) {
+                vd.param.width = vd.nparam.width;
+                vd.param.height = vd.nparam.height;
+            }
+        }
+        changed = true;
+    }
+
+    if (changed) {
+        // lossy encoding of client copy does not match anymore
+        invalidatePreviousFrames();
+        if (m_rateControl.enabled()) {
+            CERR << "quality level " << m_rateControl.level() << ": " << q << ", throughput "
+                 << m_rateControl.throughput() / (1024 * 1024) << " MiB/s, rtt " << m_rateControl.roundTripTime() * 1e3
+                 << " ms" << std::endl;
+        }
+    }
+
+    return changed;
+}
+
+int RhrServer::scaled(int size) const
+{
+    if (size <= 0 || m_resolution >= 1.)
+        return size;
+    return std::max(1, int(std::lround(size * m_resolution)));
+}
+
+void RhrServer::setSkipUnchangedTiles(bool enable)
+{
+    if (enable != m_skipUnchanged)
+        invalidatePreviousFrames();
+    m_skipUnchanged = enable;
+}
+
+void RhrServer::invalidatePreviousFrames()
+{
+    for (auto &vd: m_viewData)
+        vd.prevValid = false;
 }
 
 void RhrServer::setDumpImages(bool enable)
@@ -145,6 +238,21 @@ void RhrServer::setDumpImages(bool enable)
     m_dumpImages = enable;
 }
 
+void RhrServer::setPrintTimings(bool enable)
+{
+    m_printTimings = enable;
+}
+
+const RhrServer::FrameTimings &RhrServer::frameTimings() const
+{
+    return m_lastTimings;
+}
+
+void RhrServer::addReadbackTime(double seconds)
+{
+    m_timings.readback += seconds;
+}
+
 void RhrServer::setClientModuleId(int moduleId)
 {
     m_clientModuleId = moduleId;
@@ -293,13 +401,13 @@ void RhrServer::init()
    m_compressionrate = false;
 #endif
 
-    m_imageParam.rgbaParam.rgbaCompress = message::CompressionNone;
-    m_imageParam.depthParam.depthPrecision = 32;
-    m_imageParam.depthParam.depthCodec = CompressionParameters::DepthRaw;
-    ;
-    m_imageParam.depthParam.depthCompress = message::CompressionLz4;
-    m_imageParam.depthParam.depthFloat = true;
-    m_imageParam.depthParam.depthZfpMode = CompressionParameters::ZfpFixedRate;
+    m_fullImageParam.rgbaParam.rgbaCompress = message::CompressionNone;
+    m_fullImageParam.depthParam.depthPrecision = 32;
+    m_fullImageParam.depthParam.depthCodec = CompressionParameters::DepthRaw;
+    m_fullImageParam.depthParam.depthCompress = message::CompressionLz4;
+    m_fullImageParam.depthParam.depthFloat = true;
+    m_fullImageParam.depthParam.depthZfpMode = CompressionParameters::ZfpFixedRate;
+    updateImageParameters();
 
     m_resizeBlocked = false;
     m_queuedTiles = 0;
@@ -312,6 +420,8 @@ void RhrServer::resetClient()
 {
     finishTiles(RhrServer::ViewParameters(), true /* finish */, false /* send */);
 
+    invalidatePreviousFrames();
+
     ++m_updateCount;
     ++lightsUpdateCount;
     if (m_clientSocket)
@@ -481,6 +591,7 @@ void RhrServer::resize(size_t viewNum, int w, int h)
 
         vd.rgba.resize(w * h * 4);
         vd.depth.resize(w * h);
+        vd.prevValid = false;
     }
 }
 
@@ -505,9 +616,21 @@ bool RhrServer::handleMatrices(std::shared_ptr<socket> sock, const matricesMsg &
         m_viewData.resize(viewNum + 1);
     }
 
-    resize(viewNum, mat.width, mat.height);
-
     ViewData &vd = m_viewData[viewNum];
+    vd.requestedWidth = mat.width;
+    vd.requestedHeight = mat.height;
+    resize(viewNum, scaled(mat.width), scaled(mat.height));
+
+    bool moved = vd.nparam.eye != mat.eye;
+    for (int i = 0; i < 16; ++i) {
+        if (vd.nparam.head.data()[i] != mat.head[i] || vd.nparam.proj.data()[i] != mat.proj[i] ||
+            vd.nparam.view.data()[i] != mat.view[i] || vd.nparam.model.data()[i] != mat.model[i]) {
+            moved = true;
+            break;
+        }
+    }
+    if (moved)
+        m_lastViewChange = Clock::time();
 
     vd.nparam.timestep = timestep();
     vd.nparam.matrixTime = mat.time;
@@ -652,9 +775,33 @@ bool RhrServer::handleVariant(std::shared_ptr<RhrServer::socket> sock, const var
     return true;
 }
 
+bool RhrServer::handleTileAck(std::shared_ptr<RhrServer::socket> sock, const tileAckMsg &ack)
+{
+    m_rateControl.frameAcknowledged(ack.frameNumber, Clock::time(), ack.receiveTime);
+    updateImageParameters();
+    return true;
+}
+
+void RhrServer::updateInteraction()
+{
+    if (!m_rateControl.enabled())
+        return;
+
+    bool interacting = Clock::time() - m_lastViewChange < StillDelay;
+    if (interacting == m_rateControl.interacting())
+        return;
+    m_rateControl.setInteracting(interacting);
+    if (updateImageParameters() && !interacting) {
+        // render again for refining to full quality
+        ++m_updateCount;
+    }
+}
+
 //! this is called before every frame, used for polling for RFB messages
 void RhrServer::preFrame()
 {
+    updateInteraction();
+
     if (m_clientModuleId != vistle::message::Id::Invalid)
         return;
 
@@ -795,12 +942,16 @@ struct EncodeTask {
     float *depth = nullptr;
     unsigned char *rgba = nullptr;
     tileMsg *message = nullptr;
-    const RhrServer::ImageParameters &param;
+    const RhrServer::ImageParameters param;
     int viewNum;
     int x, y, w, h, stride;
     int bpp;
     bool subsamp;
     RhrServer::EncodeResult result;
+    double duration = 0.; //!< time spent in work()
+    EncodeTask *nextFinished = nullptr;
+    char *prev = nullptr; //!< copy of image data last sent, updated for this tile
+    bool compare = false; //!< whether prev holds valid data to compare to
 
     EncodeTask() = delete;
     EncodeTask(const EncodeTask &other) = delete;
@@ -888,10 +1039,34 @@ struct EncodeTask {
         }
     }
 
+    //! update copy of last sent frame and check whether tile did change
+    bool unchanged()
+    {
+        const size_t pixsize = depth ? sizeof(*depth) : bpp;
+        const char *cur = depth ? reinterpret_cast<const char *>(depth) : reinterpret_cast<const char *>(rgba);
+        const size_t linesize = pixsize * w;
+        bool same = compare;
+        for (int yy = y; yy < y + h; ++yy) {
+            const size_t off = (size_t(yy) * stride + x) * pixsize;
+            if (same && memcmp(cur + off, prev + off, linesize) == 0)
+                continue;
+            same = false;
+            memcpy(prev + off, cur + off, linesize);
+        }
+        return same;
+    }
+
     RhrServer::EncodeResult work()
     {
         auto &msg = *message;
         RhrServer::EncodeResult result(message);
+        if (prev && unchanged()) {
+            msg.flags |= rfbTileUnchanged;
+            msg.unzippedsize = msg.size = 0;
+            result.rhrMessage = std::make_unique<RemoteRenderMessage>(msg, 0);
+            return result;
+        }
+
         message::CompressionMode compress = message::CompressionNone;
         if (depth) {
             compress = param.depthParam.depthCompress;
@@ -924,6 +1099,7 @@ void RhrServer::encodeAndSend(int viewNum, int x0, int y0, int w, int h, const R
     //std::cerr << "encodeAndSend: view=" << viewNum << ", c=" << (void *)rgba(viewNum) << ", d=" << depth(viewNum) << std::endl;
     if (!m_resizeBlocked) {
         m_firstTile = true;
+        m_frameStart = Clock::time();
     }
     m_resizeBlocked = true;
 
@@ -959,100 +1135,150 @@ void RhrServer::encodeAndSend(int viewNum, int x0, int y0, int w, int h, const R
     const int tileWidth = m_tileWidth, tileHeight = m_tileHeight;
 
     if (viewNum >= 0) {
+        // tiles equal to those of the previous frame are only referenced, client keeps previous frame
+        char *prevDepth = nullptr, *prevRgba = nullptr;
+        bool compare = false;
+        if (m_skipUnchanged && size_t(viewNum) < m_viewData.size()) {
+            auto &vd = m_viewData[viewNum];
+            if (vd.prevDepth.size() != vd.depth.size() || vd.prevRgba.size() != vd.rgba.size()) {
+                vd.prevDepth.resize(vd.depth.size());
+                vd.prevRgba.resize(vd.rgba.size());
+                vd.prevValid = false;
+            }
+            prevDepth = reinterpret_cast<char *>(vd.prevDepth.data());
+            prevRgba = reinterpret_cast<char *>(vd.prevRgba.data());
+            compare = vd.prevValid;
+            if (x0 == 0 && y0 == 0 && w == param.width && h == param.height)
+                vd.prevValid = true;
+        }
+
+        auto batch = std::make_shared<EncodeBatch>();
         for (int y = y0; y < y0 + h; y += tileHeight) {
             for (int x = x0; x < x0 + w; x += tileWidth) {
                 // depth
-                auto dt =
-                    std::make_shared<EncodeTask>(viewNum, x, y, std::min(tileWidth, x0 + w - x),
-                                                 std::min(tileHeight, y0 + h - y), depth(viewNum), m_imageParam, param);
+                batch->tasks.emplace_back(
+                    std::make_unique<EncodeTask>(viewNum, x, y, std::min(tileWidth, x0 + w - x),
+                                                 std::min(tileHeight, y0 + h - y), depth(viewNum), m_imageParam, param));
+                batch->tasks.back()->prev = prevDepth;
+                batch->tasks.back()->compare = compare;
 
                 // color
-                auto ct =
-                    std::make_shared<EncodeTask>(viewNum, x, y, std::min(tileWidth, x0 + w - x),
-                                                 std::min(tileHeight, y0 + h - y), rgba(viewNum), m_imageParam, param);
-
-                std::unique_lock locker(m_taskMutex);
-                ++m_queuedTiles;
-                m_queuedTasks.emplace_back(dt);
-                ++m_queuedTiles;
-                m_queuedTasks.emplace_back(ct);
+                batch->tasks.emplace_back(
+                    std::make_unique<EncodeTask>(viewNum, x, y, std::min(tileWidth, x0 + w - x),
+                                                 std::min(tileHeight, y0 + h - y), rgba(viewNum), m_imageParam, param));
+                batch->tasks.back()->prev = prevRgba;
+                batch->tasks.back()->compare = compare;
+            }
+        }
+
+        if (!batch->tasks.empty()) {
+            startEncoders();
+            m_queuedTiles += batch->tasks.size();
+            m_pendingBatches.emplace_back(batch);
+            {
+                std::lock_guard<std::mutex> locker(m_batchMutex);
+                m_batches.emplace_back(batch);
             }
+            m_batchCond.notify_all();
         }
     }
 
-    joinWorkerThreads();
+    // send tiles already encoded, while remaining tiles of this view are still being worked on
+    finishTiles(param, lastView);
+}
 
-    std::unique_lock locker(m_taskMutex);
-    while (m_workers.size() < m_doneWorkers.size() + std::thread::hardware_concurrency() && !m_queuedTasks.empty()) {
-        locker.unlock();
+void RhrServer::startEncoders()
+{
+    if (!m_encoders.empty())
+        return;
 
-        auto thr = std::thread([this]() {
+    unsigned num = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < num; ++i) {
+        m_encoders.emplace_back([this]() {
             setThreadName("RHR:Encode");
-            std::unique_lock locker(m_taskMutex);
-            unsigned num = 0;
-            while (!m_queuedTasks.empty()) {
-                auto task = m_queuedTasks.front();
-                ++num;
-                m_queuedTasks.pop_front();
-                locker.unlock();
-
-                task->result = task->work();
-
-                locker.lock();
-                m_finishedTasks.emplace_back(task);
-            }
-            m_doneWorkers.emplace(std::this_thread::get_id());
-            locker.unlock();
-            CERR << "processed " << num << " tasks" << std::endl;
+            encode();
         });
-        m_workers.emplace(thr.get_id(), std::move(thr));
-
-        locker.lock();
     }
-    locker.unlock();
+}
 
-    finishTiles(param, lastView);
+void RhrServer::stopEncoders()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_batchMutex);
+        m_quitEncoders = true;
+    }
+    m_batchCond.notify_all();
+    for (auto &thr: m_encoders)
+        thr.join();
+    m_encoders.clear();
 }
 
-bool RhrServer::joinWorkerThreads()
+void RhrServer::encode()
 {
-    std::unique_lock locker(m_taskMutex);
-    for (auto id: m_doneWorkers) {
-        auto it = m_workers.find(id);
-        if (it != m_workers.end()) {
-            auto &thr = it->second;
-            thr.join();
-            m_workers.erase(it);
+    for (;;) {
+        std::shared_ptr<EncodeBatch> batch;
+        {
+            std::unique_lock<std::mutex> locker(m_batchMutex);
+            m_batchCond.wait(locker, [this]() { return m_quitEncoders || !m_batches.empty(); });
+            if (m_quitEncoders)
+                return;
+            batch = m_batches.front();
         }
+
+        for (size_t i = batch->next.fetch_add(1); i < batch->tasks.size(); i = batch->next.fetch_add(1)) {
+            auto *task = batch->tasks[i].get();
+            double start = Clock::time();
+            task->result = task->work();
+            task->duration = Clock::time() - start;
+
+            task->nextFinished = m_finishedTasks.load(std::memory_order_relaxed);
+            while (!m_finishedTasks.compare_exchange_weak(task->nextFinished, task, std::memory_order_release,
+                                                          std::memory_order_relaxed)) {
+            }
+            {
+                // sender might be about to wait
+                std::lock_guard<std::mutex> locker(m_finishMutex);
+            }
+            m_finishCond.notify_one();
+        }
+
+        std::lock_guard<std::mutex> locker(m_batchMutex);
+        if (!m_batches.empty() && m_batches.front() == batch)
+            m_batches.pop_front();
     }
-    m_doneWorkers.clear();
-    return m_workers.empty();
 }
 
 bool RhrServer::finishTiles(const RhrServer::ViewParameters &param, bool finish, bool sendTiles)
 {
-    bool tileReady = false;
-    do {
-        buffer payload;
-        tileReady = false;
-        std::unique_ptr<RemoteRenderMessage> msg;
-        if (m_queuedTiles == 0 && finish) {
-            auto *tm = newTileMsg(m_imageParam, param, -1, 0, 0, 0, 0);
-            msg = std::make_unique<RemoteRenderMessage>(*tm);
-            delete tm;
-        } else {
-            std::lock_guard<std::mutex> locker(m_taskMutex);
-            if (!m_finishedTasks.empty()) {
-                auto &task = m_finishedTasks.front();
-                auto &result = task->result;
-                msg = std::move(result.rhrMessage);
-                payload = std::move(result.payload);
-                m_finishedTasks.pop_front();
-                --m_queuedTiles;
-                tileReady = true;
-            }
+    bool lastSent = false;
+    while (m_queuedTiles > 0) {
+        EncodeTask *done = m_finishedTasks.exchange(nullptr, std::memory_order_acquire);
+        if (!done) {
+            if (!finish)
+                break;
+            std::unique_lock<std::mutex> locker(m_finishMutex);
+            m_finishCond.wait(locker, [this]() { return m_finishedTasks.load(std::memory_order_relaxed) != nullptr; });
+            continue;
         }
-        if (msg) {
+
+        // send in order of completion
+        EncodeTask *ordered = nullptr;
+        while (done) {
+            EncodeTask *next = done->nextFinished;
+            done->nextFinished = ordered;
+            ordered = done;
+            done = next;
+        }
+
+        for (EncodeTask *task = ordered; task; task = task->nextFinished) {
+            auto &result = task->result;
+            std::unique_ptr<RemoteRenderMessage> msg = std::move(result.rhrMessage);
+            buffer payload = std::move(result.payload);
+            --m_queuedTiles;
+            m_timings.encode += task->duration;
+            ++m_timings.tiles;
+            m_timings.bytes += payload.size();
+
             tileMsg &tm = static_cast<tileMsg &>(msg->rhr());
             tm.timestep = param.timestep;
             if (m_firstTile) {
@@ -1062,23 +1288,63 @@ bool RhrServer::finishTiles(const RhrServer::ViewParameters &param, bool finish,
             m_firstTile = false;
             if (m_queuedTiles == 0 && finish) {
                 tm.flags |= rfbTileLast;
+                if (m_rateControl.enabled())
+                    tm.flags |= rfbTileRequestAck;
+                lastSent = true;
                 //std::cerr << "last tile: req=" << msg.requestNumber << std::endl;
             }
             tm.frameNumber = m_framecount;
-            if (sendTiles)
-                send(*msg, &payload);
+            if (sendTiles) {
+                double start = Clock::time();
+                send(*msg, payload.empty() ? nullptr : &payload);
+                m_lastSend = Clock::time();
+                m_timings.send += m_lastSend - start;
+                if (m_firstSend == 0.)
+                    m_firstSend = start;
+            }
         }
-        if (m_queuedTiles > 0 && finish && !tileReady)
-            usleep(100);
-    } while (m_queuedTiles > 0 && (tileReady || finish));
+    }
 
-    joinWorkerThreads();
+    if (m_queuedTiles == 0)
+        m_pendingBatches.clear();
 
     if (finish) {
+        if (!lastSent) {
+            auto *tm = newTileMsg(m_imageParam, param, -1, 0, 0, 0, 0);
+            RemoteRenderMessage msg(*tm);
+            delete tm;
+            tileMsg &t = static_cast<tileMsg &>(msg.rhr());
+            t.timestep = param.timestep;
+            if (m_firstTile)
+                t.flags |= rfbTileFirst;
+            m_firstTile = false;
+            t.flags |= rfbTileLast;
+            if (m_rateControl.enabled())
+                t.flags |= rfbTileRequestAck;
+            t.frameNumber = m_framecount;
+            if (sendTiles)
+                send(msg);
+        }
+
         assert(m_queuedTiles == 0);
         m_resizeBlocked = false;
         deferredResize();
 
+        if (m_frameStart > 0.)
+            m_timings.latency = Clock::time() - m_frameStart;
+        m_frameStart = 0.;
+        if (sendTiles && m_firstSend > 0.)
+            m_rateControl.frameSent(m_framecount, m_timings.bytes, m_firstSend, m_lastSend);
+        m_firstSend = m_lastSend = 0.;
+        m_lastTimings = m_timings;
+        m_timings = FrameTimings();
+        if (m_printTimings && m_lastTimings.tiles > 0) {
+            const auto &t = m_lastTimings;
+            CERR << "frame " << m_framecount << ": " << t.tiles << " tiles, " << t.bytes / 1024 << " KiB, readback "
+                 << t.readback * 1e3 << " ms, encode " << t.encode * 1e3 << " ms (" << m_encoders.size()
+                 << " threads), send " << t.send * 1e3 << " ms, latency " << t.latency * 1e3 << " ms" << std::endl;
+        }
+
         ++m_framecount;
     }
 
@@ -1129,6 +1395,11 @@ bool RhrServer::handleRemoteRenderMessage(std::shared_ptr<socket> sock, const vi
         handleVariant(sock, var);
         break;
     }
+    case rfbTileAck: {
+        const auto &ack = static_cast<const tileAckMsg &>(rhr);
+        handleTileAck(sock, ack);
+        break;
+    }
     case rfbTile:
     default:
         CERR << "invalid RHR message subtype " << rhr.type << " received" << std::endl;
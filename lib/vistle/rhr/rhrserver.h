@@ -15,6 +15,10 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 #include <boost/asio.hpp>
 
@@ -26,6 +30,7 @@
 #include "export.h"
 #include "compdecomp.h"
 #include "rfbext.h"
+#include "ratecontrol.h"
 
 namespace vistle {
 
@@ -85,6 +90,27 @@ public:
     void setTileSize(int w, int h);
     void setZfpMode(CompressionParameters::ZfpMode mode);
     void setDumpImages(bool enable);
+    void setPrintTimings(bool enable);
+    //! only send references to tiles that did not change since the previous frame
+    void setSkipUnchangedTiles(bool enable);
+    //! reduce quality and resolution while the view changes, so that target frame rate can be kept
+    void setAdaptiveQuality(bool enable);
+    void setTargetFrameRate(double fps);
+    const RateController &rateController() const;
+
+    //! time spent on the stages of delivering a frame, in seconds
+    struct FrameTimings {
+        double readback = 0.; //!< copying rendered images into view buffers
+        double encode = 0.; //!< compressing tiles, summed over all encoder threads
+        double send = 0.; //!< handing encoded tiles to the network
+        double latency = 0.; //!< from first encoded view until last tile has been sent
+        size_t tiles = 0;
+        size_t bytes = 0;
+    };
+    //! timings of last completed frame
+    const FrameTimings &frameTimings() const;
+    //! account for time spent reading back images of the current frame
+    void addReadbackTime(double seconds);
 
     int timestep() const;
     void setNumTimesteps(unsigned num);
@@ -101,6 +127,7 @@ public:
     bool handleBounds(std::shared_ptr<socket> sock, const boundsMsg &bound);
     bool handleAnimation(std::shared_ptr<socket> sock, const animationMsg &anim);
     bool handleVariant(std::shared_ptr<socket> sock, const variantMsg &variant);
+    bool handleTileAck(std::shared_ptr<socket> sock, const tileAckMsg &ack);
 
     size_t numViews() const;
     const vistle::Matrix4 &viewMat(size_t viewNum) const;
@@ -256,8 +283,12 @@ public:
         ViewParameters param; //!< parameters for color/depth tiles
         ViewParameters nparam; //!< parameters for color/depth tiles currently being updated
         int newWidth, newHeight; //!< in case resizing was blocked while message was received
+        int requestedWidth = -1, requestedHeight = -1; //!< size requested by client, before scaling to resolution
         std::vector<unsigned char> rgba;
         std::vector<float> depth;
+        std::vector<unsigned char> prevRgba; //!< color of last frame sent, for skipping unchanged tiles
+        std::vector<float> prevDepth; //!< depth of last frame sent
+        bool prevValid = false; //!< whether client holds the same data as prevRgba/prevDepth
 
         ViewData(): newWidth(-1), newHeight(-1) {}
     };
@@ -287,6 +318,16 @@ private:
     std::vector<ViewData, Eigen::aligned_allocator<ViewData>> m_viewData;
 
     ImageParameters m_imageParam; //!< parameters for color/depth codec
+    ImageParameters m_fullImageParam; //!< codec parameters to use when view is still
+    RateController m_rateControl;
+    double m_resolution = 1.; //!< fraction of requested image size to render
+    double m_lastViewChange = 0.;
+    double m_firstSend = 0., m_lastSend = 0.; //!< for current frame
+    static constexpr double StillDelay = 0.3; //!< seconds without view change before refining to full quality
+    //! apply quality chosen by rate controller, returns true if it changed
+    bool updateImageParameters();
+    void updateInteraction();
+    int scaled(int size) const;
     bool m_resizeBlocked;
 
     vistle::Vector3 m_boundCenter;
@@ -310,12 +351,25 @@ private:
 
     friend struct EncodeTask;
 
-    std::mutex m_taskMutex;
-    typedef std::deque<std::shared_ptr<EncodeTask>> TaskQueue;
-    TaskQueue m_queuedTasks, m_finishedTasks;
-    std::map<std::thread::id, std::thread> m_workers;
-    std::set<std::thread::id> m_doneWorkers;
-    bool joinWorkerThreads();
+    //! encoding tasks for one view of a frame, claimed by encoder threads without locking
+    struct EncodeBatch {
+        std::vector<std::unique_ptr<EncodeTask>> tasks;
+        std::atomic<size_t> next{0};
+    };
+
+    std::vector<std::thread> m_encoders; //!< persistent encoder thread pool
+    std::mutex m_batchMutex; //!< protects m_batches and m_quitEncoders
+    std::condition_variable m_batchCond;
+    std::deque<std::shared_ptr<EncodeBatch>> m_batches; //!< batches with unclaimed tasks
+    bool m_quitEncoders = false;
+    void startEncoders();
+    void stopEncoders();
+    void encode();
+
+    std::deque<std::shared_ptr<EncodeBatch>> m_pendingBatches; //!< batches with tiles not yet sent
+    std::atomic<EncodeTask *> m_finishedTasks{nullptr}; //!< lock-free stack of encoded tiles, most recent first
+    std::mutex m_finishMutex; //!< only for waiting on m_finishCond
+    std::condition_variable m_finishCond;
     size_t m_queuedTiles;
     bool m_firstTile;
 
@@ -329,6 +383,11 @@ private:
     void resetClient();
     int m_framecount = 0;
     bool m_dumpImages = false;
+    bool m_printTimings = false;
+    bool m_skipUnchanged = false;
+    void invalidatePreviousFrames();
+    double m_frameStart = 0.;
+    FrameTimings m_timings, m_lastTimings;
     size_t m_modificationCount = 0;
 };
 
@@ -4,6 +4,7 @@
 #include <cstring>
 #include <cerrno>
 #include <iostream>
+#include <mutex>
 
 #if defined(HAVE_HWLOC)
 #include <hwloc.h>
@@ -15,6 +16,8 @@
 #endif
 #include <sched.h>
 #include <sys/sysinfo.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #define SHOW_AFFINITY
 #endif
 
@@ -88,6 +91,38 @@ int get_num_cpus()
     return get_nprocs_conf();
 }
 #endif
+
+#ifdef __linux__
+// shrink [addr, addr+size) to whole pages
+bool page_range(void *addr, size_t size, char *&begin, size_t &length)
+{
+    const uintptr_t pagesize = sysconf(_SC_PAGESIZE);
+    const uintptr_t b = (reinterpret_cast<uintptr_t>(addr) + pagesize - 1) / pagesize * pagesize;
+    const uintptr_t e = (reinterpret_cast<uintptr_t>(addr) + size) / pagesize * pagesize;
+    if (e <= b)
+        return false;
+    begin = reinterpret_cast<char *>(b);
+    length = e - b;
+    return true;
+}
+#endif
+
+#ifdef HAVE_HWLOC
+// loading the topology is expensive, so it is shared by all memory placement requests
+hwloc_topology_t memory_topology()
+{
+    static std::once_flag once;
+    static hwloc_topology_t topology = nullptr;
+    std::call_once(once, []() {
+        if (hwloc_topology_init(&topology) == -1) {
+            topology = nullptr;
+            return;
+        }
+        hwloc_topology_load(topology);
+    });
+    return topology;
+}
+#endif
 } // namespace
 
 std::string hwloc_affinity_map(int flags)
@@ -300,4 +335,99 @@ bool apply_affinity_from_environment(int nodeRank, int ranksOnThisNode)
     return false;
 }
 
+MemoryPlacement memory_placement_from_environment()
+{
+    const char *cenv = getenv("VISTLE_SHM_NUMA");
+    if (!cenv)
+        return MemoryPlacement::Default;
+    std::string env(cenv);
+    if (env.find("local") != std::string::npos)
+        return MemoryPlacement::Local;
+    if (env.find("first") != std::string::npos)
+        return MemoryPlacement::FirstTouch;
+    if (!env.empty() && env != "default") {
+        std::cerr << "affinity: possible values for VISTLE_SHM_NUMA are "
+                  << "default, firsttouch, local" << std::endl;
+    }
+    return MemoryPlacement::Default;
+}
+
+bool place_memory(void *addr, size_t size, MemoryPlacement placement)
+{
+    if (placement == MemoryPlacement::Default)
+        return true;
+#ifdef __linux__
+    char *begin = nullptr;
+    size_t length = 0;
+    if (!page_range(addr, size, begin, length))
+        return true;
+
+    // pages of shared memory that are still populated would keep their placement
+    if (madvise(begin, length, MADV_REMOVE) == -1) {
+        std::cerr << "affinity: failed to release pages for first-touch placement: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (placement == MemoryPlacement::FirstTouch)
+        return true;
+
+#ifdef HAVE_HWLOC
+    auto topology = memory_topology();
+    if (!topology)
+        return false;
+    hwloc_cpuset_t cpuset = hwloc_bitmap_alloc();
+    hwloc_nodeset_t nodeset = hwloc_bitmap_alloc();
+    bool ok = false;
+    if (cpuset && nodeset && hwloc_get_cpubind(topology, cpuset, HWLOC_CPUBIND_THREAD) == 0) {
+        hwloc_cpuset_to_nodeset(topology, cpuset, nodeset);
+        if (hwloc_bitmap_isequal(nodeset, hwloc_topology_get_topology_nodeset(topology))) {
+            // not pinned to a subset of the NUMA nodes: first touch is as good as it gets
+            ok = true;
+        } else {
+#if HWLOC_API_VERSION >= 0x00020000
+            ok = hwloc_set_area_membind(topology, begin, length, nodeset, HWLOC_MEMBIND_BIND,
+                                        HWLOC_MEMBIND_BYNODESET) == 0;
+#else
+            ok = hwloc_set_area_membind_nodeset(topology, begin, length, nodeset, HWLOC_MEMBIND_BIND, 0) == 0;
+#endif
+            if (!ok)
+                std::cerr << "affinity: failed to bind memory to NUMA nodes " << cpuset_to_string(nodeset)
+                          << std::endl;
+        }
+    }
+    if (cpuset)
+        hwloc_bitmap_free(cpuset);
+    if (nodeset)
+        hwloc_bitmap_free(nodeset);
+    return ok;
+#else
+    return true;
+#endif
+#else
+    (void)addr;
+    (void)size;
+    return false;
+#endif
+}
+
+bool advise_huge_pages(void *addr, size_t size, bool huge)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    char *begin = nullptr;
+    size_t length = 0;
+    if (!page_range(addr, size, begin, length))
+        return true;
+    if (madvise(begin, length, huge ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) == -1) {
+        std::cerr << "affinity: failed to advise " << (huge ? "" : "against ")
+                  << "transparent huge pages: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+#else
+    (void)addr;
+    (void)size;
+    (void)huge;
+    return false;
+#endif
+}
+
 } // namespace vistle
@@ -3,6 +3,7 @@
 
 #include "export.h"
 
+#include <cstddef>
 #include <string>
 
 namespace vistle {
@@ -12,5 +13,19 @@ V_UTILEXPORT std::string thread_affinity_map();
 V_UTILEXPORT std::string hwloc_affinity_map(int flags = -1);
 V_UTILEXPORT bool apply_affinity_from_environment(int nodeRank, int ranksOnThisNode);
 
+//! placement of memory pages on NUMA nodes
+enum class MemoryPlacement {
+    Default, //< leave placement to kernel policy
+    FirstTouch, //< release pages, so that they are placed near the next thread writing to them
+    Local, //< as FirstTouch, but bind pages to the NUMA nodes the calling thread is pinned to
+};
+
+//! placement requested by VISTLE_SHM_NUMA (firsttouch, local)
+V_UTILEXPORT MemoryPlacement memory_placement_from_environment();
+//! apply placement to the pages entirely within [addr, addr+size), their contents are discarded
+V_UTILEXPORT bool place_memory(void *addr, size_t size, MemoryPlacement placement);
+//! advise kernel to back [addr, addr+size) with transparent huge pages (or not to, if huge is false)
+V_UTILEXPORT bool advise_huge_pages(void *addr, size_t size, bool huge = true);
+
 } // namespace vistle
 #endif
@@ -61,14 +61,25 @@ int Sample::SampleToGrid(const vistle::GeometryInterface *target, vistle::DataBa
     Vec<Scalar>::ptr dataOut(new Vec<Scalar>(numVert));
     Scalar *ptrOnData = dataOut->x().data();
 
+    std::vector<Vector3> points(numVert);
     for (Index i = 0; i < numVert; ++i) {
-        Vector3 v = target->getVertex(i);
-        Index cellIdxIn =
-            inGrid->findCell(v, InvalidIndex, m_useCelltree ? GridInterface::NoFlags : GridInterface::NoCelltree);
-        if (cellIdxIn != InvalidIndex) {
-            GridInterface::Interpolator interp = inGrid->getInterpolator(cellIdxIn, v, DataBase::Vertex, mode);
-            Scalar p = interp(data);
-            ptrOnData[i] = p;
+        points[i] = target->getVertex(i);
+    }
+    std::vector<Index> cells(numVert);
+    inGrid->findCells(numVert, points.data(), cells.data(), nullptr,
+                      m_useCelltree ? GridInterface::NoFlags : GridInterface::NoCelltree);
+
+    std::vector<Scalar> coords[3];
+    for (int c = 0; c < 3; ++c) {
+        coords[c].resize(numVert);
+        for (Index i = 0; i < numVert; ++i)
+            coords[c][i] = points[i][c];
+    }
+    const Scalar *x[3] = {coords[0].data(), coords[1].data(), coords[2].data()};
+    inGrid->interpolate(numVert, cells.data(), x, 1, &data, &ptrOnData, DataBase::Vertex, mode);
+
+    for (Index i = 0; i < numVert; ++i) {
+        if (cells[i] != InvalidIndex) {
             found = 1;
         } else {
             ptrOnData[i] = NO_VALUE;
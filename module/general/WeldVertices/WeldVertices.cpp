@@ -1,3 +1,10 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
 #include <vistle/module/module.h>
 #include <vistle/core/triangles.h>
 #include <vistle/core/quads.h>
@@ -5,8 +12,10 @@
 #include <vistle/core/normals.h>
 #include <vistle/core/grid.h>
 #include <vistle/core/database.h>
+#include <vistle/core/vecdispatch.h>
 #include <vistle/core/unstr.h>
 #include <vistle/alg/objalg.h>
+#include <vistle/alg/parallelsort.h>
 
 class WeldVertices: public vistle::Module {
     static const int NumPorts = 3;
@@ -18,6 +27,7 @@ public:
 private:
     bool compute(std::shared_ptr<vistle::BlockTask> task) const override;
     vistle::Port *m_in[NumPorts], *m_out[NumPorts];
+    vistle::FloatParameter *m_epsilon = nullptr;
 };
 
 using namespace vistle;
@@ -29,47 +39,164 @@ WeldVertices::WeldVertices(const std::string &name, int moduleID, mpi::communica
         m_in[i] = createInputPort("data_in" + std::to_string(i));
         m_out[i] = createOutputPort("data_out" + std::to_string(i));
     }
+
+    m_epsilon = addFloatParameter(
+        "epsilon", "maximum difference of coordinates and vertex data of vertices to be merged (0: exact match)", 0.);
+    setParameterMinimum<Float>(m_epsilon, 0.);
 }
 
 WeldVertices::~WeldVertices()
 {}
 
-struct Point {
-    Point(Scalar x, Scalar y, Scalar z, Index v, const std::vector<const Scalar *> &floats)
-    : floats(floats), x(x), y(y), z(z), v(v)
+namespace {
+
+//! find vertices to be merged by hashing them into a grid of cells with edge length epsilon
+/*! vertices are merged if their coordinates and all vertex data differ by at most epsilon,
+ *  with epsilon == 0 each distinct position makes up a cell of its own */
+class Welder {
+public:
+    Welder(const Scalar *x, const Scalar *y, const Scalar *z, const std::vector<const Scalar *> &floats,
+           Scalar epsilon)
+    : m_coords{x, y, z}, m_floats(floats), m_epsilon(epsilon)
     {}
-    const std::vector<const Scalar *> &floats;
-    Scalar x, y, z;
-    Index v;
 
-    bool operator<(const Point &o) const
+    //! for each vertex in ascending list verts, determine the smallest vertex it is merged with
+    std::vector<Index> representatives(const std::vector<Index> &verts, Index numVertices) const
     {
-        if (x < o.x)
-            return true;
-        if (x > o.x)
-            return false;
+        std::vector<std::pair<uint64_t, Index>> keys(verts.size());
+#pragma omp parallel for
+        for (ssize_t k = 0; k < ssize_t(verts.size()); ++k) {
+            keys[k] = std::make_pair(hash(cell(verts[k])), verts[k]);
+        }
+        parallelSort(keys);
+
+        const int range = m_epsilon > 0 ? 1 : 0;
+        std::vector<Index> rep(numVertices, InvalidIndex);
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (ssize_t k = 0; k < ssize_t(verts.size()); ++k) {
+            const Index v = verts[k];
+            const Cell c = cell(v);
+            Index r = v;
+            for (int dx = -range; dx <= range; ++dx) {
+                for (int dy = -range; dy <= range; ++dy) {
+                    for (int dz = -range; dz <= range; ++dz) {
+                        const uint64_t h = hash(Cell{c[0] + dx, c[1] + dy, c[2] + dz});
+                        // vertices with equal hash are sorted by index, the first match is the smallest one
+                        for (auto it = std::lower_bound(keys.begin(), keys.end(), std::make_pair(h, Index(0)));
+                             it != keys.end() && it->first == h && it->second < r; ++it) {
+                            if (match(it->second, v)) {
+                                r = it->second;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+            rep[v] = r;
+        }
 
-        if (y < o.y)
-            return true;
-        if (y > o.y)
-            return false;
+        // merge transitively, representatives of smaller vertices are already final
+        for (auto v: verts)
+            rep[v] = rep[rep[v]];
+
+        return rep;
+    }
+
+private:
+    typedef std::array<int64_t, 3> Cell;
+
+    Cell cell(Index v) const
+    {
+        Cell c;
+        for (int d = 0; d < 3; ++d) {
+            Scalar p = m_coords[d][v];
+            if (m_epsilon > 0) {
+                const Scalar Max = Scalar(int64_t(1) << 60);
+                c[d] = int64_t(std::max(-Max, std::min(Max, std::floor(p / m_epsilon))));
+            } else {
+                if (p == 0)
+                    p = 0; // treat -0 and +0 alike
+                std::conditional<sizeof(Scalar) == 8, int64_t, int32_t>::type bits;
+                memcpy(&bits, &p, sizeof(bits));
+                c[d] = bits;
+            }
+        }
+        return c;
+    }
+
+    static uint64_t hash(const Cell &c)
+    {
+        return uint64_t(c[0]) * 73856093 ^ uint64_t(c[1]) * 19349663 ^ uint64_t(c[2]) * 83492791;
+    }
 
-        if (z < o.z)
+    bool match(Index u, Index v) const
+    {
+        if (m_epsilon > 0) {
+            for (int d = 0; d < 3; ++d) {
+                if (std::abs(m_coords[d][u] - m_coords[d][v]) > m_epsilon)
+                    return false;
+            }
+            for (auto f: m_floats) {
+                if (std::abs(f[u] - f[v]) > m_epsilon)
+                    return false;
+            }
             return true;
-        if (z > o.z)
-            return false;
+        }
 
-        for (auto f: floats) {
-            if (f[v] < f[o.v])
-                return true;
-            if (f[v] > f[o.v])
+        for (int d = 0; d < 3; ++d) {
+            if (m_coords[d][u] != m_coords[d][v])
                 return false;
         }
+        for (auto f: m_floats) {
+            if (f[u] != f[v])
+                return false;
+        }
+        return true;
+    }
+
+    const Scalar *m_coords[3];
+    const std::vector<const Scalar *> &m_floats;
+    const Scalar m_epsilon;
+};
+
+// one component array of any scalar type to be gathered from the welded vertices
+struct Gather {
+    const char *src;
+    char *dst;
+    size_t size; //< size of an entry in bytes
 
-        return false;
+    template<size_t Size>
+    void copy(Index i, Index v) const
+    {
+        memcpy(dst + i * Size, src + v * Size, Size);
+    }
+
+    void operator()(Index i, Index v) const
+    {
+        switch (size) {
+        case 1:
+            copy<1>(i, v);
+            break;
+        case 4:
+            copy<4>(i, v);
+            break;
+        case 8:
+            copy<8>(i, v);
+            break;
+        default:
+            memcpy(dst + i * size, src + v * size, size);
+            break;
+        }
     }
 };
 
+template<typename T>
+Gather gather(const T *src, T *dst)
+{
+    return Gather{reinterpret_cast<const char *>(src), reinterpret_cast<char *>(dst), sizeof(T)};
+}
+
+} // namespace
 
 bool WeldVertices::compute(std::shared_ptr<BlockTask> task) const
 {
@@ -91,9 +218,9 @@ bool WeldVertices::compute(std::shared_ptr<BlockTask> task) const
                     if (auto s = Vec<Scalar, 1>::as(din[i])) {
                         floats.push_back(s->x());
                     } else if (auto v = Vec<Scalar, 3>::as(din[i])) {
-                        floats.push_back(s->x());
-                        floats.push_back(s->y());
-                        floats.push_back(s->z());
+                        floats.push_back(v->x());
+                        floats.push_back(v->y());
+                        floats.push_back(v->z());
                     }
                 }
             }
@@ -125,134 +252,38 @@ bool WeldVertices::compute(std::shared_ptr<BlockTask> task) const
     }
 
     Object::ptr ogrid;
-    std::vector<Index> remap;
-    std::map<Point, Index> indexMap;
+    Index num = 0;
+    const Index *cl = nullptr;
+    Index *ncl = nullptr;
     if (auto tri = Triangles::as(grid)) {
-        Index num = tri->getNumCorners();
-        const Index *cl = num > 0 ? tri->cl() : nullptr;
+        num = tri->getNumCorners();
+        cl = num > 0 ? tri->cl() : nullptr;
         if (!cl)
             num = tri->getNumCoords();
-        remap.reserve(num);
-        const Scalar *x = tri->x(), *y = tri->y(), *z = tri->z();
 
         Triangles::ptr ntri(new Triangles(num, 0));
-        Index *ncl = ntri->cl().data();
-
-        if (cl) {
-            Index count = 0;
-            Index num = tri->getNumCorners();
-            for (Index i = 0; i < num; ++i) {
-                Index v = cl[i];
-                Point p(x[v], y[v], z[v], v, floats);
-                auto &idx = indexMap[p];
-                if (idx == 0) {
-                    remap.push_back(v);
-                    idx = ++count;
-                }
-                ncl[i] = idx - 1;
-            }
-            //sendInfo("found %d unique vertices among %d", count-1, num);
-        } else {
-            Index count = 0;
-            Index num = tri->getNumCoords();
-            for (Index v = 0; v < num; ++v) {
-                Point p(x[v], y[v], z[v], v, floats);
-                auto &idx = indexMap[p];
-                if (idx == 0) {
-                    remap.push_back(v);
-                    idx = ++count;
-                }
-                ncl[v] = idx - 1;
-            }
-            //sendInfo("found %d unique vertices among %d", count-1, num);
-        }
-
+        ncl = ntri->cl().data();
         ogrid = ntri;
     } else if (auto quad = Quads::as(grid)) {
-        Index num = quad->getNumCorners();
-        const Index *cl = num > 0 ? quad->cl() : nullptr;
+        num = quad->getNumCorners();
+        cl = num > 0 ? quad->cl() : nullptr;
         if (!cl)
             num = quad->getNumCoords();
-        remap.reserve(num);
-        const Scalar *x = quad->x(), *y = quad->y(), *z = quad->z();
 
         Quads::ptr nquad(new Quads(num, 0));
-        Index *ncl = nquad->cl().data();
-
-        if (cl) {
-            Index count = 0;
-            Index num = quad->getNumCorners();
-            for (Index i = 0; i < num; ++i) {
-                Index v = cl[i];
-                Point p(x[v], y[v], z[v], v, floats);
-                auto &idx = indexMap[p];
-                if (idx == 0) {
-                    remap.push_back(v);
-                    idx = ++count;
-                }
-                ncl[i] = idx - 1;
-            }
-            //sendInfo("found %d unique vertices among %d", count-1, num);
-        } else {
-            Index count = 0;
-            Index num = quad->getNumCoords();
-            for (Index v = 0; v < num; ++v) {
-                Point p(x[v], y[v], z[v], v, floats);
-                auto &idx = indexMap[p];
-                if (idx == 0) {
-                    remap.push_back(v);
-                    idx = ++count;
-                }
-                ncl[v] = idx - 1;
-            }
-            //sendInfo("found %d unique vertices among %d", count-1, num);
-        }
-
+        ncl = nquad->cl().data();
         ogrid = nquad;
     } else if (auto idx = Indexed::as(grid)) {
-        Index num = idx->getNumCorners();
-        const Index *cl = num > 0 ? idx->cl() : nullptr;
+        num = idx->getNumCorners();
+        cl = num > 0 ? idx->cl() : nullptr;
         if (!cl)
             num = idx->getNumCoords();
-        const Scalar *x = idx->x(), *y = idx->y(), *z = idx->z();
-        remap.reserve(num);
 
         Indexed::ptr nidx = idx->clone();
         nidx->resetArrays();
         nidx->resetCorners();
         nidx->cl().resize(num);
-
-        Index *ncl = nidx->cl().data();
-
-        if (cl) {
-            Index count = 0;
-            Index num = idx->getNumCorners();
-            for (Index i = 0; i < num; ++i) {
-                Index v = cl[i];
-                Point p(x[v], y[v], z[v], v, floats);
-                auto &idx = indexMap[p];
-                if (idx == 0) {
-                    remap.push_back(v);
-                    idx = ++count;
-                }
-                ncl[i] = idx - 1;
-            }
-            //sendInfo("found %d unique vertices among %d", count-1, num);
-        } else {
-            Index count = 0;
-            Index num = idx->getNumCoords();
-            for (Index v = 0; v < num; ++v) {
-                Point p(x[v], y[v], z[v], v, floats);
-                auto &idx = indexMap[p];
-                if (idx == 0) {
-                    remap.push_back(v);
-                    idx = ++count;
-                }
-                ncl[v] = idx - 1;
-            }
-            //sendInfo("found %d unique vertices among %d", count-1, num);
-        }
-
+        ncl = nidx->cl().data();
         ogrid = nidx;
     }
 
@@ -266,17 +297,84 @@ bool WeldVertices::compute(std::shared_ptr<BlockTask> task) const
         return true;
     }
 
-    const auto ix = &coord->x()[0];
-    const auto iy = &coord->y()[0];
-    const auto iz = &coord->z()[0];
+    const Index numCoords = coord->getNumCoords();
+    std::vector<Index> verts;
+    if (cl) {
+        std::vector<char> used(numCoords, 0);
+        for (Index i = 0; i < num; ++i)
+            used[cl[i]] = 1;
+        for (Index v = 0; v < numCoords; ++v) {
+            if (used[v])
+                verts.push_back(v);
+        }
+    } else {
+        verts.resize(num);
+        for (Index v = 0; v < num; ++v)
+            verts[v] = v;
+    }
+
+    Welder welder(coord->x(), coord->y(), coord->z(), floats, m_epsilon->getValue());
+    const auto rep = welder.representatives(verts, numCoords);
+    verts.clear();
+
+    // number merged vertices in order of first use
+    std::vector<Index> remap;
+    std::vector<Index> index(numCoords, InvalidIndex);
+    for (Index i = 0; i < num; ++i) {
+        const Index v = rep[cl ? cl[i] : i];
+        if (index[v] == InvalidIndex) {
+            index[v] = remap.size();
+            remap.push_back(v);
+        }
+        ncl[i] = index[v];
+    }
+    //sendInfo("found %d unique vertices among %d", int(remap.size()), int(num));
+
+    // coordinates and all vertex-mapped arrays are gathered together in a single pass
+    std::vector<Gather> arrays;
     ncoord->setSize(remap.size());
-    auto nx = &ncoord->x()[0];
-    auto ny = &ncoord->y()[0];
-    auto nz = &ncoord->z()[0];
-    for (Index i = 0; i < remap.size(); ++i) {
-        nx[i] = ix[remap[i]];
-        ny[i] = iy[remap[i]];
-        nz[i] = iz[remap[i]];
+    arrays.push_back(gather(&coord->x()[0], ncoord->x().data()));
+    arrays.push_back(gather(&coord->y()[0], ncoord->y().data()));
+    arrays.push_back(gather(&coord->z()[0], ncoord->z().data()));
+
+    Normals::ptr nout;
+    if (normals && normals->mapping() != DataBase::Element) {
+        nout = normals->clone();
+        nout->resetArrays();
+        nout->setSize(remap.size());
+        arrays.push_back(gather(&normals->x()[0], nout->x().data()));
+        arrays.push_back(gather(&normals->y()[0], nout->y().data()));
+        arrays.push_back(gather(&normals->z()[0], nout->z().data()));
+    }
+
+    DataBase::ptr dout[NumPorts];
+    for (int i = 0; i < NumPorts; ++i) {
+        if (!din[i])
+            continue;
+        dout[i] = din[i]->clone();
+        if (din[i]->mapping() == DataBase::Element)
+            continue;
+        dout[i]->resetArrays();
+        dout[i]->setSize(remap.size());
+        DataBase::ptr out = dout[i];
+        bool handled = visitVec(DataBase::const_ptr(din[i]), [&arrays, out](auto in) {
+            typedef typename std::decay<decltype(*in)>::type V;
+            auto o = V::as(Object::ptr(out));
+            assert(o);
+            for (unsigned c = 0; c < V::Dimension; ++c)
+                arrays.push_back(gather(&in->x(c)[0], o->x(c).data()));
+        });
+        if (!handled) {
+            sendError("unsupported data type on port %s", m_in[i]->getName().c_str());
+            return true;
+        }
+    }
+
+#pragma omp parallel for
+    for (ssize_t i = 0; i < ssize_t(remap.size()); ++i) {
+        const Index v = remap[i];
+        for (const auto &a: arrays)
+            a(i, v);
     }
 
     if (normals) {
@@ -284,55 +382,16 @@ bool WeldVertices::compute(std::shared_ptr<BlockTask> task) const
         if (normals->mapping() == DataBase::Element) {
             oc->setNormals(normals);
         } else {
-            auto nout = normals->clone();
-            nout->resetArrays();
-            nout->setSize(remap.size());
-            const Scalar *x = normals->x(), *y = normals->y(), *z = normals->z();
-            Scalar *ox = nout->x().data(), *oy = nout->y().data(), *oz = nout->z().data();
-            for (Index i = 0; i < remap.size(); ++i) {
-                ox[i] = x[remap[i]];
-                oy[i] = y[remap[i]];
-                oz[i] = z[remap[i]];
-            }
             updateMeta(nout);
             oc->setNormals(nout);
         }
     }
 
     for (int i = 0; i < NumPorts; ++i) {
-        if (din[i]) {
-            if (din[i]->mapping() == DataBase::Element) {
-                auto dout = din[i]->clone();
-                dout->setGrid(ogrid);
-                updateMeta(dout);
-                task->addObject(m_out[i], dout);
-            } else {
-                auto dout = din[i]->clone();
-                dout->resetArrays();
-                dout->setSize(remap.size());
-                if (auto si = Vec<Scalar>::as(Object::const_ptr(din[i]))) {
-                    auto so = Vec<Scalar>::as(Object::ptr(dout));
-                    assert(so);
-                    const Scalar *x = si->x();
-                    Scalar *ox = so->x().data();
-                    for (Index i = 0; i < remap.size(); ++i) {
-                        ox[i] = x[remap[i]];
-                    }
-                } else if (auto vi = Vec<Scalar, 3>::as(Object::const_ptr(din[i]))) {
-                    auto vo = Vec<Scalar, 3>::as(Object::ptr(dout));
-                    assert(vo);
-                    const Scalar *x = vi->x(), *y = vi->y(), *z = vi->z();
-                    Scalar *ox = vo->x().data(), *oy = vo->y().data(), *oz = vo->z().data();
-                    for (Index i = 0; i < remap.size(); ++i) {
-                        ox[i] = x[remap[i]];
-                        oy[i] = y[remap[i]];
-                        oz[i] = z[remap[i]];
-                    }
-                }
-                dout->setGrid(ogrid);
-                updateMeta(dout);
-                task->addObject(m_out[i], dout);
-            }
+        if (dout[i]) {
+            dout[i]->setGrid(ogrid);
+            updateMeta(dout[i]);
+            task->addObject(m_out[i], dout[i]);
         } else {
             task->addObject(m_out[i], ogrid);
         }
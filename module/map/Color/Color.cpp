@@ -1,10 +1,14 @@
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include <cfloat>
 #include <limits>
+#include <cmath>
+#include <type_traits>
 #include <vistle/core/vector.h>
 #include <vistle/core/object.h>
 #include <vistle/core/vec.h>
+#include <vistle/core/vecdispatch.h>
 #include <vistle/core/texture1d.h>
 #include <vistle/core/coords.h>
 #include <vistle/util/math.h>
@@ -20,8 +24,6 @@
 
 MODULE_MAIN(Color)
 
-//#define USE_OPENMP
-
 using namespace vistle;
 
 // clang-format off
@@ -167,6 +169,8 @@ Color::Color(const std::string &name, int moduleID, mpi::communicator comm): Mod
     m_autoRangePara = addIntParameter("auto_range", "compute range automatically", m_autoRange, Parameter::Boolean);
     addIntParameter("preview", "use preliminary colormap for showing preview when determining bounds", true,
                     Parameter::Boolean);
+    m_cacheRangePara = addIntParameter("cache_range", "remember data range of input objects across executions",
+                                       true, Parameter::Boolean);
 
     setCurrentParameterGroup("Nested Color Map");
     m_nestPara = addIntParameter("nest", "inset another color map", m_nest, Parameter::Boolean);
@@ -189,6 +193,8 @@ Color::Color(const std::string &name, int moduleID, mpi::communicator comm): Mod
     setParameterRange(m_insetOpacity, 0., 1.);
 
     addResultCache(m_cache);
+    m_rangeCache.setPersistent(true);
+    addResultCache(m_rangeCache);
 
     ColorMap::TF pins;
     typedef ColorMap::RGBA RGBA;
@@ -327,122 +333,117 @@ Color::Color(const std::string &name, int moduleID, mpi::communicator comm): Mod
 Color::~Color()
 {}
 
+namespace {
+
+// value that is mapped to a color: the data itself for scalars, the magnitude for vectors
+template<class V>
+struct MappedValue {
+    static const unsigned Dim = V::Dimension;
+    const typename V::Scalar *x[Dim];
+
+    explicit MappedValue(const V &vec)
+    {
+        for (unsigned c = 0; c < Dim; ++c)
+            x[c] = vec.x(c);
+    }
+
+    // squared magnitude for vectors, which is monotonic in the mapped value
+    Scalar squared(Index index) const
+    {
+        Scalar sq = 0;
+        for (unsigned c = 0; c < Dim; ++c) {
+            const Scalar v = x[c][index];
+            sq += v * v;
+        }
+        return sq;
+    }
+
+    Scalar operator()(Index index) const
+    {
+        if (Dim == 1)
+            return x[0][index];
+        return std::sqrt(squared(index));
+    }
+};
+
+// range of mapped values, for vectors the square root is only taken for the extremal magnitudes
+template<class V>
+void mappedRange(const MappedValue<V> &value, ssize_t numElements, Scalar &min, Scalar &max)
+{
+    if (numElements <= 0)
+        return;
+
+    Scalar lo = std::numeric_limits<Scalar>::max();
+    Scalar hi = -std::numeric_limits<Scalar>::max();
+    if (MappedValue<V>::Dim == 1) {
+        const auto *x = value.x[0];
+#pragma omp parallel for simd reduction(min : lo) reduction(max : hi)
+        for (ssize_t index = 0; index < numElements; index++) {
+            const Scalar v = x[index];
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+    } else {
+#pragma omp parallel for simd reduction(min : lo) reduction(max : hi)
+        for (ssize_t index = 0; index < numElements; index++) {
+            const Scalar v = value.squared(index);
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+        if (lo > hi)
+            return;
+        lo = std::sqrt(lo);
+        hi = std::sqrt(hi);
+    }
+
+    if (lo < min)
+        min = lo;
+    if (hi > max)
+        max = hi;
+}
+
+// texture coordinates for mapped values, without data-dependent branches so that the loops vectorize
+template<class V>
+void mappedTexCoords(const MappedValue<V> &value, ssize_t numElements, Scalar min, Scalar invRange, Scalar *tc)
+{
+    if (MappedValue<V>::Dim == 1) {
+        const auto *x = value.x[0];
+#pragma omp parallel for simd
+        for (ssize_t index = 0; index < numElements; index++)
+            tc[index] = (Scalar(x[index]) - min) * invRange;
+    } else {
+#pragma omp parallel for simd
+        for (ssize_t index = 0; index < numElements; index++)
+            tc[index] = (std::sqrt(value.squared(index)) - min) * invRange;
+    }
+}
+
+} // namespace
+
 void Color::getMinMax(vistle::DataBase::const_ptr object, vistle::Scalar &min, vistle::Scalar &max)
 {
     const ssize_t numElements = object->getSize();
 
-    if (Vec<Byte>::const_ptr scal = Vec<Byte>::as(object)) {
-        const vistle::Byte *x = &scal->x()[0];
-#ifdef USE_OPENMP
-#pragma omp parallel
-#endif
-        {
-            Byte tmin = std::numeric_limits<Byte>::max();
-            Byte tmax = std::numeric_limits<Byte>::min();
-#ifdef USE_OPENMP
-#pragma omp for
-#endif
-            for (ssize_t index = 0; index < numElements; index++) {
-                if (x[index] < tmin)
-                    tmin = x[index];
-                if (x[index] > tmax)
-                    tmax = x[index];
-            }
-#ifdef USE_OPENMP
-#pragma omp critical
-#endif
-            {
-                if (tmin < min)
-                    min = tmin;
-                if (tmax > max)
-                    max = tmax;
-            }
-        }
-    } else if (Vec<Index>::const_ptr scal = Vec<Index>::as(object)) {
-        const vistle::Index *x = &scal->x()[0];
-#ifdef USE_OPENMP
-#pragma omp parallel
-#endif
-        {
-            Index tmin = std::numeric_limits<Index>::max();
-            Index tmax = std::numeric_limits<Index>::min();
-#ifdef USE_OPENMP
-#pragma omp for
-#endif
-            for (ssize_t index = 0; index < numElements; index++) {
-                if (x[index] < tmin)
-                    tmin = x[index];
-                if (x[index] > tmax)
-                    tmax = x[index];
-            }
-#ifdef USE_OPENMP
-#pragma omp critical
-#endif
-            {
-                if (tmin < min)
-                    min = tmin;
-                if (tmax > max)
-                    max = tmax;
-            }
-        }
-    } else if (Vec<Scalar>::const_ptr scal = Vec<Scalar>::as(object)) {
-        const vistle::Scalar *x = &scal->x()[0];
-#ifdef USE_OPENMP
-#pragma omp parallel
-#endif
-        {
-            Scalar tmin = std::numeric_limits<Scalar>::max();
-            Scalar tmax = -std::numeric_limits<Scalar>::max();
-#ifdef USE_OPENMP
-#pragma omp for
-#endif
-            for (ssize_t index = 0; index < numElements; index++) {
-                if (x[index] < tmin)
-                    tmin = x[index];
-                if (x[index] > tmax)
-                    tmax = x[index];
-            }
-#ifdef USE_OPENMP
-#pragma omp critical
-#endif
-            {
-                if (tmin < min)
-                    min = tmin;
-                if (tmax > max)
-                    max = tmax;
-            }
-        }
-    } else if (Vec<Scalar, 3>::const_ptr vec = Vec<Scalar, 3>::as(object)) {
-        const vistle::Scalar *x = &vec->x()[0];
-        const vistle::Scalar *y = &vec->y()[0];
-        const vistle::Scalar *z = &vec->z()[0];
-#ifdef USE_OPENMP
-#pragma omp parallel
-#endif
-        {
-            Scalar tmin = std::numeric_limits<Scalar>::max();
-            Scalar tmax = -std::numeric_limits<Scalar>::max();
-#ifdef USE_OPENMP
-#pragma omp for
-#endif
-            for (ssize_t index = 0; index < numElements; index++) {
-                Scalar v = Vector3(x[index], y[index], z[index]).norm();
-                if (v < tmin)
-                    tmin = v;
-                if (v > tmax)
-                    tmax = v;
-            }
-#ifdef USE_OPENMP
-#pragma omp critical
-#endif
-            {
-                if (tmin < min)
-                    min = tmin;
-                if (tmax > max)
-                    max = tmax;
-            }
+    visitVec(object, [&](auto vec) {
+        typedef typename std::decay<decltype(*vec)>::type V;
+        mappedRange(MappedValue<V>(*vec), numElements, min, max);
+    });
+}
+
+void Color::updateDataRange(vistle::DataBase::const_ptr object)
+{
+    DataRange range(std::numeric_limits<Scalar>::max(), -std::numeric_limits<Scalar>::max());
+    if (m_cacheRangePara->getValue()) {
+        if (auto entry = m_rangeCache.getOrLock(object->getName(), range)) {
+            getMinMax(object, range.first, range.second);
+            m_rangeCache.storeAndUnlock(entry, range);
         }
+    } else {
+        getMinMax(object, range.first, range.second);
     }
+
+    m_dataMin = std::min(m_dataMin, range.first);
+    m_dataMax = std::max(m_dataMax, range.second);
 }
 
 void Color::binData(vistle::DataBase::const_ptr object, std::vector<unsigned long> &binsVec)
@@ -453,34 +454,14 @@ void Color::binData(vistle::DataBase::const_ptr object, std::vector<unsigned lon
     const Scalar w = m_max - m_min;
     unsigned long *bins = binsVec.data();
 
-    if (Vec<Byte>::const_ptr scal = Vec<Byte>::as(object)) {
-        const vistle::Byte *x = &scal->x()[0];
-        for (ssize_t index = 0; index < numElements; index++) {
-            const int bin = clamp<int>((x[index] - m_min) / w * numBins, 0, numBins - 1);
-            ++bins[bin];
-        }
-    } else if (Vec<Index>::const_ptr scal = Vec<Index>::as(object)) {
-        const vistle::Index *x = &scal->x()[0];
+    visitVec(object, [&](auto vec) {
+        typedef typename std::decay<decltype(*vec)>::type V;
+        const MappedValue<V> value(*vec);
         for (ssize_t index = 0; index < numElements; index++) {
-            const int bin = clamp<int>((x[index] - m_min) / w * numBins, 0, numBins - 1);
+            const int bin = clamp<int>((value(index) - m_min) / w * numBins, 0, numBins - 1);
             ++bins[bin];
         }
-    } else if (Vec<Scalar>::const_ptr scal = Vec<Scalar>::as(object)) {
-        const vistle::Scalar *x = &scal->x()[0];
-        for (ssize_t index = 0; index < numElements; index++) {
-            const int bin = clamp<int>((x[index] - m_min) / w * numBins, 0, numBins - 1);
-            ++bins[bin];
-        }
-    } else if (Vec<Scalar, 3>::const_ptr vec = Vec<Scalar, 3>::as(object)) {
-        const vistle::Scalar *x = &vec->x()[0];
-        const vistle::Scalar *y = &vec->y()[0];
-        const vistle::Scalar *z = &vec->z()[0];
-        for (ssize_t index = 0; index < numElements; index++) {
-            const Scalar v = Vector3(x[index], y[index], z[index]).norm();
-            const int bin = clamp<int>((v - m_min) / w * numBins, 0, numBins - 1);
-            ++bins[bin];
-        }
-    }
+    });
 }
 
 
@@ -573,56 +554,20 @@ vistle::Texture1D::ptr Color::addTexture(vistle::DataBase::const_ptr object, con
     const Scalar invRange = 1.f / (max - min);
 
     vistle::Texture1D::ptr tex(new vistle::Texture1D(cmap.width, min, max));
-    unsigned char *pix = &tex->pixels()[0];
-    for (size_t index = 0; index < cmap.width * 4; index++)
-        pix[index] = cmap.data[index];
+    std::copy(cmap.data.begin(), cmap.data.begin() + cmap.width * 4, &tex->pixels()[0]);
 
     const ssize_t numElem = object->getSize();
     tex->coords().resize(numElem);
     auto tc = tex->coords().data();
 
-    if (Vec<Scalar>::const_ptr f = Vec<Scalar>::as(object)) {
-        const vistle::Scalar *x = &f->x()[0];
-
-#ifdef USE_OPENMP
-#pragma omp parallel for
-#endif
-        for (ssize_t index = 0; index < numElem; index++)
-            tc[index] = (x[index] - min) * invRange;
-    } else if (Vec<Index>::const_ptr f = Vec<Index>::as(object)) {
-        const vistle::Index *x = &f->x()[0];
-
-#ifdef USE_OPENMP
-#pragma omp parallel for
-#endif
-        for (ssize_t index = 0; index < numElem; index++)
-            tc[index] = (x[index] - min) * invRange;
-    } else if (Vec<Byte>::const_ptr f = Vec<Byte>::as(object)) {
-        const vistle::Byte *x = &f->x()[0];
-
-#ifdef USE_OPENMP
-#pragma omp parallel for
-#endif
-        for (ssize_t index = 0; index < numElem; index++)
-            tc[index] = (x[index] - min) * invRange;
-    } else if (Vec<Scalar, 3>::const_ptr f = Vec<Scalar, 3>::as(object)) {
-        const vistle::Scalar *x = &f->x()[0];
-        const vistle::Scalar *y = &f->y()[0];
-        const vistle::Scalar *z = &f->z()[0];
-
-#ifdef USE_OPENMP
-#pragma omp parallel for
-#endif
-        for (ssize_t index = 0; index < numElem; index++) {
-            const Scalar v = Vector3(x[index], y[index], z[index]).norm();
-            tc[index] = (v - min) * invRange;
-        }
-    } else {
+    bool handled = visitVec(object, [&](auto vec) {
+        typedef typename std::decay<decltype(*vec)>::type V;
+        mappedTexCoords(MappedValue<V>(*vec), numElem, min, invRange, tc);
+    });
+    if (!handled) {
         std::cerr << "Color: cannot handle input of type " << object->getType() << std::endl;
 
-#ifdef USE_OPENMP
 #pragma omp parallel for
-#endif
         for (ssize_t index = 0; index < numElem; index++) {
             tc[index] = (index % 2) ? 0. : 1.;
         }
@@ -801,7 +746,7 @@ bool Color::compute()
 
     assert(data);
 
-    getMinMax(data, m_dataMin, m_dataMax);
+    updateDataRange(data);
     bool preview = getIntParameter("preview");
     if (m_autoRange) {
         m_inputQueue.push_back(data);
@@ -30,6 +30,7 @@ private:
                                       const vistle::Scalar max, const ColorMap &cmap);
 
     void getMinMax(vistle::DataBase::const_ptr object, vistle::Scalar &min, vistle::Scalar &max);
+    void updateDataRange(vistle::DataBase::const_ptr object);
     void binData(vistle::DataBase::const_ptr object, std::vector<unsigned long> &binsVec);
     void computeMap();
     void sendColorMap();
@@ -48,6 +49,7 @@ private:
 
     bool m_autoRange = true, m_autoInsetCenter = true, m_nest = false;
     vistle::IntParameter *m_autoRangePara, *m_autoInsetCenterPara, *m_nestPara;
+    vistle::IntParameter *m_cacheRangePara = nullptr;
     vistle::FloatParameter *m_minPara = nullptr, *m_maxPara = nullptr;
     vistle::IntParameter *m_constrain = nullptr;
     vistle::FloatParameter *m_center = nullptr;
@@ -71,6 +73,8 @@ private:
     vistle::Port *m_dataIn = nullptr;
     vistle::Port *m_dataOut = nullptr, *m_colorOut = nullptr;
     vistle::ResultCache<vistle::Object::ptr> m_cache;
+    typedef std::pair<vistle::Scalar, vistle::Scalar> DataRange;
+    vistle::ResultCache<DataRange> m_rangeCache; //< min/max of input objects, keyed by object name
 };
 
 #endif
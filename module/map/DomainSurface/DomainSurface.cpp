@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <vector>
 
 #include <vistle/core/object.h>
 #include <vistle/core/vec.h>
@@ -9,11 +11,10 @@
 #include <vistle/core/structuredgrid.h>
 #include <vistle/module/resultcache.h>
 #include <vistle/alg/objalg.h>
+#include <vistle/alg/parallelsort.h>
 
 #include "DomainSurface.h"
 
-#define USE_SET
-
 using namespace vistle;
 
 DomainSurface::DomainSurface(const std::string &name, int moduleID, mpi::communicator comm)
@@ -64,21 +65,34 @@ typename Vec<T, Dim>::ptr remapData(typename Vec<T, Dim>::const_ptr in, const Do
 
 namespace {
 
-template<class Connected>
-void createVertices(StructuredGridBase::const_ptr grid, typename Connected::ptr conn, DomainSurface::DataMapping &vm)
+// number of cells handled by one thread at a time
+const Index ChunkSize = 65536;
+
+//! replace vertex indices in cl by indices into vm, which receives all referenced vertices in ascending order
+void compactVertices(Index *cl, Index numCorners, Index numVertices, DomainSurface::DataMapping &vm)
 {
+    std::vector<Index> mapped(numVertices, InvalidIndex);
+    for (Index i = 0; i < numCorners; ++i)
+        mapped[cl[i]] = 0;
+
     vm.clear();
-    std::map<Index, Index> mapped;
-    for (Index &v: conn->cl()) {
-        if (mapped.emplace(v, vm.size()).second) {
-            Index vv = vm.size();
+    for (Index v = 0; v < numVertices; ++v) {
+        if (mapped[v] != InvalidIndex) {
+            mapped[v] = vm.size();
             vm.push_back(v);
-            v = vv;
-        } else {
-            v = mapped[v];
         }
     }
-    mapped.clear();
+
+#pragma omp parallel for
+    for (ssize_t i = 0; i < ssize_t(numCorners); ++i)
+        cl[i] = mapped[cl[i]];
+}
+
+template<class Connected>
+void createVertices(StructuredGridBase::const_ptr grid, typename Connected::ptr conn, DomainSurface::DataMapping &vm)
+{
+    const Index numVertices = grid->getNumDivisions(0) * grid->getNumDivisions(1) * grid->getNumDivisions(2);
+    compactVertices(conn->cl().data(), conn->cl().size(), numVertices, vm);
 
     auto &px = conn->x();
     auto &py = conn->y();
@@ -87,7 +101,8 @@ void createVertices(StructuredGridBase::const_ptr grid, typename Connected::ptr
     py.resize(vm.size());
     pz.resize(vm.size());
 
-    for (Index i = 0; i < vm.size(); ++i) {
+#pragma omp parallel for
+    for (ssize_t i = 0; i < ssize_t(vm.size()); ++i) {
         Vector3 p = grid->getVertex(vm[i]);
         px[i] = p[0];
         py[i] = p[1];
@@ -95,6 +110,29 @@ void createVertices(StructuredGridBase::const_ptr grid, typename Connected::ptr
     }
 }
 
+template<class Connected>
+void copyVertices(Coords::const_ptr coords, typename Connected::ptr conn, DomainSurface::DataMapping &vm)
+{
+    compactVertices(conn->cl().data(), conn->cl().size(), coords->getNumCoords(), vm);
+
+    const Scalar *xcoord = &coords->x()[0];
+    const Scalar *ycoord = &coords->y()[0];
+    const Scalar *zcoord = &coords->z()[0];
+    auto &px = conn->x();
+    auto &py = conn->y();
+    auto &pz = conn->z();
+    px.resize(vm.size());
+    py.resize(vm.size());
+    pz.resize(vm.size());
+
+#pragma omp parallel for
+    for (ssize_t i = 0; i < ssize_t(vm.size()); ++i) {
+        px[i] = xcoord[vm[i]];
+        py[i] = ycoord[vm[i]];
+        pz[i] = zcoord[vm[i]];
+    }
+}
+
 } // namespace
 
 bool DomainSurface::compute(std::shared_ptr<BlockTask> task) const
@@ -412,35 +450,7 @@ void DomainSurface::renumberVertices(Coords::const_ptr coords, Indexed::ptr poly
         poly->d()->x[1] = coords->d()->x[1];
         poly->d()->x[2] = coords->d()->x[2];
     } else {
-        vm.clear();
-
-        std::map<Index, Index> mapped;
-        for (Index &v: poly->cl()) {
-            if (mapped.emplace(v, vm.size()).second) {
-                Index vv = vm.size();
-                vm.push_back(v);
-                v = vv;
-            } else {
-                v = mapped[v];
-            }
-        }
-        mapped.clear();
-
-        const Scalar *xcoord = &coords->x()[0];
-        const Scalar *ycoord = &coords->y()[0];
-        const Scalar *zcoord = &coords->z()[0];
-        auto &px = poly->x();
-        auto &py = poly->y();
-        auto &pz = poly->z();
-        px.resize(vm.size());
-        py.resize(vm.size());
-        pz.resize(vm.size());
-
-        for (Index i = 0; i < vm.size(); ++i) {
-            px[i] = xcoord[vm[i]];
-            py[i] = ycoord[vm[i]];
-            pz[i] = zcoord[vm[i]];
-        }
+        copyVertices<Indexed>(coords, poly, vm);
     }
 }
 
@@ -453,35 +463,7 @@ void DomainSurface::renumberVertices(Coords::const_ptr coords, Quads::ptr quad,
         quad->d()->x[1] = coords->d()->x[1];
         quad->d()->x[2] = coords->d()->x[2];
     } else {
-        vm.clear();
-
-        std::map<Index, Index> mapped;
-        for (Index &v: quad->cl()) {
-            if (mapped.emplace(v, vm.size()).second) {
-                Index vv = vm.size();
-                vm.push_back(v);
-                v = vv;
-            } else {
-                v = mapped[v];
-            }
-        }
-        mapped.clear();
-
-        const Scalar *xcoord = &coords->x()[0];
-        const Scalar *ycoord = &coords->y()[0];
-        const Scalar *zcoord = &coords->z()[0];
-        auto &px = quad->x();
-        auto &py = quad->y();
-        auto &pz = quad->z();
-        px.resize(vm.size());
-        py.resize(vm.size());
-        pz.resize(vm.size());
-
-        for (Index i = 0; i < vm.size(); ++i) {
-            px[i] = xcoord[vm[i]];
-            py[i] = ycoord[vm[i]];
-            pz[i] = zcoord[vm[i]];
-        }
+        copyVertices<Quads>(coords, quad, vm);
     }
 }
 
@@ -490,6 +472,7 @@ struct Face {
     Index face = InvalidIndex;
     std::array<Index, 3> verts;
 
+    Face() = default;
     Face(Index e, Index f, Index sz, const Index *vl, const unsigned *cl): elem(e), face(f)
     {
         if (sz == 0)
@@ -567,24 +550,59 @@ std::ostream &operator<<(std::ostream &os, const Face &f)
     return os;
 }
 
-#ifdef USE_SET
-typedef std::set<Face> FaceSet;
-#else
-struct FaceHash {
-    size_t operator()(const Face &f) const
+namespace {
+
+struct Edge {
+    Edge(Index va, Index vb): v0(std::min(va, vb)), v1(std::max(va, vb)) {}
+    bool operator==(const Edge &o) const { return v0 == o.v0 && v1 == o.v1; }
+    bool operator<(const Edge &o) const
     {
-        const unsigned N = 3;
-        const size_t primes[N] = {21619127, 731372359, 16267148063931119};
-        size_t h = 0;
-        for (unsigned i = 0; i < N && i < f.verts.size(); ++i) {
-            h += primes[i] * f.verts[i];
-        }
-        return std::hash<size_t>()(h);
+        if (v0 == o.v0)
+            return v1 < o.v1;
+        return v0 < o.v0;
     }
+
+    Index v0 = InvalidIndex, v1 = InvalidIndex;
 };
 
-typedef std::unordered_set<Face, FaceHash> FaceSet;
-#endif
+//! output generated by one thread for a contiguous range of cells
+struct SurfaceChunk {
+    std::vector<Index> pcl, pl, em; //!< polygon corners, end of each polygon within pcl, originating cell
+    std::vector<Index> lcl, ll, lem; //!< same for feature lines
+    std::vector<Index> cellFaces; //!< boundary faces of the cell currently being processed
+    std::vector<Edge> edges; //!< scratch space for counting edges of cellFaces
+};
+
+//! append output of all chunks in order, with element lists shifted to account for preceding chunks
+template<class Array>
+void appendChunks(const std::vector<SurfaceChunk> &chunks, std::vector<Index> SurfaceChunk::*ccl,
+                  std::vector<Index> SurfaceChunk::*cel, std::vector<Index> SurfaceChunk::*cem, Array &cl, Array &el,
+                  DomainSurface::DataMapping &em)
+{
+    const size_t n = chunks.size();
+    std::vector<size_t> clOff(n + 1, cl.size()), elOff(n + 1, el.size()), emOff(n + 1, em.size());
+    for (size_t c = 0; c < n; ++c) {
+        clOff[c + 1] = clOff[c] + (chunks[c].*ccl).size();
+        elOff[c + 1] = elOff[c] + (chunks[c].*cel).size();
+        emOff[c + 1] = emOff[c] + (chunks[c].*cem).size();
+    }
+    cl.resize(clOff[n]);
+    el.resize(elOff[n]);
+    em.resize(emOff[n]);
+
+    Index *clData = cl.data(), *elData = el.data(), *emData = em.data();
+#pragma omp parallel for schedule(dynamic)
+    for (ssize_t c = 0; c < ssize_t(n); ++c) {
+        const auto &chunk = chunks[c];
+        const Index off = clOff[c];
+        std::copy((chunk.*ccl).begin(), (chunk.*ccl).end(), clData + clOff[c]);
+        std::transform((chunk.*cel).begin(), (chunk.*cel).end(), elData + elOff[c],
+                       [off](Index end) { return end + off; });
+        std::copy((chunk.*cem).begin(), (chunk.*cem).end(), emData + emOff[c]);
+    }
+}
+
+} // namespace
 
 DomainSurface::Result<Polygons> DomainSurface::createSurface(vistle::UnstructuredGrid::const_ptr m_grid_in,
                                                              bool haveElementData, bool createSurface,
@@ -611,15 +629,29 @@ DomainSurface::Result<Polygons> DomainSurface::createSurface(vistle::Unstructure
 
     Polygons::ptr m_grid_out(new Polygons(0, 0, 0));
     result.surface = m_grid_out;
-    auto &pl = m_grid_out->el();
-    auto &pcl = m_grid_out->cl();
-    DataMapping &em = result.surfaceElements;
     result.lines.reset(new Lines(0, 0, 0));
-    auto &ll = result.lines->el();
-    auto &lcl = result.lines->cl();
-    DataMapping &lem = result.lineElements;
 
-    auto processElement = [&](Index i, FaceSet &visibleFaces) {
+    auto showType = [&](Byte t) -> bool {
+        switch (t) {
+        case UnstructuredGrid::POLYHEDRON:
+            return showpol;
+        case UnstructuredGrid::PYRAMID:
+            return showpyr;
+        case UnstructuredGrid::PRISM:
+            return showpri;
+        case UnstructuredGrid::TETRAHEDRON:
+            return showtet;
+        case UnstructuredGrid::HEXAHEDRON:
+            return showhex;
+        case UnstructuredGrid::TRIANGLE:
+            return showtri;
+        case UnstructuredGrid::QUAD:
+            return showqua;
+        }
+        return false;
+    };
+
+    auto processElement = [&](Index i, std::vector<Face> &faces) {
         const Index elStart = el[i], elEnd = el[i + 1];
         const Byte t = tl[i] & UnstructuredGrid::TYPE_MASK;
         if (t == UnstructuredGrid::POLYHEDRON) {
@@ -633,12 +665,7 @@ DomainSurface::Result<Polygons> DomainSurface::createSurface(vistle::Unstructure
                 } else if (cl[j] == term) {
                     Index numVert = j - facestart;
                     if (numVert >= 3) {
-                        auto face = &cl[facestart];
-                        auto it_ok = visibleFaces.emplace(i, faceNum, numVert, face);
-                        if (!it_ok.second) {
-                            // found duplicate, hence inner face: remove
-                            visibleFaces.erase(it_ok.first);
-                        }
+                        faces.emplace_back(i, faceNum, numVert, &cl[facestart]);
                     }
                     facestart = InvalidIndex;
                     ++faceNum;
@@ -646,46 +673,22 @@ DomainSurface::Result<Polygons> DomainSurface::createSurface(vistle::Unstructure
             }
         } else {
             const auto numFaces = UnstructuredGrid::NumFaces[t];
-            const auto &faces = UnstructuredGrid::FaceVertices[t];
+            const auto &cellFaces = UnstructuredGrid::FaceVertices[t];
             for (int f = 0; f < numFaces; ++f) {
-                const auto &face = faces[f];
-                const auto facesize = UnstructuredGrid::FaceSizes[t][f];
-                auto it_ok = visibleFaces.emplace(i, f, facesize, cl + elStart, face);
-                //std::cerr << "Face: " << *it_ok.first << std::endl;
-                if (!it_ok.second) {
-                    // found duplicate, hence inner face: remove
-                    visibleFaces.erase(it_ok.first);
-                }
+                faces.emplace_back(i, f, UnstructuredGrid::FaceSizes[t][f], cl + elStart, cellFaces[f]);
             }
         }
     };
 
-    std::vector<Index> currentCellFaces;
-    auto startCell = [&](Index i) {
-        currentCellFaces.clear();
-    };
-
-    auto finishCell = [&](Index i) {
-        if (currentCellFaces.size() <= 1) {
-            currentCellFaces.clear();
+    auto finishCell = [&](Index i, SurfaceChunk &out) {
+        if (out.cellFaces.size() <= 1) {
+            out.cellFaces.clear();
             return;
         }
 
-        struct Edge {
-            Edge(Index va, Index vb): v0(std::min(va, vb)), v1(std::max(va, vb)) {}
-            bool operator<(const Edge &o) const
-            {
-                if (v0 == o.v0)
-                    return v1 < o.v1;
-                return v0 < o.v0;
-            }
-
-            Index v0 = InvalidIndex, v1 = InvalidIndex;
-        };
-
-        std::map<Edge, unsigned int> edges;
-
-        for (auto f: currentCellFaces) {
+        auto &edges = out.edges;
+        edges.clear();
+        for (auto f: out.cellFaces) {
             auto elStart = el[i], elEnd = el[i + 1];
             Byte t = tl[i] & UnstructuredGrid::TYPE_MASK;
             switch (t) {
@@ -702,8 +705,7 @@ DomainSurface::Result<Polygons> DomainSurface::createSurface(vistle::Unstructure
                         if (faceNum == f && numVert >= 3) {
                             auto face = &cl[facestart];
                             for (unsigned j = 0; j < numVert; ++j) {
-                                Edge e(face[j], face[j + 1]);
-                                ++edges[e];
+                                edges.emplace_back(face[j], face[j + 1]);
                             }
                             break;
                         }
@@ -724,30 +726,33 @@ DomainSurface::Result<Polygons> DomainSurface::createSurface(vistle::Unstructure
                 const auto facesize = UnstructuredGrid::FaceSizes[t][f];
                 const auto &face = faces[f];
                 for (unsigned j = 0; j < facesize; ++j) {
-                    Edge e(verts[face[j]], verts[face[(j + 1) % facesize]]);
-                    ++edges[e];
+                    edges.emplace_back(verts[face[j]], verts[face[(j + 1) % facesize]]);
                 }
                 break;
             }
             }
         }
 
-        for (const auto &e: edges) {
-            if (e.second <= 1)
-                continue;
-            lcl.push_back(e.first.v0);
-            lcl.push_back(e.first.v1);
-            ll.push_back(lcl.size());
-            if (haveElementData) {
-                lem.emplace_back(i);
+        // edges shared by several boundary faces of the same cell are feature edges
+        std::sort(edges.begin(), edges.end());
+        for (auto it = edges.begin(); it != edges.end();) {
+            auto next = std::find_if(it + 1, edges.end(), [it](const Edge &e) { return !(e == *it); });
+            if (next - it > 1) {
+                out.lcl.push_back(it->v0);
+                out.lcl.push_back(it->v1);
+                out.ll.push_back(out.lcl.size());
+                if (haveElementData) {
+                    out.lem.emplace_back(i);
+                }
             }
+            it = next;
         }
 
-        currentCellFaces.clear();
+        out.cellFaces.clear();
     };
 
-    auto addFace = [&](Index i, Index f) {
-        currentCellFaces.push_back(f);
+    auto addFace = [&](Index i, Index f, SurfaceChunk &out) {
+        auto &pcl = out.pcl;
         auto elStart = el[i], elEnd = el[i + 1];
         Byte t = tl[i] & UnstructuredGrid::TYPE_MASK;
         switch (t) {
@@ -791,72 +796,113 @@ DomainSurface::Result<Polygons> DomainSurface::createSurface(vistle::Unstructure
             break;
         }
         }
-        pl.push_back(pcl.size());
+        out.pl.push_back(pcl.size());
         if (haveElementData) {
-            em.emplace_back(i);
+            out.em.emplace_back(i);
         }
     };
 
-    auto addToOutput = [&](const FaceSet &visibleFaces) mutable {
-        for (const auto &f: visibleFaces) {
-            const auto &i = f.elem;
-            if (i == InvalidIndex)
-                continue;
-
-            bool ghost = tl[i] & UnstructuredGrid::GHOST_BIT;
-            if (!showgho && ghost)
-                continue;
-
-            Byte t = tl[i] & UnstructuredGrid::TYPE_MASK;
-            bool show = true;
-            switch (t) {
-            case UnstructuredGrid::POLYHEDRON:
-                show = showpol;
-                break;
-            case UnstructuredGrid::PYRAMID:
-                show = showpyr;
-                break;
-            case UnstructuredGrid::PRISM:
-                show = showpri;
-                break;
-            case UnstructuredGrid::TETRAHEDRON:
-                show = showtet;
-                break;
-            case UnstructuredGrid::HEXAHEDRON:
-                show = showhex;
-                break;
-            case UnstructuredGrid::TRIANGLE:
-                show = showtri;
-                break;
-            case UnstructuredGrid::QUAD:
-                show = showqua;
-                break;
+    std::vector<SurfaceChunk> chunks;
+    if (!useVertexOwners) {
+        // collect all faces, sort them by their vertices and keep those without a partner
+        const Index numElemChunks = (num_elem + ChunkSize - 1) / ChunkSize;
+        std::vector<std::vector<Face>> elemFaces(numElemChunks);
+#pragma omp parallel for schedule(dynamic)
+        for (ssize_t c = 0; c < ssize_t(numElemChunks); ++c) {
+            const Index end = std::min(num_elem, Index((c + 1) * ChunkSize));
+            for (Index i = c * ChunkSize; i < end; ++i) {
+                processElement(i, elemFaces[c]);
             }
-            if (!show)
-                continue;
+        }
 
-            addFace(i, f.face);
+        std::vector<Face> faces;
+        {
+            std::vector<size_t> off(numElemChunks + 1, 0);
+            for (Index c = 0; c < numElemChunks; ++c)
+                off[c + 1] = off[c] + elemFaces[c].size();
+            faces.resize(off[numElemChunks]);
+#pragma omp parallel for schedule(dynamic)
+            for (ssize_t c = 0; c < ssize_t(numElemChunks); ++c) {
+                std::copy(elemFaces[c].begin(), elemFaces[c].end(), faces.begin() + off[c]);
+                std::vector<Face>().swap(elemFaces[c]);
+            }
         }
-    };
+        parallelSort(faces, [](const Face &a, const Face &b) {
+            if (a < b)
+                return true;
+            if (b < a)
+                return false;
+            return a.elem < b.elem || (a.elem == b.elem && a.face < b.face);
+        });
+
+        // a face occurring an odd number of times is on the boundary, as it has no partner in the end
+        const size_t numFaces = faces.size();
+        const size_t numFaceChunks = (numFaces + ChunkSize - 1) / ChunkSize;
+        std::vector<std::vector<Face>> boundaryFaces(numFaceChunks);
+#pragma omp parallel for schedule(dynamic)
+        for (ssize_t c = 0; c < ssize_t(numFaceChunks); ++c) {
+            size_t begin = c * ChunkSize;
+            const size_t end = std::min(numFaces, size_t((c + 1) * ChunkSize));
+            // runs starting in the previous chunk are handled there
+            while (begin > 0 && begin < end && faces[begin] == faces[begin - 1])
+                ++begin;
+            while (begin < end) {
+                size_t next = begin + 1;
+                while (next < numFaces && faces[next] == faces[begin])
+                    ++next;
+                if ((next - begin) % 2 == 1)
+                    boundaryFaces[c].push_back(faces[next - 1]);
+                begin = next;
+            }
+        }
+        std::vector<Face>().swap(faces);
 
-    if (!useVertexOwners) {
-        FaceSet visibleFaces;
-        for (Index i = 0; i < num_elem; ++i) {
-            processElement(i, visibleFaces);
+        std::vector<Face> boundary;
+        for (auto &bf: boundaryFaces) {
+            std::copy(bf.begin(), bf.end(), std::back_inserter(boundary));
+            std::vector<Face>().swap(bf);
+        }
+        parallelSort(boundary, [](const Face &a, const Face &b) {
+            return a.elem < b.elem || (a.elem == b.elem && a.face < b.face);
+        });
+
+        const size_t numBoundary = boundary.size();
+        chunks.resize((numBoundary + ChunkSize - 1) / ChunkSize);
+#pragma omp parallel for schedule(dynamic)
+        for (ssize_t c = 0; c < ssize_t(chunks.size()); ++c) {
+            const size_t end = std::min(numBoundary, size_t((c + 1) * ChunkSize));
+            for (size_t b = c * ChunkSize; b < end; ++b) {
+                const auto &f = boundary[b];
+                const auto &i = f.elem;
+                if (i == InvalidIndex)
+                    continue;
+
+                bool ghost = tl[i] & UnstructuredGrid::GHOST_BIT;
+                if (!showgho && ghost)
+                    continue;
+                if (!showType(tl[i] & UnstructuredGrid::TYPE_MASK))
+                    continue;
+
+                addFace(i, f.face, chunks[c]);
+            }
         }
-        addToOutput(visibleFaces);
     } else {
-        UnstructuredGrid::VertexOwnerList::const_ptr vol = m_grid_in->getVertexOwnerList();
-        auto nf = m_grid_in->getNeighborFinder();
-        for (Index i = 0; i < num_elem; ++i) {
-            const Index elStart = el[i], elEnd = el[i + 1];
-            bool ghost = tl[i] & UnstructuredGrid::GHOST_BIT;
-            if (!showgho && ghost)
-                continue;
-            startCell(i);
-            Byte t = tl[i] & UnstructuredGrid::TYPE_MASK;
-            if (t == UnstructuredGrid::POLYHEDRON) {
-                if (showpol) {
+        // boundary faces have no neighbor element, cells are handled independently in chunks
+        const auto &nf = m_grid_in->getNeighborFinder();
+        chunks.resize((num_elem + ChunkSize - 1) / ChunkSize);
+#pragma omp parallel for schedule(dynamic)
+        for (ssize_t c = 0; c < ssize_t(chunks.size()); ++c) {
+            auto &chunk = chunks[c];
+            const Index end = std::min(num_elem, Index((c + 1) * ChunkSize));
+            for (Index i = c * ChunkSize; i < end; ++i) {
+                const Index elStart = el[i], elEnd = el[i + 1];
+                bool ghost = tl[i] & UnstructuredGrid::GHOST_BIT;
+                if (!showgho && ghost)
+                    continue;
+                Byte t = tl[i] & UnstructuredGrid::TYPE_MASK;
+                if (!showType(t))
+                    continue;
+                if (t == UnstructuredGrid::POLYHEDRON) {
                     Index faceNum = 0;
                     Index facestart = InvalidIndex;
                     Index term = 0;
@@ -870,40 +916,15 @@ DomainSurface::Result<Polygons> DomainSurface::createSurface(vistle::Unstructure
                                 auto face = &cl[facestart];
                                 Index neighbour = nf.getNeighborElement(i, face[0], face[1], face[2]);
                                 if (neighbour == InvalidIndex) {
-                                    addFace(i, faceNum);
+                                    chunk.cellFaces.push_back(faceNum);
+                                    addFace(i, faceNum, chunk);
                                 }
                             }
                             facestart = InvalidIndex;
                             ++faceNum;
                         }
                     }
-                }
-            } else {
-                bool show = false;
-                switch (t) {
-                case UnstructuredGrid::PYRAMID:
-                    show = showpyr;
-                    break;
-                case UnstructuredGrid::PRISM:
-                    show = showpri;
-                    break;
-                case UnstructuredGrid::TETRAHEDRON:
-                    show = showtet;
-                    break;
-                case UnstructuredGrid::HEXAHEDRON:
-                    show = showhex;
-                    break;
-                case UnstructuredGrid::TRIANGLE:
-                    show = showtri;
-                    break;
-                case UnstructuredGrid::QUAD:
-                    show = showqua;
-                    break;
-                default:
-                    break;
-                }
-
-                if (show) {
+                } else {
                     const auto numFaces = UnstructuredGrid::NumFaces[t];
                     const auto &faces = UnstructuredGrid::FaceVertices[t];
                     for (int f = 0; f < numFaces; ++f) {
@@ -913,15 +934,28 @@ DomainSurface::Result<Polygons> DomainSurface::createSurface(vistle::Unstructure
                             neighbour = nf.getNeighborElement(i, cl[elStart + face[0]], cl[elStart + face[1]],
                                                               cl[elStart + face[2]]);
                         if (UnstructuredGrid::Dimensionality[t] == 2 || neighbour == InvalidIndex) {
-                            addFace(i, f);
+                            chunk.cellFaces.push_back(f);
+                            addFace(i, f, chunk);
                         }
                     }
                 }
+                if (createLines)
+                    finishCell(i, chunk);
+                else
+                    chunk.cellFaces.clear();
             }
-            finishCell(i);
         }
     }
 
+    if (createSurface) {
+        appendChunks(chunks, &SurfaceChunk::pcl, &SurfaceChunk::pl, &SurfaceChunk::em, m_grid_out->cl(),
+                     m_grid_out->el(), result.surfaceElements);
+    }
+    if (createLines) {
+        appendChunks(chunks, &SurfaceChunk::lcl, &SurfaceChunk::ll, &SurfaceChunk::lem, result.lines->cl(),
+                     result.lines->el(), result.lineElements);
+    }
+
     if (m_grid_out->getNumElements() == 0 || !createSurface) {
         result.surface.reset();
     }
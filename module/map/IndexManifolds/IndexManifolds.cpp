@@ -1,5 +1,6 @@
 #include <sstream>
 #include <iomanip>
+#include <vector>
 
 #include <vistle/core/object.h>
 #include <vistle/core/structuredgridbase.h>
@@ -149,6 +150,8 @@ bool IndexManifolds::compute(std::shared_ptr<BlockTask> task) const
             outdata->setSize(elementData ? nquad : nvert);
             outdata->setMapping(elementData ? DataBase::Element : DataBase::Vertex);
 
+            std::vector<Index> from;
+            from.reserve(elementData ? nquad : nvert);
             Index cc[3]{c[0], c[1], c[2]};
             cc[dir1] = bghost[dir1];
             Index vv = 0;
@@ -159,12 +162,11 @@ bool IndexManifolds::compute(std::shared_ptr<BlockTask> task) const
                     Index v = StructuredGridBase::vertexIndex(cc[0], cc[1], cc[2], dims);
                     if (elementData) {
                         if (i + 1 < nvert1 && j + 1 < nvert2) {
-                            Index c = StructuredGridBase::cellIndex(cc[0], cc[1], cc[2], dims);
-                            outdata->copyEntry(cell, data, c);
+                            from.push_back(StructuredGridBase::cellIndex(cc[0], cc[1], cc[2], dims));
                             ++cell;
                         }
                     } else {
-                        outdata->copyEntry(vv, data, v);
+                        from.push_back(v);
                     }
 
                     ++vv;
@@ -174,6 +176,7 @@ bool IndexManifolds::compute(std::shared_ptr<BlockTask> task) const
             }
             assert(vv == nvert);
             assert(cell == 0 || cell == nquad);
+            outdata->copyEntries(from.size(), nullptr, data, from.data());
 
             updateMeta(outdata);
             task->addObject(p_surface_out, outdata);
@@ -199,6 +202,7 @@ bool IndexManifolds::compute(std::shared_ptr<BlockTask> task) const
             outdata->copyAttributes(data);
         }
 
+        std::vector<Index> to, from;
         Index cell = 0;
         Index cc[3]{c[0], c[1], c[2]};
         cc[dir] = bghost[dir];
@@ -212,12 +216,13 @@ bool IndexManifolds::compute(std::shared_ptr<BlockTask> task) const
             if (outdata) {
                 if (elementData) {
                     if (i + 1 < nvert) {
-                        Index c = StructuredGridBase::cellIndex(cc[0], cc[1], cc[2], dims);
-                        outdata->copyEntry(cell, data, c);
+                        to.push_back(cell);
+                        from.push_back(StructuredGridBase::cellIndex(cc[0], cc[1], cc[2], dims));
                         ++cell;
                     }
                 } else {
-                    outdata->copyEntry(cc[dir], data, v);
+                    to.push_back(cc[dir]);
+                    from.push_back(v);
                 }
             }
             line->cl()[i] = i;
@@ -225,6 +230,7 @@ bool IndexManifolds::compute(std::shared_ptr<BlockTask> task) const
             ++cc[dir];
         }
         if (outdata) {
+            outdata->copyEntries(from.size(), to.data(), data, from.data());
             updateMeta(outdata);
             task->addObject(p_line_out, outdata);
         } else {
@@ -0,0 +1,50 @@
+#include "BrickIndex.h"
+
+using namespace vistle;
+
+BrickIndex::BrickIndex(const Index dims[3])
+{
+    for (int c = 0; c < 3; ++c) {
+        m_dims[c] = dims[c];
+        const Index ncell = dims[c] > 1 ? dims[c] - 1 : 0;
+        m_bricks[c] = (ncell + BrickSize - 1) / BrickSize;
+    }
+    m_min = ShmVector<Scalar>::create(numBricks(), std::numeric_limits<Scalar>::max());
+    m_max = ShmVector<Scalar>::create(numBricks(), std::numeric_limits<Scalar>::lowest());
+}
+
+Index BrickIndex::numBricks() const
+{
+    return m_bricks[0] * m_bricks[1] * m_bricks[2];
+}
+
+void BrickIndex::brickCells(Index brick, Index begin[3], Index end[3]) const
+{
+    auto b = StructuredGridBase::vertexCoordinates(brick, m_bricks);
+    for (int c = 0; c < 3; ++c) {
+        begin[c] = b[c] * BrickSize;
+        end[c] = std::min(begin[c] + BrickSize, m_dims[c] - 1);
+    }
+}
+
+std::vector<Index> BrickIndex::activeBricks(Scalar isoValue) const
+{
+    std::vector<Index> active;
+    const Index n = numBricks();
+    for (Index brick = 0; brick < n; ++brick) {
+        if (mayContain(brick, isoValue))
+            active.push_back(brick);
+    }
+    return active;
+}
+
+std::pair<Scalar, Scalar> BrickIndex::range() const
+{
+    Scalar min = std::numeric_limits<Scalar>::max();
+    Scalar max = std::numeric_limits<Scalar>::lowest();
+    for (Index brick = 0; brick < numBricks(); ++brick) {
+        min = std::min(min, (*m_min)[brick]);
+        max = std::max(max, (*m_max)[brick]);
+    }
+    return std::make_pair(min, max);
+}
@@ -0,0 +1,75 @@
+#ifndef ISOSURFACE_BRICKINDEX_H
+#define ISOSURFACE_BRICKINDEX_H
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <vistle/core/index.h>
+#include <vistle/core/scalar.h>
+#include <vistle/core/shmvector.h>
+#include <vistle/core/structuredgridbase.h>
+
+#ifdef CUTTINGSURFACE
+#define BrickIndex CutBrickIndex
+#elif defined(ISOHEIGHTSURFACE)
+#define BrickIndex IsoHeightBrickIndex
+#else
+#define BrickIndex IsoBrickIndex
+#endif
+
+//! minimum and maximum of the iso-field for bricks of cells of a structured grid
+/*! bricks not straddling the iso-value cannot contain any part of the surface and are skipped */
+class BrickIndex {
+public:
+    static const vistle::Index BrickSize = 8; //< number of cells per brick in each dimension
+
+    explicit BrickIndex(const vistle::Index dims[3]);
+
+    //! compute per-brick extrema from func(vertex index)
+    template<class Func>
+    void build(Func func);
+
+    vistle::Index numBricks() const;
+    //! range of cells covered by brick, end is exclusive
+    void brickCells(vistle::Index brick, vistle::Index begin[3], vistle::Index end[3]) const;
+    //! whether cells within brick may have vertices on both sides of isoValue
+    bool mayContain(vistle::Index brick, vistle::Scalar isoValue) const
+    {
+        return (*m_min)[brick] <= isoValue && (*m_max)[brick] > isoValue;
+    }
+    std::vector<vistle::Index> activeBricks(vistle::Scalar isoValue) const;
+    std::pair<vistle::Scalar, vistle::Scalar> range() const;
+
+private:
+    vistle::Index m_dims[3];
+    vistle::Index m_bricks[3];
+    vistle::ShmVector<vistle::Scalar> m_min, m_max;
+};
+
+template<class Func>
+void BrickIndex::build(Func func)
+{
+    const vistle::Index n = numBricks();
+#pragma omp parallel for schedule(dynamic)
+    for (ssize_t brick = 0; brick < ssize_t(n); ++brick) {
+        vistle::Index begin[3], end[3];
+        brickCells(brick, begin, end);
+        vistle::Scalar bmin = std::numeric_limits<vistle::Scalar>::max();
+        vistle::Scalar bmax = std::numeric_limits<vistle::Scalar>::lowest();
+        for (vistle::Index i = begin[0]; i <= end[0]; ++i) {
+            for (vistle::Index j = begin[1]; j <= end[1]; ++j) {
+                for (vistle::Index k = begin[2]; k <= end[2]; ++k) {
+                    const vistle::Scalar v = func(vistle::StructuredGridBase::vertexIndex(i, j, k, m_dims));
+                    bmin = std::min(bmin, v);
+                    bmax = std::max(bmax, v);
+                }
+            }
+        }
+        (*m_min)[brick] = bmin;
+        (*m_max)[brick] = bmax;
+    }
+}
+
+#endif
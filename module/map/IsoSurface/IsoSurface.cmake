@@ -3,7 +3,9 @@ use_openmp()
 set(PREFER_TBB TRUE)
 set(USE_TBB FALSE)
 
-set(SOURCES ${SOURCES} ../IsoSurface/IsoSurface.cpp ../IsoSurface/IsoSurface.h ../IsoSurface/IsoDataFunctor.cpp ../IsoSurface/IsoDataFunctor.h)
+set(SOURCES ${SOURCES} ../IsoSurface/IsoSurface.cpp ../IsoSurface/IsoSurface.h ../IsoSurface/IsoDataFunctor.cpp ../IsoSurface/IsoDataFunctor.h
+    ../IsoSurface/BrickIndex.cpp ../IsoSurface/BrickIndex.h ../IsoSurface/LevellerStructured.cpp
+    ../IsoSurface/SpanIndex.cpp ../IsoSurface/SpanIndex.h)
 set(CUDA_OBJ "")
 #vistle_find_package(CUDA)
 if(NOT APPLE
@@ -82,6 +82,10 @@ IsoSurface::IsoSurface(const std::string &name, int moduleID, mpi::communicator
 #ifdef CUTTINGSURFACE
     addResultCache(m_gridCache);
 #endif
+    m_brickIndexCache.setPersistent(true);
+    addResultCache(m_brickIndexCache);
+    m_spanIndexCache.setPersistent(true);
+    addResultCache(m_spanIndexCache);
 }
 
 IsoSurface::~IsoSurface() = default;
@@ -233,12 +237,25 @@ Object::ptr IsoSurface::work(vistle::Object::const_ptr grid, vistle::Vec<vistle:
 #ifdef CUTTINGSURFACE
     CachedResult cachedResult;
     auto cacheEntry = m_gridCache.getOrLock(grid->getName(), cachedResult);
-    if (!cacheEntry) {
-        l.setCandidateCells(cachedResult.candidateCells.get());
-    }
 #else
     l.setIsoData(dataS);
 #endif
+    const std::string indexKey = l.indexKey();
+    if (!indexKey.empty() && Leveller::hasNativePath(grid)) {
+        std::shared_ptr<const BrickIndex> brickIndex;
+        if (auto entry = m_brickIndexCache.getOrLock(indexKey, brickIndex)) {
+            brickIndex = l.createBrickIndex();
+            m_brickIndexCache.storeAndUnlock(entry, brickIndex);
+        }
+        l.setBrickIndex(brickIndex);
+    } else if (!indexKey.empty()) {
+        std::shared_ptr<const SpanIndex> spanIndex;
+        if (auto entry = m_spanIndexCache.getOrLock(indexKey, spanIndex)) {
+            spanIndex = l.createSpanIndex();
+            m_spanIndexCache.storeAndUnlock(entry, spanIndex);
+        }
+        l.setSpanIndex(spanIndex);
+    }
     if (mapdata) {
         l.addMappedData(mapdata);
     }
@@ -280,7 +297,6 @@ Object::ptr IsoSurface::work(vistle::Object::const_ptr grid, vistle::Vec<vistle:
 #ifdef CUTTINGSURFACE
     if (cacheEntry) {
         cachedResult.grid = result;
-        cachedResult.candidateCells.reset(l.candidateCells());
         m_gridCache.storeAndUnlock(cacheEntry, cachedResult);
     }
     result = cachedResult.grid;
@@ -5,10 +5,10 @@
 #include <vistle/core/vec.h>
 #include <vistle/core/unstr.h>
 #include "IsoDataFunctor.h"
+#include "BrickIndex.h"
+#include "SpanIndex.h"
 
-#ifdef CUTTINGSURFACE
 #include <vistle/module/resultcache.h>
-#endif
 
 class IsoSurface: public vistle::Module {
 public:
@@ -71,9 +71,13 @@ private:
 
     IsoController isocontrol;
 
+    // indices are kept across executions, so that changing the iso-value only has to visit active cells,
+    // persistent result caches drop entries that were not accessed during the previous execution
+    mutable vistle::ResultCache<std::shared_ptr<const BrickIndex>> m_brickIndexCache;
+    mutable vistle::ResultCache<std::shared_ptr<const SpanIndex>> m_spanIndexCache;
+
 #ifdef CUTTINGSURFACE
     struct CachedResult {
-        std::shared_ptr<const std::vector<vistle::Index>> candidateCells;
         vistle::Coords::ptr grid;
     };
     mutable vistle::ResultCache<CachedResult> m_gridCache;
@@ -32,6 +32,16 @@ using namespace vistle;
 const int MaxNumData = 6;
 const Scalar EPSILON(1e-10);
 
+//! constant by which the iso-function differs from the function a span index is built for
+static Scalar spanIndexOffset(IsoDataFunctor &func)
+{
+#ifdef CUTTINGSURFACE
+    if (func.m_option == Plane)
+        return func.m_sign * func.m_distance;
+#endif
+    return 0;
+}
+
 
 struct HostData {
 
@@ -1162,6 +1172,10 @@ bool Leveller::process() {
        IsoDataFunctor isofunc = m_isocontrol.newFunc(m_grid->getTransform(), &dataobj->x()[0]);
 #endif
 
+       if (hasNativePath(m_grid)) {
+           return processStructured(isofunc, dims, coords);
+       }
+
        std::unique_ptr<HostData> HD_ptr;
        if (m_unstr) {
            HD_ptr = std::make_unique<HostData>(m_isoValue, isofunc, m_unstr->el(), m_unstr->tl(), m_unstr->cl(),
@@ -1195,12 +1209,10 @@ bool Leveller::process() {
            HD.setGhostLayers(ghost);
        }
          HD.setComputeNormals(m_computeNormals);
-#ifdef CUTTINGSURFACE
-         if (m_candidateCells) {
-             HD.m_SelectedCellVector = *m_candidateCells;
+         if (m_spanIndex) {
+             HD.m_SelectedCellVector = m_spanIndex->activeCells(m_isoValue - spanIndexOffset(isofunc));
              HD.m_SelectedCellVectorValid = true;
          }
-#endif
 
          for (size_t i=0; i<m_vertexdata.size(); ++i) {
             if(Vec<Scalar,1>::const_ptr Scal = Vec<Scalar,1>::as(m_vertexdata[i])){
@@ -1353,11 +1365,6 @@ bool Leveller::process() {
              }
          }
 
-#ifdef CUTTINGSURFACE
-         if (!m_candidateCells && HD.m_SelectedCellVectorValid) {
-             m_candidateCells = new std::vector<vistle::Index>(HD.m_SelectedCellVector);
-         }
-#endif
          break;
       }
 
@@ -1481,14 +1488,84 @@ std::pair<Scalar, Scalar> Leveller::range() {
    return std::make_pair(gmin, gmax);
 }
 
+IsoDataFunctor Leveller::coordsFunc() const
+{
 #ifdef CUTTINGSURFACE
-const std::vector<Index> *Leveller::candidateCells()
+    return m_isocontrol.newFunc(m_grid->getTransform(), &m_coord->x()[0], &m_coord->y()[0], &m_coord->z()[0]);
+#else
+    return m_isocontrol.newFunc(m_grid->getTransform(), &m_data->x()[0]);
+#endif
+}
+
+std::string Leveller::indexKey() const
 {
-    return m_candidateCells;
+#if defined(CUTTINGSURFACE)
+    if (!m_unstr && !m_poly && !m_tri && !m_quad)
+        return std::string();
+    // moving a plane only shifts the iso-function by a constant, so the index depends only on its orientation
+    IsoDataFunctor func = coordsFunc();
+    if (func.m_option != Plane)
+        return std::string();
+    std::stringstream str;
+    str << std::hexfloat << m_grid->getName() << " " << func.m_sign << " " << func.m_vertex[0] << " "
+        << func.m_vertex[1] << " " << func.m_vertex[2];
+    return str.str();
+#elif defined(ISOHEIGHTSURFACE)
+    // height data is generated anew for every execution
+    return std::string();
+#else
+    return m_data ? m_data->getName() : std::string();
+#endif
 }
 
-void Leveller::setCandidateCells(const std::vector<Index> *candidateCells)
+std::shared_ptr<const SpanIndex> Leveller::createSpanIndex() const
 {
-    m_candidateCells = candidateCells;
+    IsoDataFunctor func = coordsFunc();
+    const Scalar offset = spanIndexOffset(func);
+
+    const Index *el = nullptr, *cl = nullptr;
+    const Byte *tl = nullptr;
+    Index nelem = 0, nvert = 0;
+    if (m_unstr) {
+        nelem = m_unstr->getNumElements();
+        el = m_unstr->el();
+        cl = m_unstr->cl();
+        tl = m_unstr->tl();
+    } else if (m_poly) {
+        nelem = m_poly->getNumElements();
+        el = m_poly->el();
+        cl = m_poly->cl();
+    } else if (m_tri) {
+        nelem = m_tri->getNumElements();
+        cl = m_tri->getNumCorners() > 0 ? m_tri->cl() : nullptr;
+        nvert = 3;
+    } else if (m_quad) {
+        nelem = m_quad->getNumElements();
+        cl = m_quad->getNumCorners() > 0 ? m_quad->cl() : nullptr;
+        nvert = 4;
+    } else {
+        return std::shared_ptr<const SpanIndex>();
+    }
+
+    std::vector<Scalar> cellMin(nelem, std::numeric_limits<Scalar>::max());
+    std::vector<Scalar> cellMax(nelem, std::numeric_limits<Scalar>::lowest());
+#pragma omp parallel for
+    for (ssize_t elem = 0; elem < ssize_t(nelem); ++elem) {
+        if (tl && (tl[elem] & UnstructuredGrid::GHOST_BIT))
+            continue;
+        const Index begin = el ? el[elem] : elem * nvert, end = el ? el[elem + 1] : begin + nvert;
+        Scalar &emin = cellMin[elem], &emax = cellMax[elem];
+        for (Index i = begin; i < end; ++i) {
+            const Scalar v = func(cl ? cl[i] : i) - offset;
+            emin = std::min(emin, v);
+            emax = std::max(emax, v);
+        }
+    }
+
+    return std::make_shared<SpanIndex>(cellMin, cellMax);
+}
+
+void Leveller::setSpanIndex(std::shared_ptr<const SpanIndex> index)
+{
+    m_spanIndex = index;
 }
-#endif
@@ -25,6 +25,11 @@
 #endif
 
 #include "IsoDataFunctor.h"
+#include "BrickIndex.h"
+#include "SpanIndex.h"
+
+#include <memory>
+#include <string>
 
 DEFINE_ENUM_WITH_STRING_CONVERSIONS(ThrustBackend, (Host)(Device))
 
@@ -41,9 +46,7 @@ class Leveller {
     vistle::Quads::const_ptr m_quad;
     vistle::Triangles::const_ptr m_tri;
     vistle::Coords::const_ptr m_coord;
-#ifdef CUTTINGSURFACE
-    const std::vector<vistle::Index> *m_candidateCells = nullptr;
-#else
+#ifndef CUTTINGSURFACE
     vistle::Vec<vistle::Scalar>::const_ptr m_data;
 #endif
     std::vector<vistle::Object::const_ptr> m_vertexdata;
@@ -58,23 +61,36 @@ class Leveller {
     vistle::Scalar gmin, gmax;
     vistle::Matrix4 m_objectTransform;
     bool m_computeNormals;
+    std::shared_ptr<const BrickIndex> m_brickIndex;
+    std::shared_ptr<const SpanIndex> m_spanIndex;
 
     template<class Data, class pol>
     vistle::Index calculateSurface(Data &data);
+    IsoDataFunctor coordsFunc() const; //< iso-function for grids with explicit coordinates
+    bool processStructured(IsoDataFunctor isofunc, const vistle::Index dims[3], const vistle::Scalar *const coords[3]);
 
 public:
     Leveller(const IsoController &isocontrol, vistle::Object::const_ptr grid, const vistle::Scalar isovalue,
              vistle::Index processortype);
+    //! whether grid is handled by native marching cubes instead of Thrust
+    static bool hasNativePath(vistle::Object::const_ptr grid);
     void setComputeNormals(bool value);
+    //! reuse per-brick extrema of iso-field for skipping empty regions on structured grids
+    void setBrickIndex(std::shared_ptr<const BrickIndex> index);
     void addMappedData(vistle::DataBase::const_ptr mapobj);
 
     bool process();
-#ifdef CUTTINGSURFACE
-    void setCandidateCells(const std::vector<vistle::Index> *candidateCells);
-    const std::vector<vistle::Index> *candidateCells();
-#else
+#ifndef CUTTINGSURFACE
     void setIsoData(vistle::Vec<vistle::Scalar>::const_ptr obj);
 #endif
+    //! key under which a span or brick index for the current grid and iso-function can be cached, empty if not applicable
+    std::string indexKey() const;
+    //! build per-brick extrema of the iso-field for grids handled natively
+    std::shared_ptr<const BrickIndex> createBrickIndex() const;
+    //! build span index of per-cell extrema of the iso-function for grids not handled natively
+    std::shared_ptr<const SpanIndex> createSpanIndex() const;
+    //! visit only active cells found in index instead of classifying all cells
+    void setSpanIndex(std::shared_ptr<const SpanIndex> index);
     vistle::Coords::ptr result();
     vistle::Normals::ptr normresult();
     vistle::DataBase::ptr mapresult() const;
@@ -0,0 +1,292 @@
+//
+// native marching cubes for uniform, rectilinear and structured grids,
+// used for both CuttingSurface and IsoSurface
+//
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <vistle/core/vecdispatch.h>
+#include <vistle/core/normals.h>
+#include <vistle/util/math.h>
+
+#define ONLY_HEXAHEDRON
+#include "tables.h"
+
+#include "Leveller.h"
+#include "BrickIndex.h"
+
+using namespace vistle;
+
+namespace {
+
+const Scalar EPSILON(1e-10);
+
+//! interpolate per-vertex or copy per-cell data of any type into the output
+struct MappedField {
+    virtual ~MappedField() = default;
+    virtual void lerpVertex(Index out, Index v1, Index v2, Scalar t) = 0;
+    virtual void copyCell(Index out, Index cell) = 0;
+    DataBase::ptr result;
+};
+
+template<class V>
+struct TypedMappedField: public MappedField {
+    static const unsigned Dim = V::Dimension;
+    typedef typename V::Scalar T;
+
+    TypedMappedField(typename V::const_ptr input, Index size, DataBase::Mapping mapping)
+    {
+        typename V::ptr out(new V(size));
+        for (unsigned c = 0; c < Dim; ++c) {
+            m_in[c] = input->x(c);
+            m_out[c] = out->x(c).data();
+        }
+        out->setMeta(input->meta());
+        out->setMapping(mapping);
+        result = out;
+    }
+
+    void lerpVertex(Index out, Index v1, Index v2, Scalar t) override
+    {
+        for (unsigned c = 0; c < Dim; ++c) {
+            if constexpr (std::is_floating_point<T>::value)
+                m_out[c][out] = lerp(m_in[c][v1], m_in[c][v2], t);
+            else
+                m_out[c][out] = t > 0.5 ? m_in[c][v2] : m_in[c][v1];
+        }
+    }
+
+    void copyCell(Index out, Index cell) override
+    {
+        for (unsigned c = 0; c < Dim; ++c)
+            m_out[c][out] = m_in[c][cell];
+    }
+
+private:
+    const T *m_in[Dim];
+    T *m_out[Dim];
+};
+
+std::unique_ptr<MappedField> createMappedField(Object::const_ptr obj, Index size, DataBase::Mapping mapping)
+{
+    std::unique_ptr<MappedField> field;
+    visitVec(DataBase::as(obj), [&](auto in) {
+        typedef typename std::decay<decltype(*in)>::type V;
+        field.reset(new TypedMappedField<V>(in, size, mapping));
+    });
+    return field;
+}
+
+//! cells of a brick intersected by the surface together with their marching cubes case
+struct ActiveCells {
+    std::vector<Index> vertex; //< vertex with smallest indices of cell
+    std::vector<unsigned char> caseNum;
+    Index numVertices = 0;
+};
+
+} // namespace
+
+bool Leveller::hasNativePath(vistle::Object::const_ptr grid)
+{
+    if (!UniformGrid::as(grid) && !RectilinearGrid::as(grid) && !StructuredGrid::as(grid))
+        return false;
+    auto str = StructuredGridBase::as(grid);
+    Index dims[3];
+    for (int c = 0; c < 3; ++c)
+        dims[c] = str->getNumDivisions(c);
+    return StructuredGridBase::dimensionality(dims) == 3;
+}
+
+void Leveller::setBrickIndex(std::shared_ptr<const BrickIndex> index)
+{
+    m_brickIndex = index;
+}
+
+std::shared_ptr<const BrickIndex> Leveller::createBrickIndex() const
+{
+#ifdef CUTTINGSURFACE
+    // brick extrema change with the cutting geometry, they are computed when processing
+    return std::shared_ptr<const BrickIndex>();
+#else
+    Index dims[3];
+    for (int c = 0; c < 3; ++c)
+        dims[c] = m_strbase->getNumDivisions(c);
+    auto index = std::make_shared<BrickIndex>(dims);
+    const Scalar *x = &m_data->x()[0];
+    index->build([x](Index v) { return x[v]; });
+    return index;
+#endif
+}
+
+bool Leveller::processStructured(IsoDataFunctor isofunc, const Index dims[3], const Scalar *const coords[3])
+{
+    const auto &H = StructuredGridBase::HexahedronIndices;
+    const Scalar isoValue = m_isoValue;
+    const bool vertexCoords = m_str != nullptr;
+    const bool computeNormals = m_computeNormals;
+
+    // cells within ghost layers do not contribute
+    Index cellBegin[3], cellEnd[3];
+    for (int c = 0; c < 3; ++c) {
+        cellBegin[c] = m_strbase->getNumGhostLayers(c, StructuredGridBase::Bottom);
+        const Index top = m_strbase->getNumGhostLayers(c, StructuredGridBase::Top);
+        cellEnd[c] = dims[c] > top + 1 ? dims[c] - 1 - top : 0;
+    }
+
+    // offsets of cell corners relative to the vertex with smallest indices
+    Index corner[8];
+    for (int i = 0; i < 8; ++i)
+        corner[i] = StructuredGridBase::vertexIndex(H[0][i], H[1][i], H[2][i], dims);
+
+    std::shared_ptr<const BrickIndex> bricks = m_brickIndex;
+    if (!bricks) {
+        auto index = std::make_shared<BrickIndex>(dims);
+        index->build(isofunc);
+        bricks = index;
+    }
+    const std::vector<Index> active = bricks->activeBricks(isoValue);
+    const ssize_t numActive = active.size();
+
+    // classify cells within bricks that may be intersected
+    std::vector<ActiveCells> activeCells(numActive);
+#pragma omp parallel for schedule(dynamic)
+    for (ssize_t b = 0; b < numActive; ++b) {
+        Index begin[3], end[3];
+        bricks->brickCells(active[b], begin, end);
+        for (int c = 0; c < 3; ++c) {
+            begin[c] = std::max(begin[c], cellBegin[c]);
+            end[c] = std::min(end[c], cellEnd[c]);
+        }
+
+        auto &cells = activeCells[b];
+        for (Index i = begin[0]; i < end[0]; ++i) {
+            for (Index j = begin[1]; j < end[1]; ++j) {
+                for (Index k = begin[2]; k < end[2]; ++k) {
+                    const Index v = StructuredGridBase::vertexIndex(i, j, k, dims);
+                    unsigned caseNum = 0;
+                    for (int idx = 0; idx < 8; ++idx) {
+                        if (isofunc(v + corner[idx]) > isoValue)
+                            caseNum |= 1 << idx;
+                    }
+                    const Index numVert = hexaNumVertsTable[caseNum];
+                    if (numVert == 0)
+                        continue;
+                    cells.vertex.push_back(v);
+                    cells.caseNum.push_back(caseNum);
+                    cells.numVertices += numVert;
+                }
+            }
+        }
+    }
+
+    std::vector<Index> location(numActive + 1);
+    location[0] = 0;
+    for (ssize_t b = 0; b < numActive; ++b)
+        location[b + 1] = location[b] + activeCells[b].numVertices;
+    const Index numVertices = location[numActive];
+
+    // allocate output in place, so that triangles can be written without staging
+    m_triangles->x().resize(numVertices);
+    m_triangles->y().resize(numVertices);
+    m_triangles->z().resize(numVertices);
+    Scalar *out[3] = {m_triangles->x().data(), m_triangles->y().data(), m_triangles->z().data()};
+    Scalar *outNormal[3] = {nullptr, nullptr, nullptr};
+    if (computeNormals) {
+        m_normals.reset(new Normals(numVertices));
+        m_normals->setMapping(DataBase::Vertex);
+        for (int c = 0; c < 3; ++c)
+            outNormal[c] = m_normals->x(c).data();
+    }
+    std::vector<std::unique_ptr<MappedField>> vertFields, cellFields;
+    for (auto &obj: m_vertexdata) {
+        if (auto f = createMappedField(obj, numVertices, DataBase::Vertex))
+            vertFields.emplace_back(std::move(f));
+    }
+    for (auto &obj: m_celldata) {
+        if (auto f = createMappedField(obj, numVertices / 3, DataBase::Element))
+            cellFields.emplace_back(std::move(f));
+    }
+
+    auto coord = [&](Index v, const std::array<Index, 3> &n, int c) -> Scalar {
+        return vertexCoords ? coords[c][v] : coords[c][n[c]];
+    };
+
+#pragma omp parallel for schedule(dynamic)
+    for (ssize_t b = 0; b < numActive; ++b) {
+        const auto &cells = activeCells[b];
+        Index outIdx = location[b];
+        for (size_t i = 0; i < cells.vertex.size(); ++i) {
+            const Index v = cells.vertex[i];
+            const unsigned caseNum = cells.caseNum[i];
+            const auto n = StructuredGridBase::vertexCoordinates(v, dims);
+
+            Scalar field[8];
+            for (int idx = 0; idx < 8; ++idx)
+                field[idx] = isofunc(v + corner[idx]);
+
+            Scalar grad[8][3];
+            if (computeNormals) {
+                for (int idx = 0; idx < 8; ++idx) {
+                    Index x[3], xl[3], xu[3];
+                    for (int c = 0; c < 3; ++c) {
+                        x[c] = n[c] + H[c][idx];
+                        xl[c] = x[c] > 0 ? x[c] - 1 : x[c];
+                        xu[c] = x[c] < dims[c] - 1 ? x[c] + 1 : x[c];
+                    }
+                    for (int c = 0; c < 3; ++c) {
+                        Index xx = x[c];
+                        x[c] = xl[c];
+                        const Index l = StructuredGridBase::vertexIndex(x, dims);
+                        x[c] = xu[c];
+                        const Index u = StructuredGridBase::vertexIndex(x, dims);
+                        x[c] = xx;
+                        grad[idx][c] = isofunc(u) - isofunc(l);
+                        const Scalar diff = vertexCoords ? coords[c][u] - coords[c][l] : coords[c][xu[c]] - coords[c][xl[c]];
+                        if (std::abs(diff) > EPSILON)
+                            grad[idx][c] /= diff;
+                        else
+                            grad[idx][c] = 0;
+                    }
+                }
+            }
+
+            const Index numVert = hexaNumVertsTable[caseNum];
+            for (Index idx = 0; idx < numVert; ++idx) {
+                const int edge = hexaTriTable[caseNum][idx];
+                const int v1 = hexaEdgeTable[0][edge];
+                const int v2 = hexaEdgeTable[1][edge];
+                const Scalar t = interpolation_weight<Scalar>(field[v1], field[v2], isoValue);
+                const Index c1 = v + corner[v1], c2 = v + corner[v2];
+                const std::array<Index, 3> n1{n[0] + H[0][v1], n[1] + H[1][v1], n[2] + H[2][v1]};
+                const std::array<Index, 3> n2{n[0] + H[0][v2], n[1] + H[1][v2], n[2] + H[2][v2]};
+                for (int c = 0; c < 3; ++c)
+                    out[c][outIdx] = lerp(coord(c1, n1, c), coord(c2, n2, c), t);
+                if (computeNormals) {
+                    for (int c = 0; c < 3; ++c)
+                        outNormal[c][outIdx] = lerp(grad[v1][c], grad[v2][c], t);
+                }
+                for (auto &f: vertFields)
+                    f->lerpVertex(outIdx, c1, c2, t);
+                ++outIdx;
+            }
+            if (!cellFields.empty()) {
+                const Index cell = StructuredGridBase::cellIndex(n[0], n[1], n[2], dims);
+                const Index firstTri = (outIdx - numVert) / 3;
+                for (Index tri = firstTri; tri < outIdx / 3; ++tri) {
+                    for (auto &f: cellFields)
+                        f->copyCell(tri, cell);
+                }
+            }
+        }
+        assert(outIdx == location[b + 1]);
+    }
+
+    for (auto &f: vertFields)
+        m_outvertData.push_back(f->result);
+    for (auto &f: cellFields)
+        m_outcellData.push_back(f->result);
+
+    return true;
+}
@@ -0,0 +1,95 @@
+#include "SpanIndex.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+using namespace vistle;
+
+SpanIndex::SpanIndex(const std::vector<Scalar> &cellMin, const std::vector<Scalar> &cellMax)
+: m_min(std::numeric_limits<Scalar>::max())
+, m_max(std::numeric_limits<Scalar>::lowest())
+, m_binStart(ShmVector<Index>::create(NumBins + 1))
+{
+    assert(cellMin.size() == cellMax.size());
+    const Index ncell = cellMin.size();
+    Index nvalid = 0;
+    for (Index c = 0; c < ncell; ++c) {
+        if (cellMin[c] > cellMax[c])
+            continue;
+        ++nvalid;
+        m_min = std::min(m_min, cellMin[c]);
+        m_max = std::max(m_max, cellMax[c]);
+    }
+
+    // counting sort by bin of cell minimum
+    Index *start = m_binStart->data();
+    std::fill(start, start + NumBins + 1, 0);
+    for (Index c = 0; c < ncell; ++c) {
+        if (cellMin[c] <= cellMax[c])
+            ++start[bin(cellMin[c]) + 1];
+    }
+    for (Index b = 0; b < NumBins; ++b)
+        start[b + 1] += start[b];
+    assert(start[NumBins] == nvalid);
+
+    m_cell = ShmVector<Index>::create(nvalid);
+    Index *cell = m_cell->data();
+    std::vector<Index> fill(start, start + NumBins);
+    for (Index c = 0; c < ncell; ++c) {
+        if (cellMin[c] <= cellMax[c])
+            cell[fill[bin(cellMin[c])]++] = c;
+    }
+
+    // decreasing maximum within each bin allows to stop early during queries
+#pragma omp parallel for schedule(dynamic)
+    for (ssize_t b = 0; b < ssize_t(NumBins); ++b) {
+        std::sort(cell + start[b], cell + start[b + 1],
+                  [&cellMax](Index c0, Index c1) { return cellMax[c0] > cellMax[c1]; });
+    }
+
+    m_cellMin = ShmVector<Scalar>::create(nvalid);
+    m_cellMax = ShmVector<Scalar>::create(nvalid);
+    Scalar *cmin = m_cellMin->data(), *cmax = m_cellMax->data();
+    for (Index i = 0; i < nvalid; ++i) {
+        cmin[i] = cellMin[cell[i]];
+        cmax[i] = cellMax[cell[i]];
+    }
+}
+
+Index SpanIndex::bin(Scalar value) const
+{
+    if (!(m_max > m_min))
+        return 0;
+    const Scalar rel = (value - m_min) / (m_max - m_min) * NumBins;
+    if (rel <= 0)
+        return 0;
+    return std::min(Index(rel), NumBins - 1);
+}
+
+Index SpanIndex::numCells() const
+{
+    return m_cell->size();
+}
+
+std::vector<Index> SpanIndex::activeCells(Scalar isoValue) const
+{
+    std::vector<Index> active;
+    if (isoValue < m_min || isoValue >= m_max)
+        return active;
+
+    const Index *start = m_binStart->data();
+    const Index *cell = m_cell->data();
+    const Scalar *cmin = m_cellMin->data(), *cmax = m_cellMax->data();
+    const Index last = bin(isoValue);
+    for (Index b = 0; b <= last; ++b) {
+        for (Index i = start[b]; i < start[b + 1]; ++i) {
+            if (cmax[i] <= isoValue)
+                break;
+            if (cmin[i] <= isoValue)
+                active.push_back(cell[i]);
+        }
+    }
+    std::sort(active.begin(), active.end());
+    return active;
+}
@@ -0,0 +1,41 @@
+#ifndef ISOSURFACE_SPANINDEX_H
+#define ISOSURFACE_SPANINDEX_H
+
+#include <vector>
+
+#include <vistle/core/index.h>
+#include <vistle/core/scalar.h>
+#include <vistle/core/shmvector.h>
+
+#ifdef CUTTINGSURFACE
+#define SpanIndex CutSpanIndex
+#elif defined(ISOHEIGHTSURFACE)
+#define SpanIndex IsoHeightSpanIndex
+#else
+#define SpanIndex IsoSpanIndex
+#endif
+
+//! span space index of the minimum and maximum of the iso-field within each cell
+/*! cells are grouped into bins according to their minimum and sorted by decreasing maximum within each bin,
+ *  so that a query only visits cells straddling the iso-value and at most one other cell per bin */
+class SpanIndex {
+public:
+    static const vistle::Index NumBins = 256;
+
+    //! build index from per-cell extrema, cells with cellMin > cellMax are never returned
+    SpanIndex(const std::vector<vistle::Scalar> &cellMin, const std::vector<vistle::Scalar> &cellMax);
+
+    //! return sorted indices of all cells having vertices both above and not above isoValue
+    std::vector<vistle::Index> activeCells(vistle::Scalar isoValue) const;
+    vistle::Index numCells() const;
+
+private:
+    vistle::Index bin(vistle::Scalar value) const;
+
+    vistle::Scalar m_min, m_max;
+    vistle::ShmVector<vistle::Index> m_binStart;
+    vistle::ShmVector<vistle::Index> m_cell;
+    vistle::ShmVector<vistle::Scalar> m_cellMin, m_cellMax;
+};
+
+#endif
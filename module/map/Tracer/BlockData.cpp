@@ -2,6 +2,8 @@
 #include "Integrator.h"
 #include <vistle/core/vec.h>
 #include <mutex>
+#include <limits>
+#include <algorithm>
 
 
 using namespace vistle;
@@ -78,6 +80,23 @@ const Matrix4 &BlockData::invTransform() const
     return m_invTransform;
 }
 
+std::pair<Vector3, Vector3> BlockData::worldBounds() const
+{
+    const Scalar smax = std::numeric_limits<Scalar>::max();
+    Vector3 wmin(smax, smax, smax), wmax(-smax, -smax, -smax);
+    const auto bounds = m_gridInterface->getBounds();
+    for (int i = 0; i < 8; ++i) {
+        Vector3 corner((i & 1) ? bounds.second[0] : bounds.first[0], (i & 2) ? bounds.second[1] : bounds.first[1],
+                       (i & 4) ? bounds.second[2] : bounds.first[2]);
+        corner = transformPoint(m_transform, corner);
+        for (int c = 0; c < 3; ++c) {
+            wmin[c] = std::min(wmin[c], corner[c]);
+            wmax[c] = std::max(wmax[c], corner[c]);
+        }
+    }
+    return std::make_pair(wmin, wmax);
+}
+
 const Matrix3 &BlockData::velocityTransform() const
 {
     return m_velocityTransform;
@@ -38,6 +38,8 @@ public:
     const vistle::Matrix4 &transform() const;
     const vistle::Matrix4 &invTransform() const;
     const vistle::Matrix3 &velocityTransform() const;
+    //! axis-aligned bounds of block after applying its transform
+    std::pair<vistle::Vector3, vistle::Vector3> worldBounds() const;
 
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
@@ -234,6 +234,9 @@ bool Integrator::StepConstantVelocity()
 Vector3 Integrator::Interpolator(BlockData *bl, Index el, const Vector3 &point)
 {
     auto grid = bl->getGrid();
-    GridInterface::Interpolator interpolator = grid->getInterpolator(el, point, bl->getVecMapping());
-    return interpolator(m_v[0], m_v[1], m_v[2]);
+    const Scalar *x[3] = {&point[0], &point[1], &point[2]};
+    Vector3 vel;
+    Scalar *out[3] = {&vel[0], &vel[1], &vel[2]};
+    grid->interpolate(1, &el, x, 3, m_v, out, bl->getVecMapping());
+    return vel;
 }
@@ -1,14 +1,14 @@
 #include <limits>
 #include <algorithm>
-#include <boost/mpi/collectives/broadcast.hpp>
+#include <boost/mpi/collectives/all_reduce.hpp>
 #include <boost/serialization/vector.hpp>
 #include <vistle/core/vec.h>
 #include <vistle/util/math.h>
-#include <vistle/util/threadname.h>
 #include "Tracer.h"
 #include "Integrator.h"
 #include "Particle.h"
 #include "BlockData.h"
+#include "TracerPool.h"
 
 using namespace vistle;
 
@@ -69,6 +69,40 @@ void Particle::enableCelltree(bool value)
     m_integrator.enableCelltree(value);
 }
 
+bool Particle::searchLocal()
+{
+    assert(!m_tracing);
+    assert(!m_currentSegment);
+    m_progress = false;
+
+    if (findCell(m_time)) {
+        m_integrator.hInit();
+        return true;
+    }
+    return false;
+}
+
+void Particle::discardSegment()
+{
+    m_currentSegment.reset();
+    UpdateBlock(nullptr);
+}
+
+bool Particle::hasSegments() const
+{
+    return !m_segments.empty();
+}
+
+const Vector3 &Particle::position() const
+{
+    return m_x;
+}
+
+Index Particle::timestep() const
+{
+    return m_timestep;
+}
+
 int Particle::searchRank(boost::mpi::communicator mpi_comm)
 {
     assert(!m_tracing);
@@ -90,14 +124,19 @@ int Particle::searchRank(boost::mpi::communicator mpi_comm)
     return rank;
 }
 
-void Particle::startTracing()
+void Particle::startTracing(std::vector<Particle *> &particles, TracerPool &pool)
 {
-    assert(inGrid());
-    m_tracing = true;
-    m_progressFuture = std::async(std::launch::async, [this]() -> bool {
-        setThreadName("Tracer:Particle:" + std::to_string(id()));
-        return trace();
+    std::sort(particles.begin(), particles.end(), [](const Particle *a, const Particle *b) {
+        if (a->m_block != b->m_block)
+            return std::less<const BlockData *>()(a->m_block, b->m_block);
+        return a->m_el < b->m_el;
     });
+    for (auto p: particles) {
+        assert(p->inGrid());
+        p->m_progress = false;
+        p->m_tracing = true;
+    }
+    pool.enqueue(particles);
 }
 
 bool Particle::isActive() const
@@ -228,17 +267,11 @@ void Particle::Deactivate(StopReason reason)
     m_ingrid = false;
 }
 
-bool Particle::Step()
+bool Particle::Step(const Vector3 &vel, Scalar pressure)
 {
-    const auto &grid = m_block->getGrid();
-    auto inter = grid->getInterpolator(m_el, m_x, m_block->m_vecmap);
-    m_v = inter(m_block->m_vx, m_block->m_vy, m_block->m_vz);
-    m_v = m_block->velocityTransform() * m_v;
-    if (m_block->m_p) {
-        if (m_block->m_scamap != m_block->m_vecmap)
-            inter = grid->getInterpolator(m_el, m_x, m_block->m_scamap);
-        m_p = inter(m_block->m_p);
-    }
+    m_v = m_block->velocityTransform() * vel;
+    if (m_block->m_p)
+        m_p = pressure;
     Scalar ddist = (m_x - m_xold).norm();
     m_xold = m_x;
 
@@ -257,30 +290,9 @@ bool Particle::Step()
     return ret;
 }
 
-bool Particle::isTracing(bool wait)
+bool Particle::isTracing() const
 {
-    if (!m_tracing) {
-        return false;
-    }
-
-    if (!m_progressFuture.valid()) {
-        std::cerr << "Particle::isTracing(): future not valid" << std::endl;
-        m_tracing = false;
-        return false;
-    }
-
-    auto status = m_progressFuture.wait_for(std::chrono::milliseconds(wait ? 10 : 0));
-#if !defined(__clang__) && defined(__GNUC__) && (__GNUC__ == 4) && (__GNUC_MINOR__ <= 6)
-    if (!status)
-        return true;
-#else
-    if (status != std::future_status::ready)
-        return true;
-#endif
-
-    m_tracing = false;
-    m_progress = m_progressFuture.get();
-    return false;
+    return m_tracing;
 }
 
 bool Particle::madeProgress() const
@@ -292,17 +304,65 @@ bool Particle::madeProgress() const
     return m_progress;
 }
 
-bool Particle::trace()
+size_t Particle::trace(ParticleBatch &batch, Index maxSteps)
 {
-    assert(m_tracing);
+    auto &particles = batch.particles;
+    size_t numFinished = 0;
+
+    for (Index step = 0; step < maxSteps && !particles.empty(); ++step) {
+        size_t n = 0;
+        for (auto p: particles) {
+            assert(p->m_tracing);
+            if (p->isMoving() && p->findCell(p->m_time)) {
+                particles[n++] = p;
+            } else {
+                p->UpdateBlock(nullptr);
+                p->m_tracing = false;
+                ++numFinished;
+            }
+        }
+        particles.resize(n);
+
+        // group by block, so that velocities can be interpolated for all particles of a block at once
+        std::sort(particles.begin(), particles.end(), [](const Particle *a, const Particle *b) {
+            return std::less<const BlockData *>()(a->m_block, b->m_block);
+        });
+        batch.cells.resize(n);
+        for (int c = 0; c < 3; ++c)
+            batch.x[c].resize(n);
+        for (int c = 0; c < 4; ++c)
+            batch.values[c].resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            batch.cells[i] = particles[i]->m_el;
+            for (int c = 0; c < 3; ++c)
+                batch.x[c][i] = particles[i]->m_x[c];
+        }
 
-    bool traced = false;
-    while (isMoving() && findCell(m_time)) {
-        Step();
-        traced = true;
+        for (size_t begin = 0, end = 0; begin < n; begin = end) {
+            BlockData *block = particles[begin]->m_block;
+            for (end = begin + 1; end < n && particles[end]->m_block == block; ++end)
+                ;
+            const auto grid = block->getGrid();
+            const Scalar *x[3] = {&batch.x[0][begin], &batch.x[1][begin], &batch.x[2][begin]};
+            Scalar *out[4] = {&batch.values[0][begin], &batch.values[1][begin], &batch.values[2][begin],
+                              &batch.values[3][begin]};
+            const Scalar *field[4] = {block->m_vx, block->m_vy, block->m_vz, block->m_p};
+            int numComponents = 3;
+            if (block->m_p && block->m_scamap == block->m_vecmap)
+                numComponents = 4;
+            grid->interpolate(end - begin, &batch.cells[begin], x, numComponents, field, out, block->m_vecmap);
+            if (block->m_p && numComponents == 3)
+                grid->interpolate(end - begin, &batch.cells[begin], x, 1, &field[3], &out[3], block->m_scamap);
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            auto p = particles[i];
+            p->Step(Vector3(batch.values[0][i], batch.values[1][i], batch.values[2][i]), batch.values[3][i]);
+            p->m_progress = true;
+        }
     }
-    UpdateBlock(nullptr);
-    return traced;
+
+    return numFinished;
 }
 
 void Particle::finishSegment()
@@ -578,9 +638,14 @@ Scalar Particle::time() const
 }
 
 
-void Particle::broadcast(boost::mpi::communicator mpi_comm, int root)
+void Particle::packState(boost::mpi::packed_oarchive &ar)
 {
-    boost::mpi::broadcast(mpi_comm, *this, root);
+    ar << *this;
+}
+
+void Particle::unpackState(boost::mpi::packed_iarchive &ar)
+{
+    ar >> *this;
     m_integrator.m_hact = m_integrator.m_h;
     m_progress = false;
 }
@@ -614,23 +679,22 @@ void load(Archive &ar, Particle::SegmentMap &segments, const unsigned int versio
 
 BOOST_SERIALIZATION_SPLIT_FREE(Particle::SegmentMap)
 
-void Particle::startSendData(boost::mpi::communicator mpi_comm)
-{
-    assert(rank() != mpi_comm.rank());
-    m_requests.emplace_back(mpi_comm.isend(rank(), id(), m_segments));
-}
-
-void Particle::finishSendData()
+void Particle::packData(boost::mpi::packed_oarchive &ar)
 {
-    mpi::wait_all(m_requests.begin(), m_requests.end());
-    m_requests.clear();
+    ar << m_stopReason;
+    ar << m_segments;
     m_segments.clear();
 }
 
-void Particle::receiveData(boost::mpi::communicator mpi_comm, int rank)
+void Particle::unpackData(boost::mpi::packed_iarchive &ar)
 {
+    StopReason reason = StillActive;
+    ar >> reason;
+    if (reason != StillActive)
+        m_stopReason = reason;
+
     SegmentMap segments;
-    mpi_comm.recv(rank, id(), segments);
+    ar >> segments;
     for (auto &segpair: segments) {
         auto &seg = segpair.second;
         m_segments[seg->m_num] = seg;
@@ -2,9 +2,11 @@
 #define TRACER_PARTICLE_H
 
 #include <vector>
-#include <future>
+#include <atomic>
 
 #include <boost/mpi/communicator.hpp>
+#include <boost/mpi/packed_iarchive.hpp>
+#include <boost/mpi/packed_oarchive.hpp>
 
 #include <boost/serialization/split_free.hpp>
 
@@ -18,6 +20,16 @@
 
 class BlockData;
 class GlobalData;
+class TracerPool;
+class Particle;
+
+//! structure-of-arrays state of several particles advanced in lockstep, storage is reused across steps
+struct ParticleBatch {
+    std::vector<Particle *> particles;
+    std::vector<vistle::Index> cells; //!< cell hints for interpolation
+    std::vector<vistle::Scalar> x[3]; //!< block-local coordinates
+    std::vector<vistle::Scalar> values[4]; //!< velocity and pressure at current positions
+};
 
 class Particle {
     friend class Integrator;
@@ -42,19 +54,26 @@ public:
     bool isForward() const;
     void Deactivate(StopReason reason);
     void EmitData();
-    bool Step();
-    void broadcast(boost::mpi::communicator mpi_comm, int root);
-    void startSendData(boost::mpi::communicator mpi_comm);
-    void finishSendData();
-    void receiveData(boost::mpi::communicator mpi_comm, int rank);
+    bool Step(const vistle::Vector3 &vel, vistle::Scalar pressure); //< advance from velocity and pressure at current position
+    void packState(boost::mpi::packed_oarchive &ar); //< state required for continuing trace on another rank
+    void unpackState(boost::mpi::packed_iarchive &ar);
+    void packData(boost::mpi::packed_oarchive &ar); //< traced segments and stop reason for owning rank
+    void unpackData(boost::mpi::packed_iarchive &ar);
     void UpdateBlock(BlockData *block);
     StopReason stopReason() const;
     void enableCelltree(bool value);
     int searchRank(boost::mpi::communicator mpi_comm); //< returns MPI rank of node where tracing occurs
-    void startTracing();
-    bool isTracing(bool wait);
+    bool searchLocal(); //< whether tracing can continue on this rank, without communication
+    void discardSegment(); //< undo effects of searchLocal if tracing continues elsewhere
+    bool hasSegments() const;
+    const vistle::Vector3 &position() const;
+    vistle::Index timestep() const;
+    //! schedule particles located on this rank for tracing, grouped by block and cell so that they are advanced in batches
+    static void startTracing(std::vector<Particle *> &particles, TracerPool &pool);
+    bool isTracing() const;
     bool madeProgress() const;
-    bool trace();
+    //! advance particles in batch by up to maxSteps steps, particles which cannot continue on this rank are removed from batch
+    static size_t trace(ParticleBatch &batch, vistle::Index maxSteps);
     void finishSegment();
     void fetchSegments(Particle &other); //! move segments from other particle to this one
     void addToOutput();
@@ -128,9 +147,8 @@ private:
     vistle::Index m_startId; //!< id of start point;
     int m_rank; //! MPI rank where resulting geometry is assembled
     vistle::Index m_timestep; //! timestep of particle for streamlines
-    std::future<bool> m_progressFuture; //!< future on whether particle has made progress during trace()
-    bool m_progress;
-    bool m_tracing; //!< particle is currently tracing on this node
+    bool m_progress; //!< particle has made progress since tracing was started
+    std::atomic<bool> m_tracing; //!< particle is currently tracing on this node
     bool m_forward; //!< trace direction
     vistle::Vector3 m_x; //!< current position
     vistle::Vector3 m_xold; //!< previous position
@@ -168,7 +186,5 @@ private:
         ar &m_stopReason;
         ar &m_segment;
     }
-
-    std::vector<boost::mpi::request> m_requests;
 };
 #endif
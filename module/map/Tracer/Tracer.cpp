@@ -1,13 +1,20 @@
 #include "Tracer.h"
 #include "BlockData.h"
 #include "Particle.h"
+#include "TracerPool.h"
 #include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <cmath>
 #include <boost/mpi/collectives/all_reduce.hpp>
 #include <boost/mpi/collectives/all_gather.hpp>
+#include <boost/mpi/collectives/all_to_all.hpp>
 #include <boost/mpi/collectives/broadcast.hpp>
+#include <boost/mpi/collectives/gather.hpp>
+#include <boost/mpi/collectives/reduce.hpp>
+#include <boost/mpi/nonblocking.hpp>
+#include <boost/mpi/packed_iarchive.hpp>
+#include <boost/mpi/packed_oarchive.hpp>
 #include <boost/mpi/operations.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/map.hpp>
@@ -29,6 +36,11 @@ MODULE_MAIN(Tracer)
 using namespace vistle;
 namespace mpi = boost::mpi;
 
+// integration steps a particle is advanced before it is rescheduled, so that long traces do not monopolize threads
+static const Index StepsPerTask = 500;
+// particles advanced together by one thread, so that velocity interpolation can be batched
+static const size_t ParticlesPerTask = 16;
+
 DEFINE_ENUM_WITH_STRING_CONVERSIONS(StartStyle, (Line)(Plane)(Cylinder))
 
 DEFINE_ENUM_WITH_STRING_CONVERSIONS(TraceDirection, (Both)(Forward)(Backward))
@@ -141,7 +153,7 @@ Tracer::Tracer(const std::string &name, int moduleID, mpi::communicator comm): M
     m_useCelltree =
         addIntParameter("use_celltree", "use celltree for accelerated cell location", (Integer)1, Parameter::Boolean);
     auto num_active =
-        addIntParameter("num_active", "number of particles to trace simultaneously on each node (0: no. of cores)", 0);
+        addIntParameter("num_active", "number of threads tracing particles on each node (0: no. of cores)", 0);
     setParameterRange(num_active, (Integer)0, (Integer)10000);
 
     m_particlePlacement = addIntParameter("particle_placement", "where a particle's data shall be collected", RankById,
@@ -167,6 +179,7 @@ bool Tracer::prepare()
 
     grid_in.clear();
     celltree.clear();
+    m_celltreeCache.prune();
     data_in0.clear();
     data_in1.clear();
 
@@ -248,20 +261,10 @@ bool Tracer::compute()
     }
 
     if (useCelltree) {
-        if (unstr) {
-            celltree[t + 1].emplace_back(std::async(std::launch::async, [unstr]() -> Celltree3::const_ptr {
-                setThreadName("Tracer:Celltree");
-                return unstr->getCelltree();
-            }));
-        } else if (auto str = StructuredGrid::as(grid)) {
-            celltree[t + 1].emplace_back(std::async(std::launch::async, [str]() -> Celltree3::const_ptr {
+        if (unstr || StructuredGrid::as(grid) || LayerGrid::as(grid)) {
+            celltree[t + 1].emplace_back(std::async(std::launch::async, [this, grid]() -> Celltree3::const_ptr {
                 setThreadName("Tracer:Celltree");
-                return str->getCelltree();
-            }));
-        } else if (auto lg = LayerGrid::as(grid)) {
-            celltree[t + 1].emplace_back(std::async(std::launch::async, [lg]() -> Celltree3::const_ptr {
-                setThreadName("Tracer:Celltree");
-                return lg->getCelltree();
+                return m_celltreeCache.getCelltree(grid);
             }));
         }
     }
@@ -376,11 +379,10 @@ bool Tracer::reduce(int timestep)
     //get parameters
     bool useCelltree = m_useCelltree->getValue();
     Index numpoints = m_numStartpoints->getValue();
-    Index maxNumActive = getIntParameter("num_active");
-    if (maxNumActive <= 0) {
-        maxNumActive = std::thread::hardware_concurrency();
+    Integer numThreads = getIntParameter("num_active");
+    if (numThreads <= 0) {
+        numThreads = std::thread::hardware_concurrency();
     }
-    Index maxNumActiveGlobal = mpi::all_reduce(comm(), maxNumActive, mpi::maximum<Index>());
     auto taskType = (TraceType)getIntParameter("taskType");
     TraceDirection traceDirection = (TraceDirection)getIntParameter("tdirection");
     if (taskType != Streamlines) {
@@ -494,7 +496,7 @@ bool Tracer::reduce(int timestep)
 
     std::vector<Index> stopReasonCount(Particle::NumStopReasons, 0);
     std::vector<std::shared_ptr<Particle>> allParticles;
-    std::set<std::shared_ptr<Particle>> localParticles, activeParticles;
+    std::set<std::shared_ptr<Particle>> activeParticles;
 
     Index numconstant = grid_in.size() ? grid_in[0].size() : 0;
     for (Index i = 0; i < numconstant; ++i) {
@@ -540,163 +542,266 @@ bool Tracer::reduce(int timestep)
         }
     }
 
-    Index nextParticleToStart = 0;
-    auto startParticles = [this, &nextParticleToStart, &allParticles, &activeParticles, &localParticles,
-                           maxNumActive](int toStart) -> int {
-        int started = 0;
-        while (nextParticleToStart < allParticles.size()) {
-            if (started >= toStart)
-                break;
+    const int mpisize = comm().size();
+
+    // bounds of all blocks on all ranks, so that particles leaving the local domain are only offered to ranks which might continue tracing them
+    std::vector<std::vector<std::vector<Scalar>>> rankBounds(numtime); // timestep, rank, 6 values per block
+    if (mpisize > 1) {
+        for (int t = 0; t < numtime; ++t) {
+            std::vector<Scalar> bounds;
+            bounds.reserve(global.blocks[t].size() * 6);
+            for (auto &block: global.blocks[t]) {
+                auto b = block->worldBounds();
+                for (int c = 0; c < 3; ++c)
+                    bounds.push_back(b.first[c]);
+                for (int c = 0; c < 3; ++c)
+                    bounds.push_back(b.second[c]);
+            }
+            mpi::all_gather(comm(), bounds, rankBounds[t]);
+        }
+    }
+
+    auto candidateRanks = [this, &rankBounds, mpisize](Particle &p) -> std::vector<int> {
+        std::vector<int> ranks;
+        const auto &pos = p.position();
+        const auto &tb = rankBounds[p.timestep()];
+        for (int r = 0; r < mpisize; ++r) {
+            if (r == rank())
+                continue;
+            const auto &bounds = tb[r];
+            for (size_t b = 0; b + 6 <= bounds.size(); b += 6) {
+                if (pos[0] >= bounds[b] && pos[1] >= bounds[b + 1] && pos[2] >= bounds[b + 2] &&
+                    pos[0] <= bounds[b + 3] && pos[1] <= bounds[b + 4] && pos[2] <= bounds[b + 5]) {
+                    ranks.push_back(r);
+                    break;
+                }
+            }
+        }
+        return ranks;
+    };
 
-            Index idx = nextParticleToStart;
-            ++nextParticleToStart;
+    std::vector<bool> visited(allParticles.size()); // particles which have been traced on this rank
+    TracerPool pool(numThreads, StepsPerTask, ParticlesPerTask);
+
+    // start all particles located on this rank at once, the pool's threads bound the parallelism
+    {
+        std::vector<Particle *> start;
+        for (Index idx = 0; idx < allParticles.size(); ++idx) {
             auto particle = allParticles[idx];
             int r = particle->searchRank(comm());
             if (r >= 0) {
-                ++started;
                 if (rank() == r) {
-                    if (activeParticles.size() < maxNumActive) {
-                        activeParticles.emplace(particle);
-                        particle->startTracing();
-                    } else {
-                        localParticles.emplace(particle);
-                    }
+                    visited[idx] = true;
+                    activeParticles.emplace(particle);
+                    start.push_back(particle.get());
+                } else {
+                    particle->discardSegment();
                 }
             } else {
                 particle->Deactivate(Particle::InitiallyOutOfDomain);
             }
         }
-        return started;
-    };
+        Particle::startTracing(start, pool);
+    }
 
-    std::vector<Index> datasendlist;
-    std::vector<std::pair<Index, int>> datarecvlist; // particle id, source mpi rank
-    const int mpisize = comm().size();
-    Index numActiveMax = 0, numActiveMin = std::numeric_limits<Index>::max();
+    Index numActiveMax = 0;
     do {
         std::vector<Index> sendlist;
-        Index numStart = maxNumActiveGlobal > numActiveMin ? maxNumActiveGlobal - numActiveMin : 0;
-        startParticles(numStart);
 
-        bool first = true;
-        int numDeactivated = 0;
+        if (mpisize == 1 && !activeParticles.empty())
+            pool.waitForFinished(std::chrono::milliseconds(10));
         // build list of particles to send to their owner
         for (auto it = activeParticles.begin(), next = it; it != activeParticles.end(); it = next) {
             next = it;
             ++next;
 
             auto particle = it->get();
-
-            bool wait = mpisize == 1 && first;
-            first = false;
-            if (!particle->isTracing(wait)) {
+            if (!particle->isTracing()) {
                 if (mpisize == 1) {
                     particle->Deactivate(Particle::OutOfDomain);
                 } else if (particle->madeProgress()) {
                     sendlist.push_back(particle->id());
                 }
                 activeParticles.erase(it);
-                ++numDeactivated;
             }
         }
 
-        while (numDeactivated > 0 && !localParticles.empty()) {
-            --numDeactivated;
-            auto p = *localParticles.begin();
-            activeParticles.emplace(p);
-            p->startTracing();
-            localParticles.erase(localParticles.begin());
-        }
-
         if (mpisize == 1) {
-            numActiveMax = numActiveMin = activeParticles.size() + localParticles.size();
+            numActiveMax = activeParticles.size();
             continue;
         }
 
-        // communicate
-        Index num_send = sendlist.size();
-        std::vector<Index> num_transmit(mpisize);
-        mpi::all_gather(comm(), num_send, num_transmit);
-        for (int mpirank = 0; mpirank < mpisize; mpirank++) {
-            Index num_recv = num_transmit[mpirank];
-            if (num_recv > 0) {
-                std::vector<Index> recvlist;
-                auto &curlist = rank() == mpirank ? sendlist : recvlist;
-                mpi::broadcast(comm(), curlist, mpirank);
-                assert(curlist.size() == num_recv);
-                for (Index i = 0; i < num_recv; i++) {
-                    Index p_index = curlist[i];
-                    auto p = allParticles[p_index];
-                    assert(!p->isTracing(false));
-                    p->broadcast(comm(), mpirank);
-                    if (p->rank() == rank() && rank() != mpirank) {
-                        datarecvlist.emplace_back(p->id(), mpirank);
-                    }
-                    p->finishSegment();
-                    int r = p->searchRank(comm());
-                    if (r < 0) {
-                        p->Deactivate(Particle::OutOfDomain);
-                    } else if (r == rank()) {
-                        if (activeParticles.size() < maxNumActive) {
-                            activeParticles.emplace(p);
-                            p->startTracing();
-                        } else {
-                            localParticles.emplace(p);
-                        }
-                    }
+        // communicate: offer particles to ranks where they might continue, ranks report whether they found them,
+        // highest rank that found a particle continues tracing
+        enum Tags { TagOffer = 1, TagFound, TagDecision };
+        std::vector<std::vector<Index>> offers(mpisize);
+        for (auto id: sendlist) {
+            auto p = allParticles[id];
+            assert(!p->isTracing());
+            p->finishSegment();
+            if (p->inGrid()) {
+                for (int r: candidateRanks(*p))
+                    offers[r].push_back(id);
+            }
+        }
+
+        std::vector<Index> numOffered(mpisize), numReceived(mpisize);
+        for (int r = 0; r < mpisize; ++r)
+            numOffered[r] = offers[r].size();
+        mpi::all_to_all(comm(), numOffered, numReceived);
+
+        std::vector<mpi::request> requests;
+        std::vector<std::shared_ptr<mpi::packed_oarchive>> archives;
+        for (int r = 0; r < mpisize; ++r) {
+            if (offers[r].empty())
+                continue;
+            archives.emplace_back(std::make_shared<mpi::packed_oarchive>(comm()));
+            auto &ar = *archives.back();
+            ar << offers[r];
+            for (auto id: offers[r])
+                allParticles[id]->packState(ar);
+            requests.emplace_back(comm().isend(r, TagOffer, ar));
+        }
+
+        std::vector<std::vector<Index>> received(mpisize);
+        std::vector<std::vector<char>> found(mpisize);
+        for (int r = 0; r < mpisize; ++r) {
+            if (numReceived[r] == 0)
+                continue;
+            mpi::packed_iarchive ar(comm());
+            comm().recv(r, TagOffer, ar);
+            ar >> received[r];
+            assert(received[r].size() == numReceived[r]);
+            found[r].resize(numReceived[r]);
+            for (Index i = 0; i < numReceived[r]; ++i) {
+                auto p = allParticles[received[r][i]];
+                p->unpackState(ar);
+                found[r][i] = p->searchLocal();
+            }
+            requests.emplace_back(comm().isend(r, TagFound, found[r]));
+        }
+
+        std::map<Index, int> winners;
+        for (int r = 0; r < mpisize; ++r) {
+            if (offers[r].empty())
+                continue;
+            std::vector<char> f;
+            comm().recv(r, TagFound, f);
+            assert(f.size() == offers[r].size());
+            for (size_t i = 0; i < f.size(); ++i) {
+                if (f[i])
+                    winners[offers[r][i]] = r;
+            }
+        }
+
+        std::vector<std::vector<char>> decisions(mpisize);
+        for (int r = 0; r < mpisize; ++r) {
+            if (offers[r].empty())
+                continue;
+            auto &d = decisions[r];
+            d.reserve(offers[r].size());
+            for (auto id: offers[r]) {
+                auto it = winners.find(id);
+                d.push_back(it != winners.end() && it->second == r);
+            }
+            requests.emplace_back(comm().isend(r, TagDecision, d));
+        }
+        for (auto id: sendlist) {
+            if (winners.find(id) == winners.end())
+                allParticles[id]->Deactivate(Particle::OutOfDomain);
+        }
+
+        std::vector<Particle *> migrated;
+        for (int r = 0; r < mpisize; ++r) {
+            if (numReceived[r] == 0)
+                continue;
+            std::vector<char> d;
+            comm().recv(r, TagDecision, d);
+            assert(d.size() == received[r].size());
+            for (size_t i = 0; i < d.size(); ++i) {
+                auto id = received[r][i];
+                auto p = allParticles[id];
+                if (d[i]) {
+                    visited[id] = true;
+                    activeParticles.emplace(p);
+                    migrated.push_back(p.get());
+                } else if (found[r][i]) {
+                    p->discardSegment();
                 }
             }
         }
+        Particle::startTracing(migrated, pool);
+        mpi::wait_all(requests.begin(), requests.end());
 
-        std::copy(sendlist.begin(), sendlist.end(), std::back_inserter(datasendlist));
+        numActiveMax = mpi::all_reduce(comm(), activeParticles.size(), mpi::maximum<Index>());
+    } while (numActiveMax > 0);
 
-        numActiveMin = mpi::all_reduce(comm(), activeParticles.size() + localParticles.size(), mpi::minimum<Index>());
-        numActiveMax = mpi::all_reduce(comm(), activeParticles.size() + localParticles.size(), mpi::maximum<Index>());
-        //std::cerr << "recvlist: " << datarecvlist.size() << ", sendlist: " << sendlist.size() << ", #active="<<activeParticles.size() << std::endl;
-    } while (numActiveMax > 0 || nextParticleToStart < allParticles.size());
+    auto stats = pool.statistics();
+    std::vector<TracerPool::Statistics> allStats;
+    mpi::gather(comm(), stats, allStats, 0);
+    if (rank() == 0) {
+        std::stringstream str;
+        str << "Tracing threads utilization per rank:";
+        for (int r = 0; r < mpisize; ++r) {
+            const auto &st = allStats[r];
+            str << " " << r << ":" << std::round(100. * st.utilization()) << "% (" << st.numThreads << " threads, "
+                << st.numTasks << " tasks, " << st.numSteals << " steals, " << st.wallTime << " s)";
+        }
+        std::string s = str.str();
+        sendInfo("%s", s.c_str());
+    }
 
     if (mpisize == 1) {
         for (auto p: allParticles) {
             p->finishSegment();
         }
     } else {
-        // iterate over all other ranks
+        // send traced segments and stop reasons to owning ranks
+        enum Tags { TagData = 4 };
+        std::vector<std::vector<Index>> sendData(mpisize);
+        for (Index id = 0; id < allParticles.size(); ++id) {
+            if (!visited[id])
+                continue;
+            auto p = allParticles[id];
+            if (p->rank() != rank())
+                sendData[p->rank()].push_back(id);
+        }
+
+        std::vector<Index> numSend(mpisize), numRecv(mpisize);
+        for (int r = 0; r < mpisize; ++r)
+            numSend[r] = sendData[r].size();
+        mpi::all_to_all(comm(), numSend, numRecv);
+
+        std::vector<mpi::request> requests;
+        std::vector<std::shared_ptr<mpi::packed_oarchive>> archives;
         for (int i = 1; i < mpisize; ++i) {
-            // start sending particles to owning rank
             int dst = (rank() + i) % size();
-            for (auto id: datasendlist) {
-                auto p = allParticles[id];
-                if (p->rank() == dst) {
-                    //std::cerr << "initiate sending " << p->id() << " to " << dst << std::endl;
-                    p->startSendData(comm());
-                }
-            }
+            if (sendData[dst].empty())
+                continue;
+            archives.emplace_back(std::make_shared<mpi::packed_oarchive>(comm()));
+            auto &ar = *archives.back();
+            ar << sendData[dst];
+            for (auto id: sendData[dst])
+                allParticles[id]->packData(ar);
+            requests.emplace_back(comm().isend(dst, TagData, ar));
         }
         for (int i = 1; i < mpisize; ++i) {
-            // receive locally owned particles
+            // receive data for locally owned particles
             int src = (rank() - i + size()) % size();
-            for (const auto &part: datarecvlist) {
-                auto id = part.first;
-                auto rank = part.second;
+            if (numRecv[src] == 0)
+                continue;
+            mpi::packed_iarchive ar(comm());
+            comm().recv(src, TagData, ar);
+            std::vector<Index> ids;
+            ar >> ids;
+            assert(ids.size() == numRecv[src]);
+            for (auto id: ids) {
                 auto p = allParticles[id];
-                assert(p->rank() == this->rank());
-                if (rank == src) {
-                    //std::cerr << "receiving " << p->id() << " from " << src << std::endl;
-                    p->receiveData(comm(), src);
-                }
-            }
-        }
-        for (int i = 1; i < mpisize; ++i) {
-            // finish sending particles to owning rank
-            int dst = (rank() + i) % size();
-            for (auto id: datasendlist) {
-                auto p = allParticles[id];
-                if (p->rank() == dst) {
-                    //std::cerr << "finish sending " << p->id() << " to " << dst << std::endl;
-                    p->finishSendData();
-                }
+                assert(p->rank() == rank());
+                p->unpackData(ar);
             }
         }
+        mpi::wait_all(requests.begin(), requests.end());
     }
 
     Scalar maxTime = 0;
@@ -827,9 +932,11 @@ bool Tracer::reduce(int timestep)
     }
 
     for (auto &p: allParticles) {
-        if (rank() == 0)
+        // particles that were not located on any rank have no owner, they are counted on rank 0
+        if (p->rank() < 0 && rank() == 0)
             ++stopReasonCount[p->stopReason()];
         if (p->rank() == rank()) {
+            ++stopReasonCount[p->stopReason()];
             if (traceDirection == Both && p->isForward()) {
                 auto other = allParticles[p->id() + 1];
                 p->fetchSegments(*other);
@@ -914,11 +1021,14 @@ bool Tracer::reduce(int timestep)
         }
     }
 
+    std::vector<Index> totalStopReasonCount(stopReasonCount.size());
+    mpi::reduce(comm(), stopReasonCount.data(), stopReasonCount.size(), totalStopReasonCount.data(), std::plus<Index>(),
+                0);
     if (rank() == 0) {
         std::stringstream str;
         str << "Stop stats for " << allParticles.size() << " particles:";
-        for (size_t i = 0; i < stopReasonCount.size(); ++i) {
-            str << " " << Particle::toString((Particle::StopReason)i) << ":" << stopReasonCount[i];
+        for (size_t i = 0; i < totalStopReasonCount.size(); ++i) {
+            str << " " << Particle::toString((Particle::StopReason)i) << ":" << totalStopReasonCount[i];
         }
         std::string s = str.str();
         sendInfo("%s", s.c_str());
@@ -12,6 +12,7 @@
 #include <vistle/core/points.h>
 #include <vistle/core/celltree.h>
 #include <vistle/module/module.h>
+#include <vistle/alg/celltreecache.h>
 #include "Integrator.h"
 
 DEFINE_ENUM_WITH_STRING_CONVERSIONS(TraceType,
@@ -81,6 +82,7 @@ private:
 
     std::vector<std::vector<vistle::Object::const_ptr>> grid_in;
     std::vector<std::vector<std::future<vistle::Celltree3::const_ptr>>> celltree;
+    vistle::CelltreeCache m_celltreeCache; //< reuse celltrees across executions for unchanged geometry
     std::vector<std::vector<vistle::Vec<vistle::Scalar, 3>::const_ptr>> data_in0;
     std::vector<std::vector<vistle::Vec<vistle::Scalar>::const_ptr>> data_in1;
 
@@ -0,0 +1,162 @@
+#include "TracerPool.h"
+#include "Particle.h"
+
+#include <cassert>
+#include <algorithm>
+#include <string>
+#include <vistle/util/threadname.h>
+
+TracerPool::TracerPool(unsigned numThreads, vistle::Index stepsPerTask, size_t batchSize)
+: m_stepsPerTask(stepsPerTask), m_batchSize(std::max(batchSize, size_t(1))), m_start(std::chrono::steady_clock::now())
+{
+    if (numThreads == 0)
+        numThreads = 1;
+    for (unsigned i = 0; i < numThreads; ++i)
+        m_workers.emplace_back(new Worker);
+    for (unsigned i = 0; i < numThreads; ++i)
+        m_workers[i]->thread = std::thread([this, i]() { work(i); });
+}
+
+TracerPool::~TracerPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_quit = true;
+    }
+    m_workAvailable.notify_all();
+    for (auto &w: m_workers)
+        w->thread.join();
+}
+
+void TracerPool::enqueue(const std::vector<Particle *> &particles)
+{
+    if (particles.empty())
+        return;
+
+    // count particles before publishing them, so that a thief cannot make the counter wrap around
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        m_numQueued += particles.size();
+    }
+    // hand out whole batches, workers pop them from the back of their queues in one piece
+    for (size_t begin = 0; begin < particles.size(); begin += m_batchSize) {
+        size_t end = std::min(begin + m_batchSize, particles.size());
+        auto &w = *m_workers[m_nextWorker];
+        {
+            std::lock_guard<std::mutex> guard(w.mutex);
+            w.queue.insert(w.queue.end(), particles.begin() + begin, particles.begin() + end);
+        }
+        m_nextWorker = (m_nextWorker + 1) % m_workers.size();
+    }
+    m_workAvailable.notify_all();
+}
+
+void TracerPool::push(size_t worker, Particle *particle)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        ++m_numQueued;
+    }
+    {
+        std::lock_guard<std::mutex> guard(m_workers[worker]->mutex);
+        m_workers[worker]->queue.push_back(particle);
+    }
+    m_workAvailable.notify_one();
+}
+
+bool TracerPool::pop(size_t worker, std::vector<Particle *> &batch)
+{
+    // newest particles from own queue, as their blocks are likely to be still cached
+    {
+        auto &w = *m_workers[worker];
+        std::lock_guard<std::mutex> guard(w.mutex);
+        while (!w.queue.empty() && batch.size() < m_batchSize) {
+            batch.push_back(w.queue.back());
+            w.queue.pop_back();
+        }
+    }
+    if (!batch.empty()) {
+        m_numQueued -= batch.size();
+        return true;
+    }
+
+    // oldest particles from another worker, leaving it at least half of its queue
+    for (size_t i = 1; i < m_workers.size(); ++i) {
+        auto &victim = *m_workers[(worker + i) % m_workers.size()];
+        std::lock_guard<std::mutex> guard(victim.mutex);
+        if (!victim.queue.empty()) {
+            size_t n = std::min(m_batchSize, (victim.queue.size() + 1) / 2);
+            batch.insert(batch.end(), victim.queue.begin(), victim.queue.begin() + n);
+            victim.queue.erase(victim.queue.begin(), victim.queue.begin() + n);
+            m_numQueued -= n;
+            ++m_workers[worker]->numSteals;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TracerPool::work(size_t worker)
+{
+    vistle::setThreadName("Tracer:Worker:" + std::to_string(worker));
+    auto &w = *m_workers[worker];
+
+    ParticleBatch batch;
+    for (;;) {
+        batch.particles.clear();
+        if (!pop(worker, batch.particles)) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workAvailable.wait(lock, [this]() { return m_quit || m_numQueued > 0; });
+            if (m_quit && m_numQueued == 0)
+                break;
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        size_t numFinished = Particle::trace(batch, m_stepsPerTask);
+        std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+        w.busyTime = w.busyTime + dur.count();
+        ++w.numTasks;
+
+        for (auto p: batch.particles)
+            push(worker, p);
+        if (numFinished > 0) {
+            {
+                std::lock_guard<std::mutex> guard(m_mutex);
+                m_numFinished += numFinished;
+            }
+            m_particleFinished.notify_all();
+        }
+    }
+}
+
+bool TracerPool::waitForFinished(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    bool finished =
+        m_particleFinished.wait_for(lock, timeout, [this]() { return m_numFinished != m_numFinishedSeen; });
+    m_numFinishedSeen = m_numFinished;
+    return finished;
+}
+
+TracerPool::Statistics TracerPool::statistics() const
+{
+    Statistics stats;
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - m_start;
+    stats.wallTime = wall.count();
+    stats.numThreads = m_workers.size();
+    for (const auto &w: m_workers) {
+        stats.busyTime += w->busyTime;
+        stats.numTasks += w->numTasks;
+        stats.numSteals += w->numSteals;
+    }
+    return stats;
+}
+
+double TracerPool::Statistics::utilization() const
+{
+    if (wallTime <= 0. || numThreads == 0)
+        return 0.;
+    return busyTime / (wallTime * numThreads);
+}
@@ -0,0 +1,75 @@
+#ifndef TRACERPOOL_H
+#define TRACERPOOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+#include <vistle/core/index.h>
+
+class Particle;
+
+//! work-stealing pool of threads advancing batches of particles by a limited number of integration steps per task
+class TracerPool {
+public:
+    struct Statistics {
+        double wallTime = 0.; //!< time since creation of pool
+        double busyTime = 0.; //!< time spent tracing, accumulated over all threads
+        size_t numThreads = 0;
+        size_t numTasks = 0;
+        size_t numSteals = 0;
+
+        double utilization() const;
+
+        template<class Archive>
+        void serialize(Archive &ar, const unsigned int version)
+        {
+            ar &wallTime;
+            ar &busyTime;
+            ar &numThreads;
+            ar &numTasks;
+            ar &numSteals;
+        }
+    };
+
+    TracerPool(unsigned numThreads, vistle::Index stepsPerTask, size_t batchSize);
+    ~TracerPool();
+
+    //! schedule particles for tracing, they will be marked as not tracing when they cannot continue on this rank
+    /*! consecutive particles are kept together in batches, so they should be sorted by block and cell */
+    void enqueue(const std::vector<Particle *> &particles);
+    //! block until a particle finished tracing since the last call or until timeout expires
+    bool waitForFinished(std::chrono::milliseconds timeout);
+    Statistics statistics() const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Particle *> queue;
+        std::thread thread;
+        std::atomic<double> busyTime{0.};
+        std::atomic<size_t> numTasks{0}, numSteals{0};
+    };
+
+    void push(size_t worker, Particle *particle);
+    bool pop(size_t worker, std::vector<Particle *> &batch);
+    void work(size_t worker);
+
+    const vistle::Index m_stepsPerTask;
+    const size_t m_batchSize;
+    const std::chrono::steady_clock::time_point m_start;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    size_t m_nextWorker = 0;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workAvailable, m_particleFinished;
+    std::atomic<size_t> m_numQueued{0};
+    size_t m_numFinished = 0, m_numFinishedSeen = 0;
+    bool m_quit = false;
+};
+#endif
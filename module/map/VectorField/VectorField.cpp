@@ -1,5 +1,6 @@
 #include <sstream>
 #include <iomanip>
+#include <vector>
 
 #include <vistle/core/object.h>
 #include <vistle/core/lines.h>
@@ -138,10 +139,10 @@ bool VectorField::compute()
 
     if (mapped) {
         mapped->setSize(numPoints * 2);
-        for (Index i = 0; i < numPoints; ++i) {
-            mapped->copyEntry(i * 2, data, i);
-            mapped->copyEntry(i * 2 + 1, data, i);
-        }
+        std::vector<Index> from(numPoints * 2);
+        for (Index i = 0; i < numPoints * 2; ++i)
+            from[i] = i / 2;
+        mapped->copyEntries(numPoints * 2, nullptr, data, from.data());
         mapped->setMeta(data->meta());
         mapped->copyAttributes(coords);
         mapped->copyAttributes(data);
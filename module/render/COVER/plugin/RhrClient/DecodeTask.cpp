@@ -1,6 +1,7 @@
 #include "DecodeTask.h"
 #include <vector>
 #include <mutex>
+#include <cstring>
 
 #include <vistle/rhr/rfbext.h>
 #include <vistle/rhr/compdecomp.h>
@@ -17,6 +18,20 @@ using vistle::message::RemoteRenderMessage;
 
 #define CERR std::cerr << "RhrClient:Decode: "
 
+namespace {
+
+void copyTile(char *dest, const char *src, const tileMsg &tile)
+{
+    // decompressTile always yields 4 bytes per pixel
+    const size_t pixsize = 4;
+    const size_t linesize = pixsize * tile.width;
+    for (int y = tile.y; y < tile.y + tile.height; ++y) {
+        const size_t off = (size_t(y) * tile.totalwidth + tile.x) * pixsize;
+        memcpy(dest + off, src + off, linesize);
+    }
+}
+
+} // namespace
 
 DecodeTask::DecodeTask(std::shared_ptr<const RemoteRenderMessage> msg, std::shared_ptr<buffer> payload)
 : msg(msg), payload(payload), rgba(NULL), depth(NULL)
@@ -34,6 +49,17 @@ bool DecodeTask::work()
     }
 
     const auto &tile = static_cast<const tileMsg &>(msg->rhr());
+    char *dest = tile.format == rfbColorRGBA ? rgba : depth;
+    char *prev = tile.format == rfbColorRGBA ? prevRgba : prevDepth;
+
+    if (tile.flags & rfbTileUnchanged) {
+        if (!dest || !prev) {
+            CERR << "DecodeTask: no previous frame for unchanged tile" << std::endl;
+            return false;
+        }
+        copyTile(dest, prev, tile);
+        return true;
+    }
 
     if (tile.unzippedsize == 0) {
         CERR << "DecodeTask: no data, unzippedsize=" << tile.unzippedsize << std::endl;
@@ -88,8 +114,11 @@ bool DecodeTask::work()
             CERR << "DecodeTask: invalid data: unzipped size wrong: " << decompbuf.size() << " != " << tile.unzippedsize
                  << std::endl;
         }
-        return decompressTile(param.isDepth ? depth : rgba, decompbuf, param, tile.x, tile.y, tile.width, tile.height,
-                              tile.totalwidth);
+        bool ok = decompressTile(param.isDepth ? depth : rgba, decompbuf, param, tile.x, tile.y, tile.width,
+                                 tile.height, tile.totalwidth);
+        if (ok && dest && prev)
+            copyTile(prev, dest, tile);
+        return ok;
     } catch (vistle::message::codec_error &ex) {
         CERR << "DecodeTask: codec error: " << ex.what() << ", info: " << ex.info() << std::endl;
         return false;
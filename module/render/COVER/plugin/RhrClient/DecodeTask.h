@@ -27,5 +27,6 @@ struct DecodeTask {
     std::shared_ptr<vistle::buffer> payload;
     std::shared_ptr<opencover::MultiChannelDrawer::ViewData> viewData;
     char *rgba = nullptr, *depth = nullptr;
+    char *prevRgba = nullptr, *prevDepth = nullptr; //!< copy of previous frame, for tiles sent as unchanged
 };
 #endif
@@ -20,6 +20,7 @@
 #include <vistle/util/listenv4v6.h>
 #include <vistle/util/enum.h>
 #include <vistle/util/threadname.h>
+#include <vistle/util/stopwatch.h>
 
 #include <osg/io_utils>
 
@@ -55,6 +56,41 @@ DEFINE_ENUM_WITH_STRING_CONVERSIONS(MpiTags,
 )
 // clang-format on
 
+namespace {
+
+//! tile covers same part of same image
+bool samePosition(const tileMsg &a, const tileMsg &b)
+{
+    return a.viewNum == b.viewNum && a.eye == b.eye && a.x == b.x && a.y == b.y && a.width == b.width &&
+           a.height == b.height && a.totalwidth == b.totalwidth && a.totalheight == b.totalheight &&
+           (a.format == rfbColorRGBA) == (b.format == rfbColorRGBA);
+}
+
+//! whether the content of a tile from a discarded frame has to be passed on to tile of a later frame
+bool needsCarryOver(const tileMsg &discarded, const tileMsg &later)
+{
+    if (discarded.width == 0 || discarded.height == 0 || (discarded.flags & rfbTileUnchanged))
+        return false;
+    return (later.flags & rfbTileUnchanged) && samePosition(discarded, later);
+}
+
+//! replace reference to previous frame by content of tile from a discarded frame
+void carryOver(RemoteRenderMessage &later, const RemoteRenderMessage &discarded)
+{
+    auto &tile = static_cast<tileMsg &>(later.rhr());
+    const auto &src = static_cast<const tileMsg &>(discarded.rhr());
+    tile.flags &= ~rfbTileUnchanged;
+    tile.format = src.format;
+    tile.compression = src.compression;
+    tile.size = src.size;
+    tile.unzippedsize = src.unzippedsize;
+    later.setPayloadSize(discarded.payloadSize());
+    later.setPayloadRawSize(discarded.payloadRawSize());
+    later.setPayloadCompression(discarded.payloadCompression());
+}
+
+} // namespace
+
 int RemoteConnection::numViewsForMode(RemoteConnection::GeometryMode mode)
 {
     switch (mode) {
@@ -751,8 +787,29 @@ bool RemoteConnection::handleTile(const RemoteRenderMessage &msg, const tileMsg
         return true;
     }
 
-    assert(payload);
+    if (!payload) {
+        // tiles without content, e.g. references to unchanged tiles
+        payload = std::make_shared<buffer>();
+    }
     assert(payload->size() == msg.payloadSize());
+
+    if (tile.flags & rfbTileFirst) {
+        m_ackTiles = 0;
+        m_ackBytes = 0;
+        m_ackFirstTime = vistle::Clock::time();
+    }
+    ++m_ackTiles;
+    m_ackBytes += msg.payloadSize();
+    if ((tile.flags & rfbTileLast) && (tile.flags & rfbTileRequestAck)) {
+        // let server adapt quality to bandwidth as early as possible, before decoding
+        tileAckMsg ack;
+        ack.frameNumber = tile.frameNumber;
+        ack.tiles = m_ackTiles;
+        ack.bytes = m_ackBytes;
+        ack.receiveTime = vistle::Clock::time() - m_ackFirstTime;
+        send(ack);
+    }
+
     auto m = std::make_shared<RemoteRenderMessage>(msg);
     if (m_handleTilesAsync) {
         m_receivedTiles.push_back(TileMessage(m, payload));
@@ -852,7 +909,7 @@ void RemoteConnection::handleTileMeta(const RemoteRenderMessage &remote, const t
         viewIdx -= m_channelBase;
     }
     if (viewIdx < 0 || viewIdx >= m_numViews) {
-        if (!msg.flags)
+        if (!(msg.flags & ~rfbTileUnchanged))
             CERR << "reject tile with viewIdx=" << viewIdx << ", base=" << m_channelBase << ", numViews=" << m_numViews
                  << std::endl;
         return;
@@ -1107,7 +1164,7 @@ void RemoteConnection::enqueueTask(std::shared_ptr<DecodeTask> task)
     }
 
     if (view < 0 || view >= m_numViews) {
-        if (!tile.flags) {
+        if (!(tile.flags & ~rfbTileUnchanged)) {
             CERR << "NO FB for view " << view << std::endl;
         }
         task->rgba = NULL;
@@ -1122,6 +1179,20 @@ void RemoteConnection::enqueueTask(std::shared_ptr<DecodeTask> task)
             task->depth = reinterpret_cast<char *>(m_drawer->depth(view));
         }
 
+        if (size_t(view) >= m_previousFrames.size())
+            m_previousFrames.resize(view + 1);
+        auto &prev = m_previousFrames[view];
+        if (prev.width != tile.totalwidth || prev.height != tile.totalheight) {
+            // no tasks for this view are running, as all tiles of a frame have the same size
+            prev.width = tile.totalwidth;
+            prev.height = tile.totalheight;
+            const size_t size = size_t(prev.width) * prev.height * 4;
+            prev.rgba.assign(size, 0);
+            prev.depth.assign(size, 0);
+        }
+        task->prevRgba = prev.rgba.data();
+        task->prevDepth = prev.depth.data();
+
         switch (tile.eye) {
         case rfbEyeMiddle:
             m_drawer->setViewEye(view, Middle);
@@ -1185,7 +1256,7 @@ bool RemoteConnection::handleTileMessage(std::shared_ptr<const message::RemoteRe
          << ", req: " << tile.requestNumber << std::endl;
 #endif
 
-    if (tile.flags) {
+    if (tile.flags & ~rfbTileUnchanged) {
         // meta data for tiles with flags has to be processed on master and all slaves
     } else if (m_geoMode == Screen && m_visibleViews == MultiChannelDrawer::Same) {
         // ignore tiles for other nodes
@@ -1285,6 +1356,18 @@ bool RemoteConnection::updateTileQueue()
                 ++m_remoteSkipped;
                 ++m_remoteSkippedPerFrame;
             }
+            for (auto &later: m_queuedTasks) {
+                const auto &lt = static_cast<const tileMsg &>(later->msg->rhr());
+                if (samePosition(tile, lt)) {
+                    if (needsCarryOver(tile, lt)) {
+                        auto msg = std::make_shared<RemoteRenderMessage>(*later->msg);
+                        carryOver(*msg, *dt->msg);
+                        later->msg = msg;
+                        later->payload = dt->payload;
+                    }
+                    break;
+                }
+            }
         } else {
             //CERR << "quueing from updateTaskQueue" << std::endl;
             enqueueTask(dt);
@@ -1484,7 +1567,7 @@ void RemoteConnection::processMessages()
                             TileMessage &tile = m_receivedTiles[i];
                             forSlave[s][i] = false;
                             //CERR << "ntiles=" << ntiles << ", have=" << m_receivedTiles.size() << ", i=" << i << std::endl;
-                            if (tile.tile.flags) {
+                            if (tile.tile.flags & ~rfbTileUnchanged) {
                             } else if (m_visibleViews == MultiChannelDrawer::All) {
                             } else if (m_visibleViews == MultiChannelDrawer::Same) {
                                 if (tile.tile.viewNum < channelBase || tile.tile.viewNum >= channelBase + numChannels)
@@ -1606,8 +1689,19 @@ void RemoteConnection::skipFrames()
     while (m_lastTileAt.size() > 1) {
         unsigned ntiles = m_lastTileAt.front();
         m_lastTileAt.pop_front();
-        for (unsigned i = 0; i < ntiles; ++i)
+        for (unsigned i = 0; i < ntiles; ++i) {
+            auto &discarded = m_receivedTiles.front();
+            for (auto it = m_receivedTiles.begin() + (ntiles - i); it != m_receivedTiles.end(); ++it) {
+                if (samePosition(discarded.tile, it->tile)) {
+                    if (needsCarryOver(discarded.tile, it->tile)) {
+                        carryOver(*it->msg, *discarded.msg);
+                        it->payload = discarded.payload;
+                    }
+                    break;
+                }
+            }
             m_receivedTiles.pop_front();
+        }
         for (auto &t: m_lastTileAt) {
             t -= ntiles;
             assert(t <= m_receivedTiles.size());
@@ -1700,7 +1794,7 @@ bool RemoteConnection::distributeAndHandleTileMpi(std::shared_ptr<RemoteRenderMe
         int tag = TagTileAll;
         auto comm = m_comm.get();
         auto &tile = static_cast<tileMsg &>(msg->rhr());
-        if (m_geoMode == Screen && !tile.flags) {
+        if (m_geoMode == Screen && !(tile.flags & ~rfbTileUnchanged)) {
             if (m_visibleViews == MultiChannelDrawer::MatchingEye) {
                 if (tile.eye == rfbEyeMiddle) {
                     tag = TagTileMiddle;
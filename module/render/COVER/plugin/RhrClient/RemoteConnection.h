@@ -78,6 +78,9 @@ public:
     bool m_initialized = false;
     std::deque<TileMessage> m_receivedTiles;
     std::deque<size_t> m_lastTileAt;
+    unsigned m_ackTiles = 0; //!< tiles received for current frame
+    uint64_t m_ackBytes = 0;
+    double m_ackFirstTime = 0.;
     std::map<std::string, vistle::RenderObject::InitialVariantVisibility> m_variantsToAdd;
     std::set<std::string> m_variantsToRemove;
     std::map<std::string, std::shared_ptr<VariantRenderObject>> m_variants;
@@ -196,6 +199,13 @@ public:
     TaskQueue m_queuedTasks, m_finishedTasks;
     std::set<std::shared_ptr<DecodeTask>> m_runningTasks;
 
+    //! last decoded frame of a view, for tiles that the server sends as unchanged
+    struct PreviousFrame {
+        int width = 0, height = 0;
+        std::vector<char> rgba, depth;
+    };
+    std::vector<PreviousFrame> m_previousFrames;
+
     bool checkSwapFrame();
     void swapFrame();
     void checkDiscardFrame();
@@ -0,0 +1,163 @@
+#include <sstream>
+#include <random>
+#include <chrono>
+
+#include <boost/mpi/collectives/all_gather.hpp>
+#include <boost/mpi/collectives/all_reduce.hpp>
+#include <boost/mpi/collectives/all_to_all.hpp>
+#include <boost/mpi/collectives/broadcast.hpp>
+#include <boost/mpi/nonblocking.hpp>
+#include <boost/mpi/packed_iarchive.hpp>
+#include <boost/mpi/packed_oarchive.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <vistle/module/module.h>
+
+using namespace vistle;
+
+// compare migration of particle state by per-rank broadcast (as formerly done by Tracer)
+// to point-to-point exchange with only those ranks that might continue tracing
+class MigrationBenchmark: public vistle::Module {
+public:
+    MigrationBenchmark(const std::string &name, int moduleID, mpi::communicator comm);
+    ~MigrationBenchmark() override;
+
+private:
+    bool prepare() override;
+
+    double broadcastExchange(const std::vector<std::vector<Index>> &dest);
+    double pointToPointExchange(const std::vector<std::vector<Index>> &dest);
+
+    IntParameter *m_numParticles;
+    IntParameter *m_stateSize;
+    IntParameter *m_numCandidates;
+    IntParameter *m_numRounds;
+};
+
+MigrationBenchmark::MigrationBenchmark(const std::string &name, int moduleID, mpi::communicator comm)
+: Module(name, moduleID, comm)
+{
+    m_numParticles = addIntParameter("num_particles", "number of particles leaving each rank per round", 1000);
+    setParameterMinimum<Integer>(m_numParticles, 0);
+    m_stateSize = addIntParameter("state_size", "size of serialized particle state (bytes)", 160);
+    setParameterMinimum<Integer>(m_stateSize, 1);
+    m_numCandidates =
+        addIntParameter("num_candidates", "number of ranks a particle is offered to in point-to-point mode", 2);
+    setParameterMinimum<Integer>(m_numCandidates, 1);
+    m_numRounds = addIntParameter("num_rounds", "number of exchange rounds", 10);
+    setParameterMinimum<Integer>(m_numRounds, 1);
+}
+
+MigrationBenchmark::~MigrationBenchmark() = default;
+
+double MigrationBenchmark::broadcastExchange(const std::vector<std::vector<Index>> &dest)
+{
+    const Index stateSize = m_stateSize->getValue();
+    std::vector<char> state(stateSize);
+
+    comm().barrier();
+    auto start = std::chrono::steady_clock::now();
+    Index num_send = dest.size();
+    std::vector<Index> num_transmit(size());
+    mpi::all_gather(comm(), num_send, num_transmit);
+    for (int r = 0; r < size(); ++r) {
+        for (Index i = 0; i < num_transmit[r]; ++i) {
+            mpi::broadcast(comm(), state, r);
+            // every rank searches for the particle and agrees on where to continue
+            int found = r;
+            found = mpi::all_reduce(comm(), found, mpi::maximum<int>());
+        }
+    }
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+    return dur.count();
+}
+
+double MigrationBenchmark::pointToPointExchange(const std::vector<std::vector<Index>> &dest)
+{
+    const Index stateSize = m_stateSize->getValue();
+    std::vector<char> state(stateSize);
+
+    comm().barrier();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Index> numOffered(size()), numReceived(size());
+    for (auto &d: dest) {
+        for (auto r: d)
+            ++numOffered[r];
+    }
+    mpi::all_to_all(comm(), numOffered, numReceived);
+
+    std::vector<std::shared_ptr<mpi::packed_oarchive>> archives(size());
+    for (int r = 0; r < size(); ++r) {
+        if (numOffered[r] > 0)
+            archives[r] = std::make_shared<mpi::packed_oarchive>(comm());
+    }
+    for (auto &d: dest) {
+        for (auto r: d)
+            *archives[r] << state;
+    }
+    std::vector<mpi::request> requests;
+    for (int r = 0; r < size(); ++r) {
+        if (archives[r])
+            requests.emplace_back(comm().isend(r, 0, *archives[r]));
+    }
+
+    std::vector<std::vector<char>> found(size());
+    for (int r = 0; r < size(); ++r) {
+        if (numReceived[r] == 0)
+            continue;
+        mpi::packed_iarchive ar(comm());
+        comm().recv(r, 0, ar);
+        for (Index i = 0; i < numReceived[r]; ++i)
+            ar >> state;
+        found[r].resize(numReceived[r], 1);
+        requests.emplace_back(comm().isend(r, 1, found[r]));
+    }
+    for (int r = 0; r < size(); ++r) {
+        if (numOffered[r] == 0)
+            continue;
+        std::vector<char> f;
+        comm().recv(r, 1, f);
+    }
+    mpi::wait_all(requests.begin(), requests.end());
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+    return dur.count();
+}
+
+bool MigrationBenchmark::prepare()
+{
+    if (size() < 2) {
+        if (rank() == 0)
+            sendInfo("needs at least 2 ranks");
+        return true;
+    }
+
+    std::mt19937 gen(rank());
+    std::uniform_int_distribution<int> dist(1, size() - 1);
+    const int numCandidates = std::min<int>(m_numCandidates->getValue(), size() - 1);
+
+    double tBroadcast = 0., tPointToPoint = 0.;
+    for (Integer round = 0; round < m_numRounds->getValue(); ++round) {
+        std::vector<std::vector<Index>> dest(m_numParticles->getValue());
+        for (auto &d: dest) {
+            int first = dist(gen);
+            for (int c = 0; c < numCandidates; ++c)
+                d.push_back((rank() + first + c) % size());
+        }
+        tBroadcast += broadcastExchange(dest);
+        tPointToPoint += pointToPointExchange(dest);
+    }
+    tBroadcast = mpi::all_reduce(comm(), tBroadcast, mpi::maximum<double>());
+    tPointToPoint = mpi::all_reduce(comm(), tPointToPoint, mpi::maximum<double>());
+
+    if (rank() == 0) {
+        std::stringstream str;
+        str << size() << " ranks, " << m_numParticles->getValue() << " particles/rank, "
+            << m_stateSize->getValue() << " bytes/particle, " << m_numRounds->getValue() << " rounds: "
+            << "broadcast " << tBroadcast << " s, point-to-point " << tPointToPoint << " s";
+        sendInfo("%s", str.str().c_str());
+    }
+
+    return true;
+}
+
+MODULE_MAIN(MigrationBenchmark)
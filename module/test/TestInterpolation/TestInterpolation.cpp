@@ -132,6 +132,8 @@ bool TestInterpolation::compute()
 
     Index numChecked = 0;
     Scalar squaredError = 0;
+    std::vector<Index> cells;
+    std::vector<Scalar> points[3], recons[3];
     for (Index i = 0; i < count; ++i) {
         Vector3 point(randpoint(min, max));
         Index idx = grid->findCell(point);
@@ -144,11 +146,36 @@ bool TestInterpolation::compute()
                 std::cerr << "point: " << point.transpose() << ", recons: " << p.transpose() << std::endl;
             }
             squaredError += d2;
+
+            cells.push_back(idx);
+            for (int c = 0; c < 3; ++c) {
+                points[c].push_back(point[c]);
+                recons[c].push_back(p[c]);
+            }
+        }
+    }
+
+    // batched interpolation has to agree with interpolation point by point
+    std::vector<Scalar> batched[3];
+    for (int c = 0; c < 3; ++c)
+        batched[c].resize(cells.size());
+    const Scalar *coords[3] = {points[0].data(), points[1].data(), points[2].data()};
+    const Scalar *field[3] = {x, y, z};
+    Scalar *out[3] = {batched[0].data(), batched[1].data(), batched[2].data()};
+    grid->interpolate(cells.size(), cells.data(), coords, 3, field, out, DataBase::Vertex, mode);
+    Index numMismatch = 0;
+    for (size_t i = 0; i < cells.size(); ++i) {
+        Vector3 p(recons[0][i], recons[1][i], recons[2][i]);
+        Vector3 b(batched[0][i], batched[1][i], batched[2][i]);
+        if ((p - b).squaredNorm() > 1e-6) {
+            ++numMismatch;
+            std::cerr << "batched: " << b.transpose() << ", single: " << p.transpose() << std::endl;
         }
     }
+
     std::cerr << "block " << grid->object()->getBlock() << ", bounds: min " << min.transpose() << ", max "
               << max.transpose() << ", checked: " << numChecked << ", avg error: " << squaredError / numChecked
-              << std::endl;
+              << ", batched mismatches: " << numMismatch << std::endl;
 
     return true;
 }
@@ -48,6 +48,7 @@ int main()
             M(CANCELEXECUTE, CancelExecute)
             M(ADDOBJECT, AddObject)
             M(ADDOBJECTCOMPLETED, AddObjectCompleted)
+            M(ADDOBJECTS, AddObjects)
             M(DATATRANSFERSTATE, DataTransferState)
             M(ADDPORT, AddPort)
             M(REMOVEPORT, AddPort)
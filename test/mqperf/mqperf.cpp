@@ -0,0 +1,119 @@
+// compare throughput and latency of vistle::message::MessageQueue and boost::interprocess::message_queue
+// between two processes
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <vistle/util/boost_interprocess_config.h>
+#include <boost/interprocess/ipc/message_queue.hpp>
+
+#include <vistle/core/message.h>
+#include <vistle/core/messagequeue.h>
+
+using namespace vistle;
+namespace interprocess = boost::interprocess;
+
+typedef std::chrono::steady_clock Clock;
+
+const size_t BoostQueueDepth = 10; // as used by vistle before
+
+struct VistleQueue {
+    std::unique_ptr<message::MessageQueue> mq;
+
+    static void remove(const std::string &name) { message::MessageQueue::remove(name); }
+    void create(const std::string &name, size_t depth) { mq.reset(message::MessageQueue::create(name, depth)); }
+    void open(const std::string &name) { mq.reset(message::MessageQueue::open(name)); }
+    void send(const message::Buffer &buf) { mq->send(buf); }
+    void receive(message::Buffer &buf) { mq->receive(buf); }
+};
+
+struct BoostQueue {
+    std::unique_ptr<interprocess::message_queue> mq;
+
+    static void remove(const std::string &name) { interprocess::message_queue::remove(name.c_str()); }
+    void create(const std::string &name, size_t depth)
+    {
+        mq.reset(new interprocess::message_queue(interprocess::create_only, name.c_str(), depth,
+                                                 message::Message::MESSAGE_SIZE));
+    }
+    void open(const std::string &name) { mq.reset(new interprocess::message_queue(interprocess::open_only, name.c_str())); }
+    void send(const message::Buffer &buf) { mq->send(buf.data(), message::Message::MESSAGE_SIZE, 0); }
+    void receive(message::Buffer &buf)
+    {
+        size_t size = 0;
+        unsigned prio = 0;
+        mq->receive(buf.data(), message::Message::MESSAGE_SIZE, size, prio);
+    }
+};
+
+template<class Queue>
+void run(const std::string &label, size_t depth, size_t count)
+{
+    const std::string prefix = "vistle_mqperf_" + std::to_string(getpid()) + "_";
+    const std::string there = prefix + "send_q", back = prefix + "recv_q";
+    Queue::remove(there);
+    Queue::remove(back);
+
+    Queue toChild, toParent;
+    toChild.create(there, depth);
+    toParent.create(back, depth);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        Queue in, out;
+        in.open(there);
+        out.open(back);
+        message::Buffer buf;
+        // throughput: receive stream, then acknowledge
+        for (size_t i = 0; i < count; ++i)
+            in.receive(buf);
+        out.send(buf);
+        // latency: echo
+        for (size_t i = 0; i < count; ++i) {
+            in.receive(buf);
+            out.send(buf);
+        }
+        _exit(0);
+    }
+
+    message::Buffer buf;
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i)
+        toChild.send(buf);
+    toParent.receive(buf);
+    double stream = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        toChild.send(buf);
+        toParent.receive(buf);
+    }
+    double pingpong = std::chrono::duration<double>(Clock::now() - start).count();
+
+    waitpid(pid, nullptr, 0);
+    Queue::remove(there);
+    Queue::remove(back);
+
+    std::cout << label << " (depth " << depth << "): " << count / stream << " msgs/s, "
+              << pingpong / count * 0.5e6 << " us latency" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = 100000;
+    if (argc > 1)
+        count = std::atol(argv[1]);
+
+    run<BoostQueue>("boost::interprocess::message_queue", BoostQueueDepth, count);
+    run<VistleQueue>("vistle::message::MessageQueue", BoostQueueDepth, count);
+    run<VistleQueue>("vistle::message::MessageQueue", message::MessageQueue::DefaultCapacity, count);
+
+    return 0;
+}
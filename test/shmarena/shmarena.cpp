@@ -0,0 +1,169 @@
+// check size classes of the shared memory arena and blocks travelling between threads
+
+#include <vistle/util/boost_interprocess_config.h>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <vistle/core/shm.h>
+#include <vistle/core/shm_arena.h>
+
+namespace bi = boost::interprocess;
+
+using namespace vistle;
+
+namespace {
+
+std::atomic<int> errors(0);
+
+void check(bool ok, const std::string &what)
+{
+    if (!ok) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++errors;
+    }
+}
+
+void checkSizeClasses()
+{
+    for (unsigned cls = 0; cls < ShmArena::NumClasses; ++cls) {
+        const size_t size = ShmArena::classSize(cls);
+        check(ShmArena::sizeClass(size) == cls, "sizeClass(classSize(" + std::to_string(cls) + "))");
+        check(size % 16 == 0, "classSize(" + std::to_string(cls) + ") is a multiple of 16");
+        if (cls > 0)
+            check(ShmArena::classSize(cls - 1) < size, "classSize(" + std::to_string(cls) + ") is increasing");
+    }
+    check(ShmArena::classSize(0) == ShmArena::MinBlockSize, "smallest class has MinBlockSize");
+    check(ShmArena::classSize(ShmArena::NumClasses - 1) == ShmArena::MaxBlockSize, "largest class has MaxBlockSize");
+
+    for (size_t bytes = 1; bytes <= ShmArena::MaxBlockSize; ++bytes) {
+        const unsigned cls = ShmArena::sizeClass(bytes);
+        if (cls >= ShmArena::NumClasses) {
+            check(false, "sizeClass(" + std::to_string(bytes) + ") in range");
+            continue;
+        }
+        // smallest class that fits
+        if (ShmArena::classSize(cls) < bytes || (cls > 0 && ShmArena::classSize(cls - 1) >= bytes)) {
+            check(false, "sizeClass(" + std::to_string(bytes) + ") is the smallest class that fits");
+        }
+    }
+}
+
+typedef std::pair<unsigned char *, size_t> Block;
+
+// mostly small blocks spread over many size classes, and a few large allocations
+size_t blockSize(size_t i)
+{
+    if (i % 64 == 0)
+        return ShmArena::MaxBlockSize + i;
+    return 1 + (i * 7919) % (ShmArena::MaxBlockSize / 16);
+}
+
+void checkCrossThread(ShmArena *arena)
+{
+    const size_t NumBlocks = 2000;
+    const int NumThreads = 4;
+
+    arena->flushThreadCache();
+    const auto before = arena->statistics();
+
+    // allocate concurrently, so that thread caches and shared free lists are exercised
+    std::vector<std::vector<Block>> blocks(NumThreads);
+    std::vector<std::thread> producers;
+    for (int t = 0; t < NumThreads; ++t) {
+        producers.emplace_back([arena, t, &blocks]() {
+            for (size_t i = 0; i < NumBlocks; ++i) {
+                const size_t size = blockSize(i + t * NumBlocks);
+                auto p = static_cast<unsigned char *>(arena->allocate(size));
+                memset(p, t * 16 + i % 16, size);
+                blocks[t].emplace_back(p, size);
+            }
+            ShmArena::releaseThreadCache();
+        });
+    }
+    for (auto &t: producers)
+        t.join();
+
+    std::vector<Block> all;
+    for (auto &b: blocks)
+        all.insert(all.end(), b.begin(), b.end());
+    std::sort(all.begin(), all.end());
+    for (size_t i = 0; i + 1 < all.size(); ++i) {
+        if (all[i].first + all[i].second > all[i + 1].first) {
+            check(false, "live blocks do not overlap");
+            break;
+        }
+    }
+
+    // free each block on another thread than the one that allocated it
+    std::vector<std::thread> consumers;
+    for (int t = 0; t < NumThreads; ++t) {
+        consumers.emplace_back([arena, t, &blocks]() {
+            const int src = (t + 1) % NumThreads;
+            bool intact = true;
+            for (size_t i = 0; i < blocks[src].size(); ++i) {
+                const auto &b = blocks[src][i];
+                const unsigned char v = src * 16 + i % 16;
+                for (size_t j = 0; j < b.second; ++j) {
+                    if (b.first[j] != v) {
+                        intact = false;
+                        break;
+                    }
+                }
+                arena->deallocate(b.first, b.second);
+            }
+            check(intact, "contents survive hand-over to thread " + std::to_string(t));
+            ShmArena::releaseThreadCache();
+        });
+    }
+    for (auto &t: consumers)
+        t.join();
+
+    auto after = arena->statistics();
+    check(after.allocated == before.allocated, "all blocks accounted as freed");
+    check(after.requested == before.requested, "all requested bytes accounted as freed");
+    check(after.large == before.large, "all large allocations returned");
+    std::cerr << "after first round: " << after << std::endl;
+
+    // blocks returned by other threads are reused instead of carving new chunks
+    const size_t chunks = after.chunks;
+    std::vector<Block> again;
+    for (size_t i = 0; i < NumBlocks; ++i) {
+        const size_t size = blockSize(i);
+        again.emplace_back(static_cast<unsigned char *>(arena->allocate(size)), size);
+    }
+    check(arena->statistics().chunks == chunks, "freed blocks are reused");
+    for (auto &b: again)
+        arena->deallocate(b.first, b.second);
+    arena->flushThreadCache();
+}
+
+} // namespace
+
+int main()
+{
+    std::string shmname = "vistle_shmarena";
+
+    checkSizeClasses();
+
+    bi::shared_memory_object::remove(shmname.c_str());
+    vistle::Shm::create(shmname, 1, 0, true);
+
+    checkCrossThread(Shm::the().arena());
+
+    vistle::Shm::remove(shmname, 1, 0, true);
+
+    if (errors > 0) {
+        std::cerr << errors << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cerr << "all checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,237 @@
+// compare streaming bandwidth and TLB misses for shared memory arrays with and without huge pages
+// and with different NUMA placements of recycled memory
+
+#include <vistle/util/boost_interprocess_config.h>
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+
+#include <vistle/core/shm.h>
+#include <vistle/core/shm_array.h>
+#include <vistle/core/shm_array_impl.h>
+#include <vistle/core/shm_impl.h>
+#include <vistle/util/affinity.h>
+#include <vistle/util/stopwatch.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/sysinfo.h>
+#include <unistd.h>
+#endif
+
+namespace bi = boost::interprocess;
+
+using namespace vistle;
+
+typedef float DataType;
+typedef shm<DataType>::array Array;
+
+namespace {
+
+// data TLB misses of the calling thread, if performance counters are accessible
+class TlbCounter {
+public:
+    TlbCounter()
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~TlbCounter()
+    {
+#ifdef __linux__
+        if (m_fd >= 0)
+            close(m_fd);
+#endif
+    }
+
+    bool valid() const { return m_fd >= 0; }
+
+    void start()
+    {
+#ifdef __linux__
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    long long stop()
+    {
+        long long count = -1;
+#ifdef __linux__
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+                count = -1;
+        }
+#endif
+        return count;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+void pinToCpu(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+int lastCpu()
+{
+#ifdef __linux__
+    return get_nprocs_conf() - 1;
+#else
+    return 0;
+#endif
+}
+
+const char *placementName(MemoryPlacement placement)
+{
+    switch (placement) {
+    case MemoryPlacement::Default:
+        return "default";
+    case MemoryPlacement::FirstTouch:
+        return "firsttouch";
+    case MemoryPlacement::Local:
+        return "local";
+    }
+    return "?";
+}
+
+Array *createArray(const std::string &name, size_t size)
+{
+    Array *arr = Shm::the().shm().construct<Array>(name.c_str())(0, Shm::the().allocator());
+    arr->reserve(size);
+    return arr;
+}
+
+void destroyArray(const std::string &name)
+{
+    Shm::the().shm().destroy<Array>(name.c_str());
+}
+
+void measure(size_t size, bool huge, MemoryPlacement placement, int runs)
+{
+    const double GB = 1e9;
+    const double bytes = size * sizeof(DataType);
+
+    // let a thread on another CPU touch the memory first, as a module on another socket would have done
+    ShmArena::setPlacement(MemoryPlacement::Default);
+    {
+        Array *prev = createArray("shmnuma_prev", size);
+        advise_huge_pages(prev->data(), bytes, huge);
+        std::thread remote([prev, size]() {
+            pinToCpu(lastCpu());
+            DataType *p = prev->data();
+            for (size_t i = 0; i < size; ++i)
+                p[i] = DataType(i);
+        });
+        remote.join();
+        destroyArray("shmnuma_prev");
+    }
+
+    // recycled memory is handed out again
+    ShmArena::setPlacement(placement);
+    Array *arr = createArray("shmnuma", size);
+    advise_huge_pages(arr->data(), bytes, huge);
+    DataType *p = arr->data();
+
+    TlbCounter tlb;
+    double start = Clock::time();
+    for (size_t i = 0; i < size; ++i)
+        p[i] = DataType(i & 0xff);
+    const double write = Clock::time() - start;
+
+    double read = std::numeric_limits<double>::max();
+    long long misses = -1;
+    DataType sum = 0;
+    for (int r = 0; r < runs; ++r) {
+        tlb.start();
+        start = Clock::time();
+        DataType s = 0;
+        for (size_t i = 0; i < size; ++i)
+            s += p[i];
+        const double dur = Clock::time() - start;
+        const long long m = tlb.stop();
+        sum += s;
+        if (dur < read) {
+            read = dur;
+            misses = m;
+        }
+    }
+
+    std::cout << std::setw(6) << (huge ? "huge" : "base") << std::setw(12) << placementName(placement)
+              << std::setw(14) << bytes / write / GB << std::setw(14) << bytes / read / GB << std::setw(18);
+    if (misses >= 0)
+        std::cout << misses / (bytes / (1024. * 1024.));
+    else
+        std::cout << "n/a";
+    std::cout << "    (" << sum << ")" << std::endl;
+
+    destroyArray("shmnuma");
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string shmname = "vistle_shmnuma";
+
+    int shift = 28;
+    if (argc > 1) {
+        shift = atoi(argv[1]);
+    }
+    int runs = 3;
+    if (argc > 2) {
+        runs = atoi(argv[2]);
+    }
+    const size_t size = size_t(1) << shift;
+
+    pinToCpu(0);
+
+    bi::shared_memory_object::remove(shmname.c_str());
+    vistle::Shm::create(shmname, 1, 0, true);
+
+    std::cout << size * sizeof(DataType) / (1024 * 1024) << " MiB, writer on CPU " << lastCpu()
+              << ", reader on CPU 0" << std::endl;
+    std::cout << std::setw(6) << "pages" << std::setw(12) << "placement" << std::setw(14) << "write GB/s"
+              << std::setw(14) << "read GB/s" << std::setw(18) << "dTLB misses/MiB" << std::endl;
+    for (bool huge: {false, true}) {
+        for (auto placement: {MemoryPlacement::Default, MemoryPlacement::FirstTouch, MemoryPlacement::Local}) {
+            measure(size, huge, placement, runs);
+        }
+    }
+
+    vistle::Shm::remove(shmname, 1, 0, true);
+
+    return 0;
+}